@@ -2,7 +2,9 @@
 #define _J_FILE_SYSTEM_H_
 
 #include "zfsystem.h"
+#include <list>
 #include <string>
+#include <time.h>
 using zip_file_system::filesystem;
 using zip_file_system::izfstream;
 using namespace std;
@@ -19,11 +21,20 @@ using namespace std;
 ///
 //////////////////////////////////////////////////////////////////////////
 
+//Random number of files kept in the zip cache.
+// An average filepath (in Wagic) for image is 37 characters, the entries stay in the mapped central directory
+// and only their offsets are kept in memory, so 4500 files is an "ok" size for the PSP
+#if defined (PSP)
+#define ZIP_CACHE_MAX_ELEMENTS 4500
+#else
+#define ZIP_CACHE_MAX_ELEMENTS 100000
+#endif
+
 class JZipCache {
 public:
   JZipCache();
   ~JZipCache();
-  map<string, filesystem::limited_file_info> dir;
+  zip_file_system::mapped_zip archive;
   
 };
 
@@ -40,9 +51,12 @@ private:
     int mFileSize;
 	char *mPassword;
 	bool mZipAvailable;
-  	void preloadZip(const string& filename);
-	izfstream mZipFile;
-    filesystem::limited_file_info * mCurrentFileInZip;
+  	JZipCache * preloadZip(const string& filename);
+    list<string> mZipCacheOrder; //most recently used first
+    zip_file_system::mapped_zip * mCurrentZip;
+    const zip_file_system::mapped_zip::entry * mCurrentFileInZip;
+    size_t mZipReadPos;
+    std::vector<char> mZipInflated; //whole file, for sequential reads of deflated entries
 
     std::vector<std::string>& scanRealFolder(const std::string& folderName, std::vector<std::string>& results);
 
@@ -132,6 +146,9 @@ public:
     //Returns true if strFilename exists somewhere in the fileSystem
     bool FileExists(const string& strFilename);
 
+    //Returns the modification time of strFilename if it is a real file, 0 if it is in a zip or doesn't exist
+    time_t GetLastModified(const string& strFilename);
+
     //Returns true if strdirname exists somewhere in the fileSystem, and is a directory
     bool DirExists(const string& strDirname);
 
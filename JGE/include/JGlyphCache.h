@@ -0,0 +1,209 @@
+//-------------------------------------------------------------------------------------
+//
+// JGE++ is a hardware accelerated 2D game SDK for PSP/Windows.
+//
+// Licensed under the BSD license, see LICENSE in JGE root for details.
+//
+//-------------------------------------------------------------------------------------
+
+#ifndef _JGLYPHCACHE_H
+#define _JGLYPHCACHE_H
+
+#include <vector>
+
+#include "JTypes.h"
+
+
+//////////////////////////////////////////////////////////////////////////
+/// Slot allocator for glyph caches. Maps a character code to one of a
+/// fixed number of slots of a glyph texture, with hashed O(1) lookup and
+/// least-recently-used replacement once all slots are taken.
+///
+/// The cache only manages slot numbers: the owner rasterizes the glyph
+/// into the slot returned by Insert() and keeps any per-slot data
+/// (quads, advances...) in its own arrays.
+///
+/// Hits and misses are counted for the current frame. Call NewFrame()
+/// once per frame to roll them over into the last-frame values.
+///
+//////////////////////////////////////////////////////////////////////////
+class JGlyphCache
+{
+public:
+	JGlyphCache(int capacity = 0) : mCapacity(0), mCount(0), mHead(-1), mTail(-1), mMask(0)
+	{
+		mHits = mMisses = mEvictions = 0;
+		mLastHits = mLastMisses = mLastEvictions = 0;
+		Reset(capacity);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	/// Drop all cached codes and set the number of available slots.
+	///
+	/// @param capacity - Number of slots.
+	///
+	//////////////////////////////////////////////////////////////////////////
+	void Reset(int capacity)
+	{
+		mCapacity = capacity > 0 ? capacity : 0;
+
+		int buckets = 16;
+		while (buckets < mCapacity * 2)
+			buckets <<= 1;
+		mMask = buckets - 1;
+
+		mBuckets.assign(buckets, -1);
+		mCodes.assign(mCapacity, 0);
+		mHashNext.assign(mCapacity, -1);
+		mPrev.assign(mCapacity, -1);
+		mNext.assign(mCapacity, -1);
+		mCount = 0;
+		mHead = mTail = -1;
+	}
+
+	void Clear()
+	{
+		Reset(mCapacity);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	/// Look up a code and mark it as most recently used.
+	///
+	/// @param code - Character code.
+	///
+	/// @return - Slot holding the code, or -1 if it is not cached.
+	///
+	//////////////////////////////////////////////////////////////////////////
+	int Find(u32 code)
+	{
+		for (int slot = mBuckets[Hash(code)]; slot != -1; slot = mHashNext[slot])
+		{
+			if (mCodes[slot] == code)
+			{
+				mHits++;
+				Touch(slot);
+				return slot;
+			}
+		}
+		return -1;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	/// Reserve a slot for a code which is not cached yet, and count it as a
+	/// miss. When the cache is full the least recently used code is evicted.
+	///
+	/// @param code - Character code.
+	///
+	/// @return - Slot to rasterize the glyph into, or -1 if there is none.
+	///
+	//////////////////////////////////////////////////////////////////////////
+	int Insert(u32 code)
+	{
+		mMisses++;
+		if (!mCapacity)
+			return -1;
+
+		int slot;
+		if (mCount < mCapacity)
+		{
+			slot = mCount++;
+		}
+		else
+		{
+			slot = mTail;
+			Unlink(slot);
+			Unhash(slot);
+			mEvictions++;
+		}
+
+		mCodes[slot] = code;
+		int bucket = Hash(code);
+		mHashNext[slot] = mBuckets[bucket];
+		mBuckets[bucket] = slot;
+		PushFront(slot);
+		return slot;
+	}
+
+	bool IsFull() const { return mCount >= mCapacity; }
+	int GetCapacity() const { return mCapacity; }
+	int GetCount() const { return mCount; }
+
+	void NewFrame()
+	{
+		mLastHits = mHits;
+		mLastMisses = mMisses;
+		mLastEvictions = mEvictions;
+		mHits = mMisses = mEvictions = 0;
+	}
+
+	unsigned int GetHits() const { return mLastHits; }
+	unsigned int GetMisses() const { return mLastMisses; }
+	unsigned int GetEvictions() const { return mLastEvictions; }
+
+private:
+	int Hash(u32 code) const
+	{
+		return (int)((code * 2654435761u) >> 16) & mMask;
+	}
+
+	void Touch(int slot)
+	{
+		if (slot == mHead)
+			return;
+		Unlink(slot);
+		PushFront(slot);
+	}
+
+	void PushFront(int slot)
+	{
+		mPrev[slot] = -1;
+		mNext[slot] = mHead;
+		if (mHead != -1)
+			mPrev[mHead] = slot;
+		mHead = slot;
+		if (mTail == -1)
+			mTail = slot;
+	}
+
+	void Unlink(int slot)
+	{
+		if (mPrev[slot] != -1)
+			mNext[mPrev[slot]] = mNext[slot];
+		else
+			mHead = mNext[slot];
+
+		if (mNext[slot] != -1)
+			mPrev[mNext[slot]] = mPrev[slot];
+		else
+			mTail = mPrev[slot];
+	}
+
+	void Unhash(int slot)
+	{
+		int* link = &mBuckets[Hash(mCodes[slot])];
+		while (*link != slot)
+			link = &mHashNext[*link];
+		*link = mHashNext[slot];
+	}
+
+	std::vector<int> mBuckets;
+	std::vector<u32> mCodes;
+	std::vector<int> mHashNext;
+	std::vector<int> mPrev;
+	std::vector<int> mNext;
+
+	int mCapacity;
+	int mCount;
+	int mHead;
+	int mTail;
+	int mMask;
+
+	unsigned int mHits;
+	unsigned int mMisses;
+	unsigned int mEvictions;
+	unsigned int mLastHits;
+	unsigned int mLastMisses;
+	unsigned int mLastEvictions;
+};
+
+#endif
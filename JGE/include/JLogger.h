@@ -7,8 +7,10 @@
 //The PSP one is to log stuff in JLogger's lastLog, it does not do full log in a text file unless DOLOG is defined
 #if defined(DOLOG) || defined (PSP)
 #define LOG(x) JLogger::Log(x);
+#define LOG_LEVEL(level, x) JLogger::Log(level, x);
 #else
 #define LOG(x) {};
+#define LOG_LEVEL(level, x) {};
 #endif
 
 // saving myself the pain of search/replace
@@ -16,16 +18,40 @@
 
 #define LOG_FILE "debug.txt"
 
+/*
+ With DOLOG, messages are copied into a fixed size ring buffer and written to LOG_FILE by a background
+ thread, so logging neither blocks on the file nor takes a lock: any thread can log.
+ Messages longer than a ring entry are truncated, and messages logged while the ring is full are dropped
+ (and counted in the log), which bounds the memory used whatever the log rate.
+ */
 class JLogger{
  public:
+  enum
+  {
+    LEVEL_DEBUG = 0,
+    LEVEL_INFO,
+    LEVEL_WARNING,
+    LEVEL_ERROR
+  };
+
   static void Log(const char * text);
   static void Log(std::string text);
+  static void Log(int level, const char * text);
+  static void Log(int level, const std::string& text);
+
+  // Messages below this level are ignored, LEVEL_DEBUG by default
+  static void SetLevel(int level);
+  // Name shown in front of the messages of the calling thread
+  static void SetThreadTag(const char * tag);
+  // Blocks until everything logged so far is written
+  static void Flush();
 
   JLogger(const char* text);
   ~JLogger();
 
   const char* mText;
 
+  // PSP only: the last message, shown on the exception screen
   static std::string lastLog;
   static int lastTime;
 };
@@ -7,6 +7,8 @@
 #include "JGE.h"
 #include <string>
 #include <map>
+#include <deque>
+#include <vector>
 using namespace std;
 class JSocket;
 #include <iostream>
@@ -15,6 +17,15 @@ class JSocket;
 
 typedef void(*processCmd)(void*, stringstream&, stringstream&);
 
+/*
+ Commands travel as binary frames:
+   u32 frame size (big endian, not counting these 4 bytes)
+   u16 command name size, command name
+   payload
+ The network thread sleeps in JSocket::Wait() until the socket has data, or sendCommand() wakes it up.
+ Incoming bytes land in a preallocated buffer and are split into frames in place; sendCommand() builds
+ each frame once, and the network thread writes it straight from the queue.
+ */
 class JNetwork {
 private:
 private:
@@ -25,15 +36,36 @@ private:
 		processCmd processCommand;
 	};
 
+  struct Frame {
+    string command;
+    string payload;
+  };
+
+  enum {
+    FRAME_HEADER_SIZE = 4,
+    RECEIVE_BUFFER_SIZE = 64 * 1024,
+    MAX_FRAME_SIZE = 16 * 1024 * 1024
+  };
+
   string serverIP;
   int connected_to_ap;
   JSocket* socket;
+  // socket of the established connection: socket itself for a client, the accepted one for a server
+  JSocket* connection;
   boost::mutex sendMutex;
   boost::mutex receiveMutex;
-  stringstream received;
-  stringstream toSend;
+  // frames waiting for the network thread, and the ones it is writing
+  deque<string> sendQueue;
+  deque<string> sending;
+  size_t sendOffset;
+  vector<char> receiveBuffer;
+  size_t receivedSize;
+  deque<Frame> received;
   static map<string, CommandStruc> sCommandMap;
 
+  bool receiveFrames(JSocket* pSocket);
+  bool sendFrames(JSocket* pSocket);
+
 public:
   JNetwork();
   ~JNetwork();
@@ -49,6 +81,9 @@ public:
 #endif
   bool sendCommand(const string& command, const string& payload = "", const string& suffix = "Request");
   static void registerCommand(string command, void* object, processCmd processRequest, processCmd processResponse);
+
+  unsigned long framesSent, framesReceived;
+  unsigned long bytesSent, bytesReceived;
 };
 
 #endif
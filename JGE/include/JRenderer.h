@@ -136,6 +136,23 @@ public:
 	//////////////////////////////////////////////////////////////////////////
 	JTexture* LoadTexture(const char* filename, int mode = 0, int textureFormat = TEXTURE_FORMAT);
 
+	//////////////////////////////////////////////////////////////////////////
+	/// Decode a texture from an image file already read into memory. The
+	/// pixels stay in the texture's CPU buffer until TransferTextureToGLContext.
+	///
+	/// Unlike LoadTexture, this doesn't go through JFileSystem, so several
+	/// worker threads may call it at the same time.
+	///
+	/// @param filename - Name of the file, only used to pick the decoder.
+	/// @param data - File contents.
+	/// @param size - Size of data in bytes.
+	///
+	/// @return - The texture, or NULL if decoding from memory isn't
+	///           supported for this format on this platform (use LoadTexture).
+	///
+	//////////////////////////////////////////////////////////////////////////
+	JTexture* LoadTextureFromMemory(const char* filename, u8* data, int size, int mode = 0, int textureFormat = TEXTURE_FORMAT);
+
     /*
     ** Helper function - on Win, LoadTexture previously performed the image transfer into GL memory.
     ** However, this doesn't work if you want to call LoadTexture in a separate worker thread, as 
@@ -566,6 +583,8 @@ private:
 
 #if (!defined IOS) && (!defined QT_CONFIG)
 	void LoadJPG(TextureInfo &textureInfo, const char *filename, int mode = 0, int TextureFormat = TEXTURE_FORMAT);
+	void DecodeJPG(TextureInfo &textureInfo, u8 *rawdata, int rawsize);
+	JTexture* CreateTextureFromInfo(TextureInfo &textureInfo);
 	int LoadPNG(TextureInfo &textureInfo, const char *filename, int mode = 0, int TextureFormat = TEXTURE_FORMAT);
 #if (!defined ANDROID) && (!defined QT_CONFIG)
 	void LoadGIF(TextureInfo &textureInfo, const char *filename, int mode = 0, int TextureFormat = TEXTURE_FORMAT);
@@ -34,6 +34,19 @@ public:
   bool isConnected() { return state == CONNECTED; };
   void Disconnect();
 
+  enum {
+    READABLE = 1,
+    WRITABLE = 2
+  };
+  // Blocks until the socket is readable (or writable, when asked), Wake() is called or the timeout expires.
+  // Returns the READABLE/WRITABLE flags of the socket.
+  int Wait(bool wantWrite, int timeoutMs);
+  // Interrupts Wait() from another thread
+  void Wake();
+  // Non blocking transfers: return the number of bytes transferred, 0 if it would block, -1 once disconnected.
+  int Receive(char* buff, int size);
+  int Send(const char* buff, int size);
+
 private:
   // socket state
   SOCKET_STATE state;
@@ -46,7 +59,11 @@ private:
   SOCKET mfd;
 #elif LINUX || PSP
   int mfd;
+  // self pipe waking up Wait()
+  int mWakeFds[2];
 #endif
+  // non blocking, no delay, and the wake up pipe for a connected socket
+  void SetupConnection();
 };
 
 #endif
@@ -12,11 +12,13 @@
 #define _JTTFONT_H
 
 #include "../../JGE/include/JGE.h"
+#include "../../JGE/include/JGlyphCache.h"
 
 #include <ft2build.h>
 #include <freetype/freetype.h>
 
-#define TTF_CACHE_SIZE		256
+#define TTF_CACHE_SIZE		1024
+#define TTF_MAX_CACHE_IMAGE	512
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -24,6 +26,9 @@
 /// a simple caching system so that a character which has been rendered before
 /// can be retrieved from the cache instead of drawing it again by the
 /// Freetype library. This can give you a much faster rendering speed.
+/// Cached characters are found through a hash and the least recently used
+/// one is replaced when the cache is full. If the cache texture is full it
+/// is first grown (up to 512x512) before anything gets replaced.
 /// Also, if you only need to use a limited number of characters
 /// in your game, you can actually cache all your characters in the cache  
 /// beforehand and unload the font to save memory.
@@ -251,6 +256,21 @@ public:
 
 	void SetAntialias(bool flag);
 
+	//////////////////////////////////////////////////////////////////////////
+	/// Start a new frame for the cache statistics.
+	///
+	//////////////////////////////////////////////////////////////////////////
+	void NewFrame();
+
+	//////////////////////////////////////////////////////////////////////////
+	/// Get cache statistics of the last frame.
+	///
+	/// @return hits - Characters found in the cache.
+	/// @return misses - Characters which had to be rendered by Freetype.
+	///
+	//////////////////////////////////////////////////////////////////////////
+	void GetCacheStats(unsigned int *hits, unsigned int *misses) const;
+
 protected:
 	FT_Library GetFontLibrary();
 	FT_Byte* GetFontBits();
@@ -265,16 +285,18 @@ private:
 
 	int PreCacheChar(u16 ch, u16 cachedCode);
 	int GetCachedChar(u16 cachedCode);
+	bool GrowCache();
+	void ResetCache();
 	void DrawBitmap(void *image, FT_Bitmap *bitmap, FT_Int x, FT_Int y, int width, int height);
 
 
 	JTexture* mTexture;
+	JTexture* mRetiredTexture;
 
 	JQuad* mQuads[TTF_CACHE_SIZE];
-	u16 mCachedCode[TTF_CACHE_SIZE];
 	u8 mXAdvance[TTF_CACHE_SIZE];
 	
-	int mCurr;
+	JGlyphCache mCache;
 
 	int mTexWidth;
 	int mTexHeight;
@@ -90,6 +90,64 @@ namespace boost
 
 
 
+    /**
+    ** Stand-in for boost::condition_variable, built on a counting semaphore.
+    ** Unlike boost's, notify_one() and notify_all() must be called with the waiters' mutex held.
+    */
+    class condition_variable
+    {
+    public:
+        condition_variable() : mWaiters(0)
+        {
+            mID = sceKernelCreateSema("Condition", 0, 0, 0x7FFFFFFF, 0);
+        }
+
+        ~condition_variable()
+        {
+            sceKernelDeleteSema(mID);
+        }
+
+        void wait(unique_lock<mutex>& inLock)
+        {
+            // mWaiters is protected by the caller's mutex; a notify slipping in between the unlock
+            // and the wait leaves the semaphore signaled, so it isn't lost
+            mWaiters++;
+            inLock.mMutex->unlock();
+            int result = sceKernelWaitSema(mID, 1, 0);
+            if (result < 0)
+            {
+                LOG("Semaphore error on condition wait, semaphore id: ");
+                LOG((char*)mID);
+            }
+            inLock.mMutex->lock();
+        }
+
+        void notify_one()
+        {
+            if (mWaiters > 0)
+            {
+                mWaiters--;
+                sceKernelSignalSema(mID, 1);
+            }
+        }
+
+        void notify_all()
+        {
+            if (mWaiters > 0)
+            {
+                sceKernelSignalSema(mID, mWaiters);
+                mWaiters = 0;
+            }
+        }
+
+    private:
+        int mID;
+        int mWaiters;
+
+        condition_variable(condition_variable const&);
+        condition_variable& operator=(condition_variable const&);
+    };
+
     class recursive_mutex
     {
     public:
@@ -266,6 +324,11 @@ namespace boost
             sceKernelTerminateDeleteThread(mThreadProcID);
         }
 
+        static unsigned int hardware_concurrency()
+        {
+            return 1;
+        }
+
     private:
 
         static int ThreadProc(SceSize args, void *inParam)
@@ -290,6 +353,35 @@ namespace boost
         SceUID mThreadProcID;
     };
 
+    /**
+    ** Stand-in for boost::thread_specific_ptr. Only the game thread uses thread local pointers on the PSP,
+    ** so a single slot is enough. As with the cleanup function form of boost's, the pointer is not owned.
+    */
+    template <class T>
+    class thread_specific_ptr
+    {
+    public:
+        thread_specific_ptr(void (*)(T*)) : mPointer(NULL)
+        {
+        }
+
+        T* get() const
+        {
+            return mPointer;
+        }
+
+        void reset(T* inPointer = NULL)
+        {
+            mPointer = inPointer;
+        }
+
+    private:
+        T* mPointer;
+
+        thread_specific_ptr(thread_specific_ptr const&);
+        thread_specific_ptr& operator=(thread_specific_ptr const&);
+    };
+
     namespace posix_time
     {
         typedef unsigned int milliseconds;
@@ -311,6 +403,8 @@ namespace boost
 
 #include <QMutex>
 #include <QThread>
+#include <QThreadStorage>
+#include <QWaitCondition>
 
 #include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
@@ -370,6 +464,31 @@ namespace boost
 
 
 
+    /**
+    ** Stand-in for boost::condition_variable.
+    */
+    class condition_variable
+    {
+    public:
+        void wait(unique_lock<mutex>& inLock)
+        {
+            mCondition.wait(&inLock.mMutex->mQMutex);
+        }
+
+        void notify_one()
+        {
+            mCondition.wakeOne();
+        }
+
+        void notify_all()
+        {
+            mCondition.wakeAll();
+        }
+
+    private:
+        QWaitCondition mCondition;
+    };
+
     class recursive_mutex
     {
     public:
@@ -510,6 +629,12 @@ namespace boost
           mpThread->terminate();
         }
 
+        static unsigned int hardware_concurrency()
+        {
+          int count = QThread::idealThreadCount();
+          return count > 0 ? count : 0;
+        }
+
     private:
         template<typename F>
         static inline detail::thread_data_ptr make_thread_info(F f)
@@ -521,6 +646,44 @@ namespace boost
         threadImpl* mpThread;
     };
 
+    /**
+    ** boost::thread_specific_ptr on top of QThreadStorage. The pointer is wrapped so that
+    ** QThreadStorage does not delete it: as with the cleanup function form of boost's, it is not owned.
+    */
+    template <class T>
+    class thread_specific_ptr
+    {
+        struct Slot
+        {
+            Slot() : mPointer(NULL)
+            {
+            }
+
+            T* mPointer;
+        };
+
+    public:
+        thread_specific_ptr(void (*)(T*))
+        {
+        }
+
+        T* get() const
+        {
+            return mStorage.hasLocalData() ? mStorage.localData().mPointer : NULL;
+        }
+
+        void reset(T* inPointer = NULL)
+        {
+            mStorage.localData().mPointer = inPointer;
+        }
+
+    private:
+        QThreadStorage<Slot> mStorage;
+
+        thread_specific_ptr(thread_specific_ptr const&);
+        thread_specific_ptr& operator=(thread_specific_ptr const&);
+    };
+
     namespace posix_time
     {
         typedef unsigned int milliseconds;
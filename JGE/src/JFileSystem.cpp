@@ -20,12 +20,14 @@ The content that users should not be touching.
 #include "../../include/PrecompiledHeader.h"
 #endif
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
 #ifdef WIN32
 #pragma warning(disable : 4786)
 #include <direct.h>
 #define MAKEDIR(name) _mkdir(name)
 #else
-#include <sys/stat.h>
 #define MAKEDIR(name) mkdir(name, 0777)
 #endif
 
@@ -41,43 +43,70 @@ JZipCache::JZipCache()
 
 JZipCache::~JZipCache()
 {
-    dir.clear();
+    archive.close();
 }
 
 void JFileSystem::Pause() 
 {
     filesystem::closeTempFiles();
+
+    //archives that could not be mapped hold a file handle
+    map<string,JZipCache *>::iterator it = mZipCache.begin();
+    while (it != mZipCache.end())
+    {
+        if (it->second->archive.is_open() && !it->second->archive.is_mapped())
+        {
+            if (mCurrentZip == &(it->second->archive))
+                DetachZipFile();
+            mZipCachedElementsCount -= it->second->archive.entries();
+            mZipCacheOrder.remove(it->first);
+            delete(it->second);
+            mZipCache.erase(it++);
+        }
+        else
+            ++it;
+    }
 }
 
-void JFileSystem::preloadZip(const string& filename)
+JZipCache * JFileSystem::preloadZip(const string& filename)
 {
     map<string,JZipCache *>::iterator it = mZipCache.find(filename);
-    if (it != mZipCache.end()) return;
-
-    //random number of files stored in the cache.
-    // This is based on the idea that an average filepath (in Wagic) for image is 37 characters (=bytes) + 8 bytes to store the fileinfo = 45 bytes,
-    //so 4500 files represent roughly 200kB, an "ok" size for the PSP
-    if (mZipCachedElementsCount > 4500) 
+    if (it != mZipCache.end())
     {
-        clearZipCache();
+        if (mZipCacheOrder.front() != filename)
+        {
+            mZipCacheOrder.remove(filename);
+            mZipCacheOrder.push_front(filename);
+        }
+        return it->second;
     }
 
     JZipCache * cache = new JZipCache();
     mZipCache[filename] = cache;
+    mZipCacheOrder.push_front(filename);
 
-    if (!mZipAvailable || !mZipFile) {
-		AttachZipFile(filename);
-		if (!mZipAvailable || !mZipFile) return;
-	}
+    //failures are cached too, so that we don't try to open the same file over and over
+    if (mUserFS->PreloadZip(filename.c_str(), cache->archive) || (mSystemFS && mSystemFS->PreloadZip(filename.c_str(), cache->archive)))
+        mZipCachedElementsCount += cache->archive.entries();
 
-    if ((mUserFS->PreloadZip(filename.c_str(), cache->dir) || (mSystemFS && mSystemFS->PreloadZip(filename.c_str(), cache->dir))))
-    {
-        mZipCachedElementsCount+= cache->dir.size();
-    }
-    else
+    //Evict the least recently used archives rather than the whole cache
+    while (mZipCachedElementsCount > ZIP_CACHE_MAX_ELEMENTS && mZipCacheOrder.size() > 1)
     {
-        DetachZipFile();
+        string oldest = mZipCacheOrder.back();
+        mZipCacheOrder.pop_back();
+
+        map<string,JZipCache *>::iterator old = mZipCache.find(oldest);
+        if (old == mZipCache.end())
+            continue;
+
+        if (mCurrentZip == &(old->second->archive))
+            DetachZipFile();
+        mZipCachedElementsCount -= old->second->archive.entries();
+        delete(old->second);
+        mZipCache.erase(old);
     }
+
+    return cache;
 }
 
 
@@ -182,7 +211,9 @@ JFileSystem::JFileSystem(const string & _userPath, const string & _systemPath)
     mZipCachedElementsCount = 0;
     mPassword = NULL;
     mFileSize = 0;
+    mCurrentZip = NULL;
     mCurrentFileInZip = NULL;
+    mZipReadPos = 0;
 
 };
 
@@ -207,6 +238,23 @@ bool JFileSystem::FileExists(const string& strFilename)
     return (mSystemFS && mSystemFS->FileExists(strFilename)) || mUserFS->FileExists(strFilename);
 }
 
+time_t JFileSystem::GetLastModified(const string& strFilename)
+{
+    struct stat st;
+    string path = mUserFSPath + strFilename;
+    if (stat(path.c_str(), &st) == 0)
+        return st.st_mtime;
+
+    if (mSystemFS)
+    {
+        path = mSystemFSPath + strFilename;
+        if (stat(path.c_str(), &st) == 0)
+            return st.st_mtime;
+    }
+
+    return 0;
+}
+
 bool JFileSystem::MakeDir(const string & dir)
 {
     string fullDir = mUserFSPath + dir;
@@ -232,12 +280,13 @@ void JFileSystem::clearZipCache()
         delete(it->second);
     }
     mZipCache.clear();
+    mZipCacheOrder.clear();
     mZipCachedElementsCount = 0;
 }
 
 bool JFileSystem::AttachZipFile(const string &zipfile, char *password /* = NULL */)
 {
-    if (mZipAvailable && mZipFile != NULL)
+    if (mZipAvailable && mCurrentZip)
     {
         if (mZipFileName != zipfile)
             DetachZipFile();		// close the previous zip file
@@ -248,20 +297,12 @@ bool JFileSystem::AttachZipFile(const string &zipfile, char *password /* = NULL
     mZipFileName = zipfile;
     mPassword = password;
 
-    openForRead(mZipFile, mZipFileName);
-
-    if (!mZipFile)
+    //A zip inside a zip is mapped in place, as long as it is stored
+    JZipCache * cache = preloadZip(mZipFileName);
+    if (!cache->archive.is_open())
         return false;
 
-
-    //A hack for a zip inside a zip: instead we open the zip containing it
-    if (mZipFile.Zipped())
-    {
-        mZipFile.close();
-        assert(filesystem::getCurrentFS());
-        mZipFile.open(filesystem::getCurrentZipName().c_str(), filesystem::getCurrentFS()); 
-        assert(mZipFile);
-    }
+    mCurrentZip = &(cache->archive);
     mZipAvailable = true;
     return true;
 
@@ -270,11 +311,8 @@ bool JFileSystem::AttachZipFile(const string &zipfile, char *password /* = NULL
 
 void JFileSystem::DetachZipFile()
 {
-    if (mZipFile)
-    {
-        mZipFile.close();
-    }
-    mCurrentFileInZip = NULL;
+    CloseFile();
+    mCurrentZip = NULL;
     mZipAvailable = false;
 }
 
@@ -296,6 +334,13 @@ bool JFileSystem::openForRead(izfstream & File, const string & FilePath) {
 
 bool JFileSystem::readIntoString(const string & FilePath, string & target)
 {
+    //Files in mapped zips are inflated directly into the string
+    int zipped = mUserFS->ReadZipped(FilePath.c_str(), target);
+    if (!zipped && mSystemFS)
+        zipped = mSystemFS->ReadZipped(FilePath.c_str(), target);
+    if (zipped > 0)
+        return true;
+
     izfstream file;
     if (!openForRead(file, FilePath))
         return false;
@@ -361,30 +406,17 @@ bool JFileSystem::openForWrite(ofstream & File, const string & FilePath, ios_bas
 
 bool JFileSystem::OpenFile(const string &filename)
 {
-    mCurrentFileInZip = NULL;
+    CloseFile();
 
-    if (!mZipAvailable || !mZipFile)
+    if (!mZipAvailable || !mCurrentZip)
         return openForRead(mFile, filename);
 
-    preloadZip(mZipFileName);
-    map<string,JZipCache *>::iterator it = mZipCache.find(mZipFileName);
-    if (it == mZipCache.end())
-    {
-        //DetachZipFile();
-        //return OpenFile(filename); 
-        return openForRead(mFile, filename);
-    }
-    JZipCache * zc = it->second;
-    map<string,  filesystem::limited_file_info>::iterator it2 = zc->dir.find(filename);
-    if (it2 == zc->dir.end())
-    {
-        /*DetachZipFile();
-        return OpenFile(filename); */
+    const zip_file_system::mapped_zip::entry * entry = mCurrentZip->find(filename);
+    if (!entry || entry->m_Directory)
         return openForRead(mFile, filename);
-    }
 
-    mCurrentFileInZip = &(it2->second);
-    mFileSize = it2->second.m_Size;
+    mCurrentFileInZip = entry;
+    mFileSize = (int) entry->m_Size;
     return true;
 
 }
@@ -392,10 +424,9 @@ bool JFileSystem::OpenFile(const string &filename)
 
 void JFileSystem::CloseFile()
 {
-    if (mZipAvailable && mZipFile)
-    {
-        mCurrentFileInZip = NULL;
-    }
+    mCurrentFileInZip = NULL;
+    mZipReadPos = 0;
+    std::vector<char>().swap(mZipInflated);
 
     if (mFile)
         mFile.close();
@@ -406,14 +437,29 @@ int JFileSystem::ReadFile(void *buffer, int size)
 {
     if (mCurrentFileInZip)
     {
-        assert(mZipFile);
-        if((size_t)size > mCurrentFileInZip->m_Size) //only support "store" method for zip inside zips
+        assert(mCurrentZip);
+        if (size < 0 || mZipReadPos + size > mCurrentFileInZip->m_Size)
             return 0;
-        std::streamoff offset = filesystem::SkipLFHdr(mZipFile, mCurrentFileInZip->m_Offset);
-        if (!mZipFile.seekg(offset))
+
+        //Deflate streams can't seek: inflate the whole file once if it is read in several chunks
+        if (!mCurrentFileInZip->stored() && (mZipReadPos || (size_t) size < mCurrentFileInZip->m_Size))
+        {
+            if (mZipInflated.empty() && mCurrentFileInZip->m_Size)
+            {
+                mZipInflated.resize(mCurrentFileInZip->m_Size);
+                if (mCurrentZip->read(*mCurrentFileInZip, &mZipInflated[0], mZipInflated.size()) != mZipInflated.size())
+                {
+                    std::vector<char>().swap(mZipInflated);
+                    return 0;
+                }
+            }
+            if (size)
+                memcpy(buffer, &mZipInflated[mZipReadPos], size);
+        }
+        else if (mCurrentZip->read(*mCurrentFileInZip, buffer, size, mZipReadPos) != (size_t) size)
             return 0;
-        mZipFile.read((char *) buffer, size);
-        //TODO what if can't read
+
+        mZipReadPos += size;
         return size;
     }
 
@@ -795,6 +795,15 @@ void JRenderer::TransferTextureToGLContext(JTexture& inTexture)
 
 }
 
+/*
+** Decoding goes through the VRAM allocator and the hardware decoder on PSP, which aren't
+** usable from several threads: always load through LoadTexture.
+*/
+JTexture* JRenderer::LoadTextureFromMemory(const char* filename, u8* data, int size, int mode, int textureFormat)
+{
+    return NULL;
+}
+
 
 //------------------------------------------------------------------------------------------------
 // Taken from:
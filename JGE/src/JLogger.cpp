@@ -2,13 +2,250 @@
 #include "../include/JGE.h"
 #include "../include/DebugRoutines.h"
 
+#include <cstring>
 #include <fstream>
+#include <sstream>
+
+#if defined(DOLOG) && !defined(PSP)
+#define ASYNC_LOG
+#include "../include/Threading.h"
+#ifdef WIN32
+#include <windows.h>
+#endif
+#endif
 
 string JLogger::lastLog = "";
 int JLogger::lastTime = 0;
 
+#ifdef ASYNC_LOG
+namespace
+{
+#ifdef WIN32
+    typedef volatile LONG AtomicInt;
+
+    inline LONG CompareAndSwap(AtomicInt* value, LONG expected, LONG desired)
+    {
+        return InterlockedCompareExchange(value, desired, expected);
+    }
+
+    inline void AtomicIncrement(AtomicInt* value)
+    {
+        InterlockedIncrement(value);
+    }
+
+    inline void MemoryFence()
+    {
+        MemoryBarrier();
+    }
+#else
+    typedef volatile long AtomicInt;
+
+    inline long CompareAndSwap(AtomicInt* value, long expected, long desired)
+    {
+        return __sync_val_compare_and_swap(value, expected, desired);
+    }
+
+    inline void AtomicIncrement(AtomicInt* value)
+    {
+        __sync_add_and_fetch(value, 1);
+    }
+
+    inline void MemoryFence()
+    {
+        __sync_synchronize();
+    }
+#endif
+
+    // Positions wrap around, only their difference matters
+    inline long Distance(long from, long to)
+    {
+        return (long) ((unsigned long) to - (unsigned long) from);
+    }
+
+    const int kRingSize = 512;
+    const int kTagSize = 16;
+    const int kMaxMessageSize = 232;
+    const int kIdleTime = 20;
+
+    struct LogEntry
+    {
+        AtomicInt sequence;
+        int time;
+        int level;
+        char tag[kTagSize];
+        char text[kMaxMessageSize];
+    };
+
+    struct ThreadTag
+    {
+        char name[kTagSize];
+    };
+
+    /*
+     Bounded multi producer queue: producers claim a position with a compare and swap on sEnqueuePos,
+     fill the entry and publish it through its sequence; the writer thread is the only consumer.
+     Entry i is free for position pos when sequence + i == pos, and holds the message of pos when
+     sequence + i == pos + 1.
+     Everything is zero initialized, so that logging works before (and after) static constructors run.
+     */
+    LogEntry sRing[kRingSize];
+    AtomicInt sEnqueuePos;
+    long sDequeuePos;
+    AtomicInt sDropped;
+    AtomicInt sStarted;
+    volatile bool sStopping;
+    volatile int sLevel;
+    boost::thread* sWriterThread;
+
+    void DeleteTag(ThreadTag * tag)
+    {
+        delete tag;
+    }
+
+    boost::thread_specific_ptr<ThreadTag> sThreadTag(DeleteTag);
+
+    void Push(int level, const char * text)
+    {
+        long pos = sEnqueuePos;
+        LogEntry * entry;
+        for (;;)
+        {
+            int index = (int) (pos & (kRingSize - 1));
+            entry = &sRing[index];
+            long diff = Distance(pos, entry->sequence + index);
+            if (diff == 0)
+            {
+                long previous = CompareAndSwap(&sEnqueuePos, pos, pos + 1);
+                if (previous == pos)
+                    break;
+                pos = previous;
+            }
+            else if (diff < 0)
+            {
+                // the writer is a whole ring behind
+                AtomicIncrement(&sDropped);
+                return;
+            }
+            else
+            {
+                pos = sEnqueuePos;
+            }
+        }
+
+        entry->time = JGEGetTime();
+        entry->level = level;
+        ThreadTag * tag = sThreadTag.get();
+        strncpy(entry->tag, tag ? tag->name : "", kTagSize - 1);
+        entry->tag[kTagSize - 1] = 0;
+        strncpy(entry->text, text, kMaxMessageSize - 1);
+        entry->text[kMaxMessageSize - 1] = 0;
+
+        MemoryFence();
+        entry->sequence = pos + 1 - (pos & (kRingSize - 1));
+    }
+
+    // Writes the published messages, returns how many. Only the writer calls it.
+    int Drain(std::ofstream& file)
+    {
+        static const char kLevels[] = "DIWE";
+        int count = 0;
+        for (;;)
+        {
+            int index = (int) (sDequeuePos & (kRingSize - 1));
+            LogEntry& entry = sRing[index];
+            if (Distance(sDequeuePos + 1, entry.sequence + index) != 0)
+                break;
+            MemoryFence();
+
+            std::ostringstream out;
+            out << entry.time << "(+" << entry.time - JLogger::lastTime << ") " << kLevels[entry.level & 3];
+            if (entry.tag[0])
+                out << " [" << entry.tag << "]";
+            out << " :" << entry.text;
+            JLogger::lastTime = entry.time;
+
+            MemoryFence();
+            entry.sequence = sDequeuePos + kRingSize - index;
+            sDequeuePos++;
+            count++;
+
+            if (file)
+                file << out.str() << "\n";
+            DebugTrace(out.str());
+        }
+
+        long dropped = sDropped;
+        while (dropped)
+        {
+            long previous = CompareAndSwap(&sDropped, dropped, 0);
+            if (previous == dropped)
+            {
+                if (file)
+                    file << "(" << dropped << " messages dropped, the log was full)\n";
+                break;
+            }
+            dropped = previous;
+        }
+
+        if (count && file)
+            file.flush();
+        return count;
+    }
+
+    void WriterProc(void *)
+    {
+        JLogger::SetThreadTag("log");
+        std::ofstream file(LOG_FILE, std::ios_base::app);
+        while (!sStopping)
+        {
+            if (!Drain(file))
+                boost::this_thread::sleep(boost::posix_time::milliseconds(kIdleTime));
+        }
+        Drain(file);
+    }
+
+    void StartWriter()
+    {
+        if (sStarted || CompareAndSwap(&sStarted, 0, 1) != 0)
+            return;
+        sWriterThread = new boost::thread(WriterProc, (void *) NULL);
+    }
+
+    // Writes what's left when the program exits
+    struct WriterShutdown
+    {
+        ~WriterShutdown()
+        {
+            if (!sWriterThread)
+                return;
+            sStopping = true;
+            sWriterThread->join();
+            delete sWriterThread;
+            sWriterThread = NULL;
+        }
+    } sWriterShutdown;
+}
+#endif
+
 void JLogger::Log(const char * text){
-#ifdef DOLOG
+  Log(LEVEL_INFO, text);
+}
+
+void JLogger::Log(std::string text){
+    Log(LEVEL_INFO, text.c_str());
+}
+
+void JLogger::Log(int level, const std::string& text){
+    Log(level, text.c_str());
+}
+
+void JLogger::Log(int level, const char * text){
+#ifdef ASYNC_LOG
+  if (level < sLevel)
+    return;
+  StartWriter();
+  Push(level, text);
+#elif defined(DOLOG)
   std::ofstream file(LOG_FILE, std::ios_base::app);
   std::stringstream out;
   int newTime = JGEGetTime();
@@ -22,11 +259,39 @@ void JLogger::Log(const char * text){
 
   DebugTrace(out.str());
 #endif
+#ifdef PSP
   lastLog = text;
+#endif
 }
 
-void JLogger::Log(std::string text){
-    Log(text.c_str());
+void JLogger::SetLevel(int level)
+{
+#ifdef ASYNC_LOG
+  sLevel = level;
+#endif
+}
+
+void JLogger::SetThreadTag(const char * tag)
+{
+#ifdef ASYNC_LOG
+  ThreadTag * threadTag = sThreadTag.get();
+  if (!threadTag)
+  {
+    threadTag = new ThreadTag;
+    sThreadTag.reset(threadTag);
+  }
+  strncpy(threadTag->name, tag, kTagSize - 1);
+  threadTag->name[kTagSize - 1] = 0;
+#endif
+}
+
+void JLogger::Flush()
+{
+#ifdef ASYNC_LOG
+  long target = sEnqueuePos;
+  while (sWriterThread && !sStopping && Distance(sDequeuePos, target) > 0)
+    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+#endif
 }
 
 JLogger::JLogger(const char* text) : mText(text)
@@ -46,4 +311,3 @@ JLogger::~JLogger()
   JLogger::Log(stream.str().c_str());
 #endif
 }
-
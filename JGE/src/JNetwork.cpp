@@ -5,6 +5,7 @@
 */
 
 #include "../include/DebugRoutines.h"
+#include "../include/JLogger.h"
 #include "../include/JNetwork.h"
 
 #if defined (WIN32) || defined (LINUX)
@@ -69,8 +70,10 @@ void JNetwork::getServerIp(string& aString)
 
 
 JNetwork::JNetwork()
-  : mpWorkerThread(NULL), socket(0)
+  : mpWorkerThread(NULL), socket(0), connection(0), sendOffset(0), receivedSize(0),
+    framesSent(0), framesReceived(0), bytesSent(0), bytesReceived(0)
 {
+  receiveBuffer.resize(RECEIVE_BUFFER_SIZE);
 #if (defined WIN32) || (defined LINUX)
   connected_to_ap = 1;
 #else
@@ -82,7 +85,13 @@ JNetwork::JNetwork()
 JNetwork::~JNetwork()
 {
   if(mpWorkerThread) {
-    socket->Disconnect();
+    {
+      boost::mutex::scoped_lock l(sendMutex);
+      if(connection)
+        connection->Disconnect();
+    }
+    if(socket)
+      socket->Disconnect();
     mpWorkerThread->join();
     delete mpWorkerThread;
   }
@@ -103,9 +112,27 @@ bool JNetwork::sendCommand(const string& xString, const string& payload, const s
     DebugTrace("sendCommand failed: command not registered");
     return false;
   }
-  aString = "<" + aString + ">" + "\n" + payload + "\n" + "<" + aString + "/>";
 
-  toSend << aString;
+  size_t frameSize = 2 + aString.size() + payload.size();
+  if(aString.size() > 0xFFFF || frameSize > MAX_FRAME_SIZE) {
+    DebugTrace("sendCommand failed: frame too large");
+    return false;
+  }
+
+  sendQueue.push_back(string());
+  string& frame = sendQueue.back();
+  frame.reserve(FRAME_HEADER_SIZE + frameSize);
+  frame += (char) (frameSize >> 24);
+  frame += (char) (frameSize >> 16);
+  frame += (char) (frameSize >> 8);
+  frame += (char) frameSize;
+  frame += (char) (aString.size() >> 8);
+  frame += (char) aString.size();
+  frame += aString;
+  frame += payload;
+
+  if(connection)
+    connection->Wake();
 
   return true;
 }
@@ -124,38 +151,117 @@ void JNetwork::registerCommand(string command, void* object, processCmd processC
 
 void JNetwork::Update()
 {
-	boost::mutex::scoped_lock r(receiveMutex);
-    // Checking for some command to execute
-	size_t begin_start_tag = received.str().find("<");
-	size_t end_start_tag = received.str().find(">");
-	string command = received.str().substr(begin_start_tag+1, end_start_tag-(begin_start_tag+1));
-	size_t begin_end_tag = received.str().find(command + "/>");
-	size_t end_end_tag = received.str().find("/>");
-    if(begin_start_tag != string::npos && begin_end_tag != string::npos )
+  deque<Frame> frames;
+  {
+    boost::mutex::scoped_lock r(receiveMutex);
+    frames.swap(received);
+  }
+
+  // the handlers may send commands themselves, no lock is held while they run
+  for(size_t i = 0; i < frames.size(); i++)
+  {
+    map<string, CommandStruc>::iterator ite = sCommandMap.find(frames[i].command);
+    if(ite == sCommandMap.end())
     {
-		map<string, CommandStruc>::iterator ite = sCommandMap.find(command);
-		if(ite != sCommandMap.end())
-		{
-			DebugTrace("begin of command received : " + received.str() );
-			DebugTrace("begin of command toSend : " + toSend.str() );
-
-			processCmd theMethod = (ite)->second.processCommand;
-			stringstream input(received.str().substr(end_start_tag+1, (begin_end_tag-1)-(end_start_tag+1)));
-			stringstream output;
-			theMethod((ite)->second.object, input, output);
-			string aString = received.str().substr(end_end_tag+2, string::npos);
-			received.str(aString);
-			if(output.str().size())
-				sendCommand((ite)->second.command, output.str(), "Response");
-
-			DebugTrace("end of command received : "<< received.str() );
-			DebugTrace("end of command toSend : "<< toSend.str() );
-		}
+      DebugTrace("unknown command received : " << frames[i].command);
+      continue;
+    }
+
+    processCmd theMethod = (ite)->second.processCommand;
+    stringstream input(frames[i].payload);
+    stringstream output;
+    theMethod((ite)->second.object, input, output);
+    if(output.str().size())
+      sendCommand((ite)->second.command, output.str(), "Response");
+  }
+}
+
+bool JNetwork::receiveFrames(JSocket* pSocket)
+{
+  // one read per wake up: what doesn't fit is read on the next one
+  int len = pSocket->Receive(&receiveBuffer[receivedSize], (int) (receiveBuffer.size() - receivedSize));
+  if(len < 0)
+    return false;
+  receivedSize += len;
+  bytesReceived += len;
+
+  const unsigned char* data = (const unsigned char*) &receiveBuffer[0];
+  size_t offset = 0;
+  deque<Frame> frames;
+  while(receivedSize - offset >= FRAME_HEADER_SIZE)
+  {
+    const unsigned char* header = data + offset;
+    size_t frameSize = ((size_t) header[0] << 24) | ((size_t) header[1] << 16) | ((size_t) header[2] << 8) | header[3];
+    if(frameSize < 2 || frameSize > MAX_FRAME_SIZE)
+    {
+      DebugTrace("invalid frame size " << frameSize << ", dropping the connection");
+      pSocket->Disconnect();
+      return false;
+    }
+    if(receivedSize - offset < FRAME_HEADER_SIZE + frameSize)
+    {
+      // only grows for frames larger than the buffer
+      if(FRAME_HEADER_SIZE + frameSize > receiveBuffer.size())
+        receiveBuffer.resize(FRAME_HEADER_SIZE + frameSize);
+      break;
+    }
+
+    const char* body = (const char*) header + FRAME_HEADER_SIZE;
+    size_t nameSize = ((size_t) header[4] << 8) | header[5];
+    if(2 + nameSize > frameSize)
+    {
+      DebugTrace("invalid command name size " << nameSize << ", dropping the connection");
+      pSocket->Disconnect();
+      return false;
+    }
+
+    frames.push_back(Frame());
+    frames.back().command.assign(body + 2, nameSize);
+    frames.back().payload.assign(body + 2 + nameSize, frameSize - 2 - nameSize);
+    offset += FRAME_HEADER_SIZE + frameSize;
+    framesReceived++;
+  }
+
+  if(offset)
+  {
+    memmove(&receiveBuffer[0], &receiveBuffer[offset], receivedSize - offset);
+    receivedSize -= offset;
+  }
+
+  if(frames.size())
+  {
+    boost::mutex::scoped_lock r(receiveMutex);
+    received.insert(received.end(), frames.begin(), frames.end());
+  }
+  return true;
+}
+
+bool JNetwork::sendFrames(JSocket* pSocket)
+{
+  while(sending.size())
+  {
+    const string& frame = sending.front();
+    int len = pSocket->Send(frame.data() + sendOffset, (int) (frame.size() - sendOffset));
+    if(len < 0)
+      return false;
+    if(len == 0)
+      break;
+
+    bytesSent += len;
+    sendOffset += len;
+    if(sendOffset == frame.size())
+    {
+      sending.pop_front();
+      sendOffset = 0;
+      framesSent++;
     }
+  }
+  return true;
 }
 
 void JNetwork::ThreadProc(void* param)
 {
+  JLogger::SetThreadTag("net");
   JNetwork* pThis = reinterpret_cast<JNetwork*>(param);
   JSocket* pSocket = NULL;
   if (pThis->serverIP.size()) {
@@ -170,27 +276,37 @@ void JNetwork::ThreadProc(void* param)
     pSocket = pThis->socket->Accept();
   }
 
+  if(pSocket) {
+    boost::mutex::scoped_lock l(pThis->sendMutex);
+    pThis->connection = pSocket;
+  }
+
   while(pSocket && pSocket->isConnected()) {
-    char buff[4096];
     {
-      int len =  pSocket->Read(buff, sizeof(buff));
-      if(len > 0) {
-		boost::mutex::scoped_lock l(pThis->receiveMutex);
-        DebugTrace("receiving " << len << " bytes : " << buff);
-        pThis->received.str(pThis->received.str() + buff);
-        DebugTrace("received " << pThis->received.str().size() << " bytes : " << pThis->received.str());
+      boost::mutex::scoped_lock l(pThis->sendMutex);
+      // frames change hands by swapping, their bytes are never copied
+      while(pThis->sendQueue.size()) {
+        pThis->sending.push_back(string());
+        pThis->sending.back().swap(pThis->sendQueue.front());
+        pThis->sendQueue.pop_front();
       }
     }
-	{
-		boost::mutex::scoped_lock l(pThis->sendMutex);
-		if(!pThis->toSend.str().empty())
-		{
-		  DebugTrace("sending  " << pThis->toSend.str().size() << " bytes : " << pThis->toSend.str());
-		  pSocket->Write((char*)pThis->toSend.str().c_str(), pThis->toSend.str().size()+1);
-		  pThis->toSend.str("");
-		}
-	}
-    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+
+    int events = pSocket->Wait(!pThis->sending.empty(), 100);
+    if((events & JSocket::READABLE) && !pThis->receiveFrames(pSocket))
+      break;
+    if((events & JSocket::WRITABLE) && !pThis->sendFrames(pSocket))
+      break;
+  }
+
+  {
+    boost::mutex::scoped_lock l(pThis->sendMutex);
+    pThis->connection = NULL;
+  }
+  if(pSocket && pSocket != pThis->socket) {
+    delete pSocket;
+    // the server only takes one connection: report the session as over
+    pThis->socket->Disconnect();
   }
 
   DebugTrace("Quitting Thread");
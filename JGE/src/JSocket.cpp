@@ -64,6 +64,29 @@ int JSocket::Write(char* buff, int size)
 	return 0;
 }
 
+int JSocket::Wait(bool wantWrite, int timeoutMs)
+{
+	return 0;
+}
+
+void JSocket::Wake()
+{
+}
+
+int JSocket::Receive(char* buff, int size)
+{
+	return -1;
+}
+
+int JSocket::Send(const char* buff, int size)
+{
+	return -1;
+}
+
+void JSocket::SetupConnection()
+{
+}
+
 
 #if 0
 int JSocket::make_socket(uint16_t port)
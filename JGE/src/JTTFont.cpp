@@ -49,6 +49,7 @@ JTTFont::JTTFont(int cacheImageSize)
 	mAntialias = true;
 
 	mTexture = NULL;
+	mRetiredTexture = NULL;
 
 	switch (cacheImageSize)
 	{
@@ -76,7 +77,6 @@ JTTFont::JTTFont(int cacheImageSize)
 	for (int i=0;i<TTF_CACHE_SIZE;i++)
 	{
 		mQuads[i] = new JQuad(mTexture, 0, 0, 16, 16);
-		mCachedCode[i] = 0;
 		mXAdvance[i] = 0;
 	}
 
@@ -88,6 +88,7 @@ JTTFont::~JTTFont()
 {
 
 	SAFE_DELETE(mTexture);
+	SAFE_DELETE(mRetiredTexture);
 	
 	for (int i=0;i<TTF_CACHE_SIZE;i++)
 		SAFE_DELETE(mQuads[i]);
@@ -120,24 +121,14 @@ bool JTTFont::SetSize(int size)
 	if (FT_Set_Pixel_Sizes(mFace, size, size) == 0)
 	{
 		mSize = size;
-		mCurr = 0;
 
 		mMaxCharHeight = size+6;
 		mMaxCharWidth = mMaxCharHeight;// + size/2 + 4;
 
-		mColCount = (mTexWidth/mMaxCharWidth);
-		mRowCount = (mTexHeight/mMaxCharHeight);
-
-		mMaxCharCount = mColCount*mRowCount;
-		if (mMaxCharCount > TTF_CACHE_SIZE)
-			mMaxCharCount = TTF_CACHE_SIZE;
-
-
 		FT_Set_Transform(mFace, 0, 0);
 
 		// JTTFont.h says setting font size will clear the cache
-		for (int i = 0; i < TTF_CACHE_SIZE; i++)
-			mCachedCode[i] = 0;
+		ResetCache();
 
 		return true;
 	}
@@ -245,25 +236,67 @@ void JTTFont::Unload(void)
 }
 
 
+void JTTFont::ResetCache()
+{
+	mColCount = (mTexWidth/mMaxCharWidth);
+	mRowCount = (mTexHeight/mMaxCharHeight);
+
+	mMaxCharCount = mColCount*mRowCount;
+	if (mMaxCharCount > TTF_CACHE_SIZE)
+		mMaxCharCount = TTF_CACHE_SIZE;
+
+	mCache.Reset(mMaxCharCount);
+}
+
+
+bool JTTFont::GrowCache()
+{
+	if (mTexWidth >= TTF_MAX_CACHE_IMAGE || mMaxCharCount >= TTF_CACHE_SIZE)
+		return false;
+
+	JTexture* texture = JRenderer::GetInstance()->CreateTexture(mTexWidth*2, mTexHeight*2);
+	if (!texture)
+		return false;
+
+	// the old texture may still be referenced by queued draw calls of this frame
+	SAFE_DELETE(mRetiredTexture);
+	mRetiredTexture = mTexture;
+	mTexture = texture;
+
+	mTexWidth *= 2;
+	mTexHeight *= 2;
+
+	for (int i=0;i<TTF_CACHE_SIZE;i++)
+		mQuads[i]->mTex = mTexture;
+
+	// glyphs are rasterized again on demand into the bigger texture
+	ResetCache();
+	JRenderer::GetInstance()->BindTexture(mTexture);
+
+	return true;
+}
+
+
 int JTTFont::PreCacheChar(u16 ch, u16 cachedCode)
 {
-	for (int i=0;i<mMaxCharCount&&mCachedCode[i];i++)
-	{
-		if (mCachedCode[i] == cachedCode)
-			return i;
-	}
+	int index = mCache.Find(cachedCode);
+	if (index != -1)
+		return index;
 
-	if (mASCIIDirectMapping)
-	{
-		mASCIIDirectMapping = false;
-		mCurr = 0;
-	}
+	mASCIIDirectMapping = false;
 
 	if (!mFontLoaded) return -1;
 
 	if (mSharingFont && mFontSource->GetFontLibrary() == NULL)
 		return -1;
 
+	if (mCache.IsFull())
+		GrowCache();
+
+	index = mCache.Insert(cachedCode);
+	if (index == -1)
+		return -1;
+
 	FT_GlyphSlot slot = mFace->glyph;
 
 	#if defined (WIN32) || defined (LINUX) || defined (IOS)
@@ -275,9 +308,8 @@ int JTTFont::PreCacheChar(u16 ch, u16 cachedCode)
 
 	#endif
 
-	int y = (mCurr/mColCount)*mMaxCharHeight;
-	int x = (mCurr%mColCount)*mMaxCharWidth;
-	int ret = -1;
+	int y = (index/mColCount)*mMaxCharHeight;
+	int x = (index%mColCount)*mMaxCharWidth;
 
 	int renderFlag = FT_LOAD_RENDER;
 	if (!mAntialias)
@@ -350,39 +382,28 @@ int JTTFont::PreCacheChar(u16 ch, u16 cachedCode)
 		}
 	}
 
-	mXAdvance[mCurr] = (u8)(slot->advance.x>>6);
+	mXAdvance[index] = (u8)(slot->advance.x>>6);
 
 	#if defined (WIN32) || defined (LINUX) || defined (IOS)
+		JRenderer::GetInstance()->BindTexture(mTexture);
 		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, mMaxCharWidth, mMaxCharHeight, GL_RGBA, GL_UNSIGNED_BYTE, texBuffer);
 	#else
 		sceKernelDcacheWritebackAll();
 	#endif
 
-	mCachedCode[mCurr] = cachedCode;
-	ret = mCurr;
-
-	mQuads[mCurr++]->SetTextureRect((float)(x+2), (float)(y+1), (float)(slot->bitmap_left+slot->bitmap.width), (float)mMaxCharHeight-1);
-
-	if (mCurr >= mMaxCharCount)
-		mCurr = 0;
+	mQuads[index]->SetTextureRect((float)(x+2), (float)(y+1), (float)(slot->bitmap_left+slot->bitmap.width), (float)mMaxCharHeight-1);
 
 	#if defined (WIN32) || defined (LINUX)
 		delete [] texBuffer;
 	#endif
 	
-	return ret;
+	return index;
 }
 
 
 int JTTFont::GetCachedChar(u16 cachedCode)
 {
-	for (int i=0;i<mMaxCharCount&&mCachedCode[i];i++)
-	{
-		if (mCachedCode[i] == cachedCode)
-			return i;
-	}
-
-	return -1;
+	return mCache.Find(cachedCode);
 }
 
 
@@ -605,7 +626,7 @@ bool JTTFont::PreCacheASCII()
 
 	{
 		int i = 32;
-		mCurr = 0;
+		mCache.Clear();
 		for (int n=0;n<count;n++)
 		{
 			PreCacheChar(i, i);
@@ -628,7 +649,7 @@ bool JTTFont::PreCacheExtendedASCII()
 
 	{
 		int i = 32;
-		mCurr = 0;
+		mCache.Clear();
 		for (int n=0;n<=count;n++)
 		{
 			PreCacheChar(i, i);
@@ -647,3 +668,16 @@ void JTTFont::SetAntialias(bool flag)
 {
 	mAntialias = flag;
 }
+
+
+void JTTFont::NewFrame()
+{
+	mCache.NewFrame();
+}
+
+
+void JTTFont::GetCacheStats(unsigned int *hits, unsigned int *misses) const
+{
+	*hits = mCache.GetHits();
+	*misses = mCache.GetMisses();
+}
@@ -68,6 +68,7 @@ int main(int argc, char* argv[])
         (createApplication(argc, argv));
 
 #endif //QT_WIDGET
+    JGE::GetInstance()->SetARGV(argc, argv);
     app->setApplicationName(WagicCore::getApplicationName());
     FileDownloader fileDownloader(USERDIR, WAGIC_RESOURCE_NAME);
 #ifdef QT_WIDGET
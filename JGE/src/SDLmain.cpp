@@ -728,6 +728,8 @@ int main(int argc, char* argv[])
 		mJNIEnv = (JNIEnv * )argv[1];
         mJNIClass = (jclass * )argv[2];
     }
+#else
+	JGE::GetInstance()->SetARGV(argc, argv);
 #endif		
 
 	DebugTrace("I R in da native");
@@ -341,6 +341,8 @@ bool JGEToggleFullscreen()
 
 int main(int argc, char* argv[])
 {
+  JGE::GetInstance()->SetARGV(argc, argv);
+
   char* path = argv[0];
   while (*path) ++path;
   while ((*path != '/') && (path > argv[0])) --path;
@@ -1674,10 +1674,8 @@ void JRenderer::LoadJPG(TextureInfo &textureInfo, const char *filename, int mode
 {
     textureInfo.mBits = NULL;
 
-    struct jpeg_decompress_struct	cinfo;
-    struct jpeg_error_mgr jerr;
-    BYTE *rawdata, *rgbadata, *scanline, *p, *q;
-    int	rawsize, i;
+    BYTE *rawdata;
+    int	rawsize;
 
     JFileSystem* fileSystem = JFileSystem::GetInstance();
     if (!fileSystem->OpenFile(filename)) return;
@@ -1695,6 +1693,25 @@ void JRenderer::LoadJPG(TextureInfo &textureInfo, const char *filename, int mode
     fileSystem->ReadFile(rawdata, rawsize);
     fileSystem->CloseFile();
 
+    DecodeJPG(textureInfo, rawdata, rawsize);
+
+    delete[] rawdata;
+}
+
+/*
+==============
+DecodeJPG
+==============
+*/
+void JRenderer::DecodeJPG(TextureInfo &textureInfo, u8 *rawdata, int rawsize)
+{
+    textureInfo.mBits = NULL;
+
+    struct jpeg_decompress_struct	cinfo;
+    struct jpeg_error_mgr jerr;
+    BYTE *rgbadata, *scanline, *p, *q;
+    int	i;
+
     // Initialize libJpeg Object
     cinfo.err = jpeg_std_error(&jerr);
     jpeg_create_decompress(&cinfo);
@@ -1786,8 +1803,6 @@ void JRenderer::LoadJPG(TextureInfo &textureInfo, const char *filename, int mode
 
     // Destroy JPEG object
     jpeg_destroy_decompress(&cinfo);
-
-    delete[] rawdata;
 }
 
 
@@ -1831,8 +1846,27 @@ JTexture* JRenderer::LoadTexture(const char* filename, int mode, int TextureForm
         return NULL;
     }
 
-    bool ret = false;
+    return CreateTextureFromInfo(textureInfo);
+}
+
+JTexture* JRenderer::LoadTextureFromMemory(const char* filename, u8* data, int size, int mode __attribute__((unused)), int TextureFormat __attribute__((unused)))
+{
+    TextureInfo textureInfo;
+
+    textureInfo.mBits = NULL;
+
+    // libpng and giflib are fed through JFileSystem callbacks, only jpegs are decoded from memory
+    if (strstr(filename, ".jpg")!=NULL || strstr(filename, ".JPG")!=NULL)
+        DecodeJPG(textureInfo, data, size);
+
+    if (textureInfo.mBits == NULL)
+        return NULL;
+
+    return CreateTextureFromInfo(textureInfo);
+}
 
+JTexture* JRenderer::CreateTextureFromInfo(TextureInfo &textureInfo)
+{
     JTexture *tex = new JTexture();
 
     if (tex)
@@ -1848,6 +1882,10 @@ JTexture* JRenderer::LoadTexture(const char* filename, int mode, int TextureForm
 
         tex->mBuffer = textureInfo.mBits;
     }
+    else
+    {
+        delete [] textureInfo.mBits;
+    }
 
     return tex;
 }
@@ -2242,6 +2280,12 @@ JTexture* JRenderer::LoadTexture(const char* filename, int mode, int TextureForm
 
     return tex;
 }
+
+// UIKit image decoding is only safe on the main thread: always load through LoadTexture.
+JTexture* JRenderer::LoadTextureFromMemory(const char* filename, u8* data, int size, int mode, int TextureFormat)
+{
+    return NULL;
+}
 #elif (defined QT_CONFIG)
 JTexture* JRenderer::LoadTexture(const char* filename, int, int)
 {
@@ -2266,7 +2310,21 @@ JTexture* JRenderer::LoadTexture(const char* filename, int, int)
         fileSystem->ReadFile(rawdata, rawsize);
         fileSystem->CloseFile();
 
-        QImage tmpImage = QImage::fromData(rawdata, rawsize);
+        tex = LoadTextureFromMemory(filename, rawdata, rawsize);
+    } while(false);
+
+    if(rawdata)
+        delete[] rawdata;
+
+    return tex;
+}
+
+JTexture* JRenderer::LoadTextureFromMemory(const char*, u8* data, int size, int, int)
+{
+    JTexture *tex = NULL;
+
+    do {
+        QImage tmpImage = QImage::fromData(data, size);
         if(tmpImage.isNull())
             break;
 
@@ -2293,9 +2351,6 @@ JTexture* JRenderer::LoadTexture(const char* filename, int, int)
         }
     } while(false);
 
-    if(rawdata)
-        delete[] rawdata;
-
     return tex;
 }
 #endif //IOS
@@ -11,7 +11,10 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <netinet/tcp.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 #endif //WINDOWS
 
 #include "../../include/JSocket.h"
@@ -22,6 +25,9 @@ JSocket::JSocket(string ipAddr)
 	: state(NOT_AVAILABLE),
 	mfd(-1)
 {
+#if LINUX
+	mWakeFds[0] = mWakeFds[1] = -1;
+#endif
 	int result;
 	struct hostent *hostentptr = 0;
 #ifdef WIN32
@@ -78,12 +84,19 @@ JSocket::JSocket(string ipAddr)
 		return;
 	}
 
+	SetupConnection();
 	state = CONNECTED;
 }
 
 bool JSocket::SetNonBlocking(int sock)
 {
 #ifdef WIN32
+	u_long nonBlocking = 1;
+	if (ioctlsocket(sock, FIONBIO, &nonBlocking) != 0)
+	{
+		DebugTrace("ioctlsocket(FIONBIO) failed: " << WSAGetLastError());
+		return false;
+	}
 #elif LINUX
 	int opts = fcntl(sock,F_GETFL);
 	if (opts < 0)
@@ -105,6 +118,9 @@ JSocket::JSocket()
 	: state(NOT_AVAILABLE),
 	mfd(-1)
 {
+#if LINUX
+	mWakeFds[0] = mWakeFds[1] = -1;
+#endif
 	int result;
 #ifdef WIN32
 	SOCKADDR_IN Adresse_Socket_Connection;
@@ -170,6 +186,10 @@ JSocket::JSocket(int fd)
 	: state(CONNECTED),
 	mfd(fd)
 {
+#if LINUX
+	mWakeFds[0] = mWakeFds[1] = -1;
+#endif
+	SetupConnection();
 }
 
 JSocket::~JSocket()
@@ -177,12 +197,40 @@ JSocket::~JSocket()
 	Disconnect();
 #ifdef WIN32
 	WSACleanup();
+#elif LINUX
+	for (int i = 0; i < 2; i++)
+	{
+		if (mWakeFds[i] >= 0)
+			close(mWakeFds[i]);
+	}
+#endif
+}
+
+void JSocket::SetupConnection()
+{
+	SetNonBlocking(mfd);
+
+	// commands are small and latency bound: don't let Nagle's algorithm hold them back
+	int noDelay = 1;
+	setsockopt(mfd, IPPROTO_TCP, TCP_NODELAY, (const char*) &noDelay, sizeof(noDelay));
+
+#if LINUX
+	if (pipe(mWakeFds) != 0)
+	{
+		DebugTrace("pipe error:" << strerror(errno));
+		mWakeFds[0] = mWakeFds[1] = -1;
+		return;
+	}
+	SetNonBlocking(mWakeFds[0]);
+	SetNonBlocking(mWakeFds[1]);
 #endif
 }
 
 void JSocket::Disconnect()
 {
 	state = JSocket::DISCONNECTED;
+	// a thread waiting on the socket notices right away
+	Wake();
 	if(mfd)
 	{
 #ifdef WIN32
@@ -312,3 +360,114 @@ int JSocket::Write(char* buff, int size)
 	}
 	return size1 - size;
 }
+
+int JSocket::Wait(bool wantWrite, int timeoutMs)
+{
+	if (state != CONNECTED)
+		return 0;
+
+	int events = 0;
+#ifdef WIN32
+	// no self pipe with winsock: Wake() does nothing, so cap the wait instead
+	if (timeoutMs > 10)
+		timeoutMs = 10;
+
+	fd_set readSet, writeSet;
+	FD_ZERO(&readSet);
+	FD_ZERO(&writeSet);
+	FD_SET(mfd, &readSet);
+	if (wantWrite)
+		FD_SET(mfd, &writeSet);
+	struct timeval tv;
+	tv.tv_sec = 0;
+	tv.tv_usec = 1000 * timeoutMs;
+
+	if (select(mfd+1, &readSet, wantWrite ? &writeSet : NULL, NULL, &tv) > 0)
+	{
+		if (FD_ISSET(mfd, &readSet))
+			events |= READABLE;
+		if (wantWrite && FD_ISSET(mfd, &writeSet))
+			events |= WRITABLE;
+	}
+#elif LINUX
+	struct pollfd fds[2];
+	fds[0].fd = mfd;
+	fds[0].events = POLLIN | (wantWrite ? POLLOUT : 0);
+	fds[0].revents = 0;
+	fds[1].fd = mWakeFds[0];
+	fds[1].events = POLLIN;
+	fds[1].revents = 0;
+	int nfds = (mWakeFds[0] >= 0) ? 2 : 1;
+
+	if (poll(fds, nfds, timeoutMs) > 0)
+	{
+		if (nfds == 2 && (fds[1].revents & POLLIN))
+		{
+			char drain[64];
+			while (read(mWakeFds[0], drain, sizeof(drain)) > 0)
+				;
+		}
+		// hang ups are reported as readable, so that Receive() sees the disconnection
+		if (fds[0].revents & (POLLIN | POLLHUP | POLLERR))
+			events |= READABLE;
+		if (fds[0].revents & POLLOUT)
+			events |= WRITABLE;
+	}
+#endif //WINDOWS
+	return events;
+}
+
+void JSocket::Wake()
+{
+#if LINUX
+	if (mWakeFds[1] >= 0)
+	{
+		char c = 0;
+		ssize_t written = write(mWakeFds[1], &c, 1);
+		(void) written; // a full pipe already wakes up the waiting thread
+	}
+#endif
+}
+
+static bool WouldBlock()
+{
+#ifdef WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+int JSocket::Receive(char* buff, int size)
+{
+	if (state != CONNECTED)
+		return -1;
+
+	int readbytes = recv(mfd, buff, size, 0);
+	if (readbytes > 0)
+		return readbytes;
+	if (readbytes < 0 && WouldBlock())
+		return 0;
+
+	Disconnect();
+	return -1;
+}
+
+int JSocket::Send(const char* buff, int size)
+{
+	if (state != CONNECTED)
+		return -1;
+
+#if defined(LINUX) && defined(MSG_NOSIGNAL)
+	int len = send(mfd, buff, size, MSG_NOSIGNAL);
+#else
+	int len = send(mfd, buff, size, 0);
+#endif
+	if (len >= 0)
+		return len;
+	if (WouldBlock())
+		return 0;
+
+	Disconnect();
+	return -1;
+}
@@ -752,6 +752,8 @@ int WINAPI WinMain(
     DWORD	tickCount;
     int		dt;
 
+    JGE::GetInstance()->SetARGV(__argc, __argv);
+
     g_launcher = new JGameLauncher();
 
     u32 flags = g_launcher->GetInitFlags();
@@ -9,6 +9,7 @@
 // Standard headers
 #include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -23,6 +23,25 @@
 #endif
 
 #include <sys/stat.h>
+#include <string.h>
+
+#include "zstream_zlib.h"
+
+#if defined (WIN32)
+#define ZFS_MMAP_WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif !defined (PSP)
+#define ZFS_MMAP_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace zip_file_system {
 
@@ -468,83 +487,537 @@ void filesystem::InsertZip(const char * Filename, const size_t PackID)
 }
 
 
-bool filesystem::PreloadZip(const char * Filename, map<string, limited_file_info>& target)
+bool filesystem::PreloadZip(const char * Filename, mapped_zip & target)
 {
-	zipfile_info ZipInfo;
+	string FullPath = m_BasePath + Filename;
 
-	// Open zip
-	izfstream File;
-    File.open(Filename, this);
+	// Real zip file
+	if (FileNotZipped(FullPath.c_str()))
+		return target.open(FullPath);
 
-	if (! File)
+	// Zip inside one of our zips: it can only be read in place if it's stored
+	file_info FileInfo;
+	string ZipPath;
+
+	if (! FindFile(Filename, &FileInfo) || FileInfo.m_Directory || (FileInfo.m_CompMethod != STORED) || (FileInfo.m_CompSize != FileInfo.m_Size))
 		return false;
 
-	// Find the start of the central directory
-    if (File.Zipped())
-    {
-        streamoff realBeginOfFile =  SkipLFHdr(CurrentZipFile, File.getOffset());
-        if (! CurrentZipFile.seekg(CentralDirZipped(CurrentZipFile, realBeginOfFile, File.getCompSize())))
-        {
-            File.close();
-            return false;
-        }
+	if ((ZipPath = FindZip(FileInfo.m_PackID)).empty())
+		return false;
 
-	    // Check every headers within the zip file
-	    file_header FileHdr;
+	return target.open(m_BasePath + ZipPath, FileInfo.m_Offset, FileInfo.m_CompSize);
+}
 
-	    while ((NextHeader(CurrentZipFile) == FILE) && (FileHdr.ReadHeader(CurrentZipFile))) {
 
-		    // Include files into Files map
-		    const char * Name = &(* FileHdr.m_Filename.begin());
-		    if (FileHdr.m_FilenameSize != 0) {
+int filesystem::ReadZipped(const char * Filename, std::string & target)
+{
+	if (! mapped_zip::mappable())
+		return -1;
 
-                // The zip in zip method only supports stored Zips because of JFileSystem limitations
-                if ((FileHdr.m_UncompSize != FileHdr.m_CompSize) || FileHdr.m_CompMethod != STORED)
-                    continue;
+	// Real files have the priority over zipped ones
+	if (FileNotZipped((m_BasePath + Filename).c_str()))
+		return -1;
 
-			    target[Name] = limited_file_info(
-				    realBeginOfFile + FileHdr.m_RelOffset,					// "Local File" header offset position
-				    FileHdr.m_UncompSize					// File Size
-			    );
-		    }
-	    }
+	file_info FileInfo;
 
-	    File.close();
-        return (target.size() ? true : false);
-    }
-    else
-    {
-	    if (! File.seekg(CentralDir(File)))
-        {
-            File.close();
-            return false;
-        }
+	if (! FindFile(Filename, &FileInfo))
+		return 0;
+
+	const string & ZipPath = FindZip(FileInfo.m_PackID);
+	if (FileInfo.m_Directory || ZipPath.empty())
+		return -1;
+
+	mapped_zip *& Zip = m_Mapped[FileInfo.m_PackID];
+	if (! Zip) {
+		Zip = new mapped_zip();
+		Zip->open(m_BasePath + ZipPath);
+	}
 
-	    // Check every headers within the zip file
-	    file_header FileHdr;
+	if (! Zip->is_mapped())
+		return -1;
+
+	mapped_zip::entry Entry;
+	Entry.m_Name = Filename;
+	Entry.m_NameSize = (unsigned short) strlen(Filename);
+	Entry.m_LFHdrPos = FileInfo.m_Offset;
+	Entry.m_Size = FileInfo.m_Size;
+	Entry.m_CompSize = FileInfo.m_CompSize;
+	Entry.m_CompMethod = FileInfo.m_CompMethod;
+	Entry.m_Directory = false;
+
+	target.resize(Entry.m_Size);
+	if (Entry.m_Size && (Zip->read(Entry, &target[0], Entry.m_Size) != Entry.m_Size)) {
+		target.clear();
+		return -1;
+	}
 
-	    while ((NextHeader(File) == FILE) && (FileHdr.ReadHeader(File))) {
+	return 1;
+}
 
-		    // Include files into Files map
-		    const char * Name = &(* FileHdr.m_Filename.begin());
-		    if (FileHdr.m_FilenameSize != 0) {
 
-                // The zip in zip method only supports stored Zips because of JFileSystem limitations
-                if ((FileHdr.m_UncompSize != FileHdr.m_CompSize) || FileHdr.m_CompMethod != STORED)
-                    continue;
 
-			    target[Name] = limited_file_info(
-				    FileHdr.m_RelOffset,					// "Local File" header offset position
-				    FileHdr.m_UncompSize					// File Size
-			    );
-		    }
-	    }
+//////////////////////////////////////////////////////////////////////
+// Mapped Zip Member Functions
+//////////////////////////////////////////////////////////////////////
 
-	    File.close();
-        return (target.size() ? true : false);
-    }
+namespace {
 
+inline unsigned int get16(const char * p)
+{
+	const unsigned char * u = reinterpret_cast<const unsigned char *>(p);
+	return u[0] | (u[1] << 8);
+}
 
+inline unsigned int get32(const char * p)
+{
+	const unsigned char * u = reinterpret_cast<const unsigned char *>(p);
+	return u[0] | (u[1] << 8) | (u[2] << 16) | (u[3] << 24);
+}
+
+// Fixed sizes of the zip headers, not counting their variable length fields
+const size_t LOCALFILE_SIZE = 30;
+const size_t FILE_SIZE = 46;
+const size_t ENDOFDIR_SIZE = 22;
+
+}
+
+
+mapped_zip::mapped_zip() : m_Mapping(NULL), m_MappingSize(0), m_Begin(0), m_Size(0), m_File(NULL) { }
+
+
+mapped_zip::~mapped_zip()
+{
+	close();
+}
+
+
+bool mapped_zip::mappable()
+{
+#if defined (ZFS_MMAP_WIN32) || defined (ZFS_MMAP_POSIX)
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+bool mapped_zip::open(const std::string & Path)
+{
+	close();
+
+	if (! map(Path))
+		return false;
+
+	m_Begin = 0;
+	m_Size = m_MappingSize;
+
+	if (! index()) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+
+bool mapped_zip::open(const std::string & Path, size_t LFHdrPos, size_t Size)
+{
+	close();
+
+	if (! map(Path))
+		return false;
+
+	// Locate the data of the inner zip within the outer one
+	m_Begin = 0;
+	m_Size = m_MappingSize;
+
+	entry Inner;
+	Inner.m_LFHdrPos = LFHdrPos;
+	long DataPos = data_pos(Inner);
+
+	if ((DataPos < 0) || (size_t(DataPos) + Size > m_MappingSize)) {
+		close();
+		return false;
+	}
+
+	m_Begin = size_t(DataPos);
+	m_Size = Size;
+
+	if (! index()) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+
+void mapped_zip::close()
+{
+#if defined (ZFS_MMAP_WIN32)
+	if (m_Mapping)
+		UnmapViewOfFile(m_Mapping);
+#elif defined (ZFS_MMAP_POSIX)
+	if (m_Mapping)
+		munmap(const_cast<char *>(m_Mapping), m_MappingSize);
+#endif
+
+	if (m_File)
+		fclose(m_File);
+
+	m_Mapping = NULL;
+	m_File = NULL;
+	m_MappingSize = m_Begin = m_Size = 0;
+	m_CentralDir.clear();
+	m_Entries.clear();
+	m_Slots.clear();
+}
+
+
+bool mapped_zip::is_open() const
+{
+	return ! m_Slots.empty();
+}
+
+
+bool mapped_zip::is_mapped() const
+{
+	return is_open() && (m_Mapping != NULL);
+}
+
+
+size_t mapped_zip::entries() const
+{
+	return m_Entries.size();
+}
+
+
+bool mapped_zip::map(const std::string & Path)
+{
+#if defined (ZFS_MMAP_WIN32)
+	HANDLE File = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (File == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER Size;
+	if (! GetFileSizeEx(File, &Size) || (Size.QuadPart == 0)) {
+		CloseHandle(File);
+		return false;
+	}
+
+	HANDLE Mapping = CreateFileMappingA(File, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(File);
+	if (! Mapping)
+		return false;
+
+	// The view keeps the mapping alive
+	m_Mapping = static_cast<const char *>(MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0));
+	CloseHandle(Mapping);
+	if (! m_Mapping)
+		return false;
+
+	m_MappingSize = size_t(Size.QuadPart);
+	return true;
+
+#elif defined (ZFS_MMAP_POSIX)
+	int File = ::open(Path.c_str(), O_RDONLY);
+	if (File < 0)
+		return false;
+
+	struct stat st;
+	if ((fstat(File, &st) != 0) || (st.st_size <= 0)) {
+		::close(File);
+		return false;
+	}
+
+	// The mapping stays valid once the descriptor is closed
+	void * Mapping = mmap(NULL, size_t(st.st_size), PROT_READ, MAP_PRIVATE, File, 0);
+	::close(File);
+	if (Mapping == MAP_FAILED)
+		return false;
+
+	m_Mapping = static_cast<const char *>(Mapping);
+	m_MappingSize = size_t(st.st_size);
+	return true;
+
+#else
+	m_File = fopen(Path.c_str(), "rb");
+	if (! m_File)
+		return false;
+
+	if ((fseek(m_File, 0, SEEK_END) != 0) || (ftell(m_File) <= 0)) {
+		fclose(m_File);
+		m_File = NULL;
+		return false;
+	}
+
+	m_MappingSize = size_t(ftell(m_File));
+	return true;
+#endif
+}
+
+
+bool mapped_zip::fetch(size_t Pos, void * Buffer, size_t Size) const
+{
+	if ((Pos > m_Size) || (Size > m_Size - Pos))
+		return false;
+
+	if (m_Mapping) {
+		memcpy(Buffer, m_Mapping + m_Begin + Pos, Size);
+		return true;
+	}
+
+	if (! m_File || (fseek(m_File, long(m_Begin + Pos), SEEK_SET) != 0))
+		return false;
+
+	return (fread(Buffer, 1, Size, m_File) == Size);
+}
+
+
+bool mapped_zip::index()
+{
+	if (m_Size < ENDOFDIR_SIZE)
+		return false;
+
+	// Look for the "end of central dir" header, it's followed by a comment of at most 64KB
+	size_t TailSize = m_Size < ENDOFDIR_SIZE + 65535 ? m_Size : ENDOFDIR_SIZE + 65535;
+	vector<char> TailBuffer;
+	const char * Tail;
+
+	if (m_Mapping) {
+		Tail = m_Mapping + m_Begin + m_Size - TailSize;
+	} else {
+		TailBuffer.resize(TailSize);
+		if (! fetch(m_Size - TailSize, &TailBuffer[0], TailSize))
+			return false;
+		Tail = &TailBuffer[0];
+	}
+
+	const char * EndOfDir = NULL;
+
+	for (size_t i = TailSize - ENDOFDIR_SIZE + 1; i-- > 0; ) {
+		const char * Header = Tail + i;
+
+		// Check invariant values (1 disk only) and that the comment ends at eof
+		if ((get32(Header) == ENDOFDIR) && (get16(Header + 4) == 0) && (get16(Header + 6) == 0) &&
+			(get16(Header + 8) == get16(Header + 10)) && (i + ENDOFDIR_SIZE + get16(Header + 20) == TailSize)) {
+			EndOfDir = Header;
+			break;
+		}
+	}
+
+	if (! EndOfDir)
+		return false;
+
+	size_t NbEntries = get16(EndOfDir + 10);
+	size_t DirSize = get32(EndOfDir + 12);
+	size_t DirPos = get32(EndOfDir + 16);
+
+	if ((DirPos > m_Size) || (DirSize > m_Size - DirPos))
+		return false;
+
+	const char * Dir;
+
+	if (m_Mapping) {
+		Dir = m_Mapping + m_Begin + DirPos;
+	} else {
+		m_CentralDir.resize(DirSize);
+		if (DirSize && ! fetch(DirPos, &m_CentralDir[0], DirSize))
+			return false;
+		Dir = DirSize ? &m_CentralDir[0] : NULL;
+	}
+
+	// Read every file header of the central directory. Names are left where they are.
+	m_Entries.reserve(NbEntries);
+
+	for (size_t Pos = 0; (m_Entries.size() < NbEntries) && (Pos + FILE_SIZE <= DirSize); ) {
+		const char * Header = Dir + Pos;
+
+		if (get32(Header) != FILE)
+			break;
+
+		unsigned short NameSize = (unsigned short) get16(Header + 28);
+		size_t HeaderSize = FILE_SIZE + NameSize + get16(Header + 30) + get16(Header + 32);
+
+		if (Pos + HeaderSize > DirSize)
+			break;
+
+		if (NameSize != 0) {
+			entry Entry;
+			Entry.m_Name = Header + FILE_SIZE;
+			Entry.m_NameSize = NameSize;
+			Entry.m_LFHdrPos = get32(Header + 42);
+			Entry.m_Size = get32(Header + 24);
+			Entry.m_CompSize = get32(Header + 20);
+			Entry.m_CompMethod = (short) get16(Header + 10);
+			Entry.m_Directory = (Entry.m_Name[NameSize - 1] == '/') || (Entry.m_Name[NameSize - 1] == '\\');
+			m_Entries.push_back(Entry);
+		}
+
+		Pos += HeaderSize;
+	}
+
+	// Open addressing with linear probing, at most half full
+	size_t NbSlots = 16;
+	while (NbSlots < m_Entries.size() * 2)
+		NbSlots <<= 1;
+
+	m_Slots.assign(NbSlots, -1);
+	const size_t Mask = NbSlots - 1;
+
+	for (size_t i = 0; i < m_Entries.size(); ++i) {
+		const entry & Entry = m_Entries[i];
+		size_t Slot = hash(Entry.m_Name, Entry.m_NameSize) & Mask;
+
+		while (m_Slots[Slot] != -1) {
+			// Duplicate names: the last one wins, as in a map
+			const entry & Other = m_Entries[m_Slots[Slot]];
+			if (same_path(Entry.m_Name, Entry.m_NameSize, Other.m_Name, Other.m_NameSize))
+				break;
+			Slot = (Slot + 1) & Mask;
+		}
+
+		m_Slots[Slot] = int(i);
+	}
+
+	return true;
+}
+
+
+size_t mapped_zip::hash(const char * Name, size_t Size)
+{
+	// FNV-1a, with '/' and '\\' hashing the same
+	unsigned int Hash = 2166136261u;
+
+	for (size_t i = 0; i < Size; ++i) {
+		unsigned char c = (Name[i] == '\\') ? '/' : (unsigned char) Name[i];
+		Hash = (Hash ^ c) * 16777619u;
+	}
+
+	return Hash;
+}
+
+
+bool mapped_zip::same_path(const char * A, size_t ASize, const char * B, size_t BSize)
+{
+	if (ASize != BSize)
+		return false;
+
+	for (size_t i = 0; i < ASize; ++i) {
+		if ((A[i] != B[i]) && ! (((A[i] == '/') || (A[i] == '\\')) && ((B[i] == '/') || (B[i] == '\\'))))
+			return false;
+	}
+
+	return true;
+}
+
+
+const mapped_zip::entry * mapped_zip::find(const std::string & Filename) const
+{
+	if (m_Slots.empty())
+		return NULL;
+
+	const size_t Mask = m_Slots.size() - 1;
+
+	for (size_t Slot = hash(Filename.c_str(), Filename.size()) & Mask; m_Slots[Slot] != -1; Slot = (Slot + 1) & Mask) {
+		const entry & Entry = m_Entries[m_Slots[Slot]];
+		if (same_path(Filename.c_str(), Filename.size(), Entry.m_Name, Entry.m_NameSize))
+			return &Entry;
+	}
+
+	return NULL;
+}
+
+
+long mapped_zip::data_pos(const entry & Entry) const
+{
+	char Header[LOCALFILE_SIZE];
+
+	// The local header may have a different extra field than the central one
+	if (! fetch(Entry.m_LFHdrPos, Header, LOCALFILE_SIZE) || (get32(Header) != LOCALFILE))
+		return -1;
+
+	return long(Entry.m_LFHdrPos + LOCALFILE_SIZE + get16(Header + 26) + get16(Header + 28));
+}
+
+
+const char * mapped_zip::data(const entry & Entry) const
+{
+	if (! m_Mapping || (Entry.m_CompMethod != STORED))
+		return NULL;
+
+	long DataPos = data_pos(Entry);
+
+	if ((DataPos < 0) || (size_t(DataPos) + Entry.m_CompSize > m_Size))
+		return NULL;
+
+	return m_Mapping + m_Begin + DataPos;
+}
+
+
+size_t mapped_zip::read(const entry & Entry, void * Buffer, size_t Size, size_t Pos) const
+{
+	if (Entry.m_Directory || (Pos >= Entry.m_Size))
+		return 0;
+
+	if (Size > Entry.m_Size - Pos)
+		Size = Entry.m_Size - Pos;
+
+	long DataPos = data_pos(Entry);
+	if (DataPos < 0)
+		return 0;
+
+	if (Entry.m_CompMethod == STORED)
+		return fetch(size_t(DataPos) + Pos, Buffer, Size) ? Size : 0;
+
+	if (Entry.m_CompMethod != DEFLATED)
+		return 0;
+
+	// Inflate from the mapping (or a copy of the compressed data) straight into the caller's buffer
+	vector<char> CompBuffer;
+	const char * CompData;
+
+	if (m_Mapping) {
+		if (size_t(DataPos) + Entry.m_CompSize > m_Size)
+			return 0;
+		CompData = m_Mapping + m_Begin + DataPos;
+	} else {
+		CompBuffer.resize(Entry.m_CompSize);
+		if (Entry.m_CompSize && ! fetch(size_t(DataPos), &CompBuffer[0], Entry.m_CompSize))
+			return 0;
+		CompData = Entry.m_CompSize ? &CompBuffer[0] : NULL;
+	}
+
+	z_stream ZStream;
+	memset(&ZStream, 0, sizeof(ZStream));
+
+	if (inflateInit2(&ZStream, -MAX_WBITS) != Z_OK)
+		return 0;
+
+	ZStream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(CompData));
+	ZStream.avail_in = uInt(Entry.m_CompSize);
+
+	int Result = Z_OK;
+
+	// Deflate can't seek: inflate and throw away whatever comes before Pos
+	char Skip[4096];
+	while ((Result == Z_OK) && (ZStream.total_out < Pos)) {
+		size_t Left = Pos - ZStream.total_out;
+		ZStream.next_out = reinterpret_cast<Bytef *>(Skip);
+		ZStream.avail_out = uInt(Left < sizeof(Skip) ? Left : sizeof(Skip));
+		Result = inflate(&ZStream, Z_NO_FLUSH);
+	}
+
+	ZStream.next_out = reinterpret_cast<Bytef *>(Buffer);
+	ZStream.avail_out = uInt(Size);
+
+	while ((Result == Z_OK) && (ZStream.avail_out != 0))
+		Result = inflate(&ZStream, Z_NO_FLUSH);
+
+	size_t Read = Size - ZStream.avail_out;
+	inflateEnd(&ZStream);
+
+	return Read;
 }
 
 
@@ -625,64 +1098,6 @@ bool filesystem::lt_path::operator () (const string & s1, const  string & s2) co
 //////////////////////////////////////////////////////////////////////
 
 
-streamoff filesystem::CentralDirZipped(std::istream & File, std::streamoff begin, std::size_t size) const
-{
-	using io_facilities::readvar;
-
-    std::streamoff eof = begin + size;
-
-	// Look for the "end of central dir" header. Start minimum 22 bytes before end.
-    if (! File.seekg(eof - 22, ios::beg))
-        return -1;
-
-	streamoff EndPos;
-	streamoff StartPos = File.tellg();
-
-	if (StartPos == streamoff(0))
-        return -1;
-
-	if (StartPos <= begin + streamoff(65536))
-		EndPos = 1;
-	else
-		EndPos = StartPos - streamoff(65536);
-
-	// Start the scan
-	do {
-		unsigned int RawSignature;
-
-		if (! readvar(File, RawSignature, 4))
-            return -1;
-
-		eofcd_header Header;
-		streampos Pos = File.tellg();
-
-		// Found a potential "eofcd" header?
-		if ((RawSignature == ENDOFDIR) && (File.seekg(-4, ios::cur)) && (Header.ReadHeader(File))) {
-
-			// Check invariant values (1 disk only)
-			if ((Header.m_NbDisks == 0) && (0 == Header.m_DirDisk) && (Header.m_LocalEntries == Header.m_TotalEntries)) {
-
-				// Check comment ends at eof
-				if (! File.seekg(eof - 1 , ios::beg))
-                    return -1;
-				if ((File.tellg() + streamoff(1)) == (Pos + streamoff(Header.m_CommentSize + 22 - 4))) {
-
-					// Check the start offset leads to a correct directory/file header;
-					if (! File.seekg(begin + Header.m_Offset)) return -1;
-					if (! readvar(File, RawSignature, 4)) return -1;
-					if (RawSignature == FILE)
-						return begin + Header.m_Offset;
-				}
-			}
-		}
-
-		File.seekg(Pos);
-
-	} while ((File.seekg(-5, ios::cur)) && (File.tellg() > EndPos) && (File.tellg() > begin));
-
-    return -1;
-}
-
 streamoff filesystem::CentralDir(istream & File) const
 {
 	using io_facilities::readvar;
@@ -60,6 +60,83 @@ class filesystem;
 
 
 
+// Read-only view of a zip archive, mapped in memory where the platform allows it.
+// The central directory is indexed once in an open-addressing hash table; entry names
+// point straight into the mapping. Stored entries can be accessed in place, deflated
+// ones are inflated directly into the caller's buffer.
+// Without mmap (PSP), the central directory is read in memory and entries are read
+// from the file on demand.
+class mapped_zip
+{
+public:
+	class entry
+	{
+	public:
+		const char *	m_Name;			// Not null terminated
+		unsigned short	m_NameSize;
+		size_t			m_LFHdrPos;		// "Local File" header position, relative to the archive start
+		size_t			m_Size;
+		size_t			m_CompSize;
+		short			m_CompMethod;
+		bool			m_Directory;
+
+		bool stored() const { return m_CompMethod == 0; }
+	};
+
+	mapped_zip();
+	~mapped_zip();
+
+	// Opens a zip file
+	bool open(const std::string & Path);
+	// Opens a zip stored (not deflated) inside another zip file, at the given "Local File" header position
+	bool open(const std::string & Path, size_t LFHdrPos, size_t Size);
+	void close();
+
+	bool is_open() const;
+	bool is_mapped() const;
+	size_t entries() const;
+
+	// Can archives be mapped in memory on this platform?
+	static bool mappable();
+
+	// Returns NULL if the file is not in the archive. '/' and '\\' are the same.
+	const entry * find(const std::string & Filename) const;
+
+	// Pointer to the data of a stored entry, NULL if it's compressed or the archive isn't mapped
+	const char * data(const entry & Entry) const;
+
+	// Reads (inflating if needed) Size bytes of the entry starting at Pos into Buffer. Returns the number of bytes read.
+	size_t read(const entry & Entry, void * Buffer, size_t Size, size_t Pos = 0) const;
+
+protected:
+	bool map(const std::string & Path);
+	bool index();
+	bool fetch(size_t Pos, void * Buffer, size_t Size) const;
+	long data_pos(const entry & Entry) const;
+	static size_t hash(const char * Name, size_t Size);
+	static bool same_path(const char * A, size_t ASize, const char * B, size_t BSize);
+
+	// The whole file, when mapped
+	const char *	m_Mapping;
+	size_t			m_MappingSize;
+	// The archive within the file
+	size_t			m_Begin;
+	size_t			m_Size;
+
+	// Unmapped fallback
+	std::FILE *			m_File;
+	std::vector<char>	m_CentralDir;
+
+	std::vector<entry>	m_Entries;
+	std::vector<int>	m_Slots;		// indices in m_Entries, -1 for empty, size is a power of 2
+
+	// Non copyable
+	mapped_zip(const mapped_zip &);
+	mapped_zip & operator = (const mapped_zip &);
+};
+
+
+
 // Input Zip File class
 class izfstream : public izstream
 {
@@ -122,17 +199,6 @@ public:
 		bool	m_Directory;
 	};
 
-	class limited_file_info
-	{
-	public:
-		limited_file_info() :  m_Offset(0), m_Size(0) { }
-		limited_file_info(size_t Offset, size_t Size) :
-			m_Offset(Offset), m_Size(Size) { }
-
-		size_t	m_Offset;
-		size_t	m_Size;
-	};
-
     class pooledBuffer
     {
     public:
@@ -151,7 +217,10 @@ public:
 	void Open(izfstream & File, const char * Filename);
     bool DirExists(const std::string & folderName);
     bool FileExists(const std::string & fileName);
-    bool PreloadZip(const char * Filename, std::map<std::string, limited_file_info>& target);
+    bool PreloadZip(const char * Filename, mapped_zip & target);
+    // Reads a whole file from one of our zips without going through a stream.
+    // Returns 1 if read, 0 if the file isn't in our zips, -1 if it has to be read with Open() (real file, or error)
+    int ReadZipped(const char * Filename, std::string & target);
     static std::string getCurrentZipName();
     static filesystem * getCurrentFS();
     static std::streamoff SkipLFHdr(std::istream & File, std::streamoff LFHdrPos);
@@ -189,7 +258,6 @@ protected:
 	// Protected member functions
 	// Zip file format related functions
 	std::streamoff CentralDir(std::istream & File) const;
-    std::streamoff CentralDirZipped(std::istream & File, std::streamoff begin, std::size_t size) const;
 	headerid NextHeader(std::istream & File) const;
 
 	// File/Zip map related functions
@@ -214,6 +282,7 @@ protected:
 	std::string	m_FileExt;
 	zipmap		m_Zips;
 	filemap		m_Files;
+	std::map<size_t, mapped_zip *>	m_Mapped;	// Zips mapped by ReadZipped, by PackID
     static std::vector<pooledBuffer *> m_Buffers;
     static std::ifstream CurrentZipFile;
     static std::string CurrentZipName;
@@ -303,6 +372,9 @@ inline filesystem::~filesystem() {
 	// Security mesure with izfile::pDefaultFS
 	if (izfstream::pDefaultFS == this)
 		izfstream::pDefaultFS = NULL;
+
+	for (std::map<size_t, mapped_zip *>::iterator It = m_Mapped.begin(); It != m_Mapped.end(); ++It)
+		delete It->second;
 }
 
 inline void filesystem::closeTempFiles() {
@@ -34,6 +34,7 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.cpp \
         $(MTG_PATH)/src/ActionLayer.cpp \
         $(MTG_PATH)/src/ActionStack.cpp \
         $(MTG_PATH)/src/AIHints.cpp \
+        $(MTG_PATH)/src/AIProfiler.cpp \
         $(MTG_PATH)/src/AIMomirPlayer.cpp \
         $(MTG_PATH)/src/AIPlayer.cpp \
         $(MTG_PATH)/src/AIPlayerBaka.cpp \
@@ -57,6 +58,7 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.cpp \
         $(MTG_PATH)/src/DeckMenuItem.cpp \
         $(MTG_PATH)/src/DeckMetaData.cpp \
         $(MTG_PATH)/src/DeckStats.cpp \
+        $(MTG_PATH)/src/GoldfishSimulator.cpp \
         $(MTG_PATH)/src/DuelLayers.cpp \
         $(MTG_PATH)/src/Effects.cpp \
         $(MTG_PATH)/src/ExtraCost.cpp \
@@ -89,6 +91,7 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.cpp \
         $(MTG_PATH)/src/ManaCost.cpp \
         $(MTG_PATH)/src/ManaCostHybrid.cpp \
         $(MTG_PATH)/src/MenuItem.cpp \
+        $(MTG_PATH)/src/MemoryPool.cpp \
         $(MTG_PATH)/src/ModRules.cpp \
         $(MTG_PATH)/src/MTGAbility.cpp \
         $(MTG_PATH)/src/MTGCard.cpp \
@@ -25,7 +25,7 @@ public:
     string mCardEffBad;
     vector<string>castOrder;
     vector<string>combos;
-    //for preformance we disect the combo on first run.
+    //for preformance we disect the combo when the hint is parsed.
     vector<string>partOfCombo;
     vector<string>hold;
     vector<string>until;
@@ -42,7 +42,7 @@ class AIHints
 {
 protected:
     AIPlayerBaka * mPlayer;
-    vector<AIHint *> hints;
+    vector<boost::shared_ptr<AIHint> > hints; //shared with the deck list cache, never modified
     AIHint * getByCondition (string condition);
     AIAction * findAbilityRecursive(AIHint * hint, ManaCost * potentialMana);
     vector<MTGAbility *> findAbilities(AIHint * hint);
@@ -63,6 +63,7 @@ public:
     bool canWeCombo(GameObserver* observer,MTGCardInstance * card = NULL,AIPlayerBaka * Ai = NULL);
     vector<string> mCastOrder();
     void add(string line);
+    void add(const boost::shared_ptr<AIHint>& hint);
     ~AIHints();
 };
 
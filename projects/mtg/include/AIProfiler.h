@@ -0,0 +1,70 @@
+#ifndef _AIPROFILER_H_
+#define _AIPROFILER_H_
+
+/*
+ Scoped timers and counters for the AI, compiled in with AI_PROFILER (see config.h).
+
+ AI_PROFILE("name") times the enclosing scope, AI_COUNT("name") counts an event, and
+ AI_PROFILE_CONTEXT(phase, deck) sets, for the enclosing scope, the game phase and deck the
+ measures of the calling thread are attributed to.
+ Each thread accumulates into its own table, without locks: the tables are merged when their thread
+ exits and when the report is written. Names must be string literals, they are keys by address.
+
+ Without AI_PROFILER, the macros compile to nothing.
+ */
+
+#ifdef AI_PROFILER
+
+#include <stdint.h>
+#include <string>
+
+class AIProfiler
+{
+public:
+    class Scope
+    {
+    public:
+        Scope(const char * name);
+        ~Scope();
+
+        uint64_t mChildren;
+    private:
+        const char * mName;
+        uint64_t mStart;
+        Scope * mParent;
+    };
+
+    class Context
+    {
+    public:
+        Context(int phase, const std::string& deck);
+        ~Context();
+    private:
+        int mPhase;
+        const char * mDeck;
+    };
+
+    static void count(const char * name);
+
+    // Writes the measures of all threads so far, by function, by function and phase and by function and deck
+    static void report(const std::string& filename);
+    static void reset();
+};
+
+#define AI_PROFILE_CONCAT2(a, b) a##b
+#define AI_PROFILE_CONCAT(a, b) AI_PROFILE_CONCAT2(a, b)
+#define AI_PROFILE(name) AIProfiler::Scope AI_PROFILE_CONCAT(aiProfileScope, __LINE__)(name)
+#define AI_COUNT(name) AIProfiler::count(name)
+#define AI_PROFILE_CONTEXT(phase, deck) AIProfiler::Context AI_PROFILE_CONCAT(aiProfileContext, __LINE__)(phase, deck)
+#define AI_PROFILE_REPORT(filename) AIProfiler::report(filename)
+
+#else
+
+#define AI_PROFILE(name)
+#define AI_COUNT(name)
+#define AI_PROFILE_CONTEXT(phase, deck)
+#define AI_PROFILE_REPORT(filename)
+
+#endif
+
+#endif
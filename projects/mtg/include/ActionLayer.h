@@ -38,6 +38,10 @@ public:
     int receiveEventPlus(WEvent * event);
     int reactToTargetClick(Targetable * card);
     int isReactingToClick(MTGCardInstance * card);
+    //isReactingToClick of one element, with the given mana or the mana pool of the acting player.
+    //Answers are kept while the game doesn't change (see GameObserver::getStateVersion), nor the phase, the acting player
+    //or the stack: the AI and the clicks ask the same questions many times while a player has priority.
+    int isReactingToClick(ActionElement * action, MTGCardInstance * card, ManaCost * mana = NULL);
     bool getMenuIdFromCardAbility(MTGCardInstance *card, MTGAbility *ability, int& menuId);
     int reactToClick(MTGCardInstance * card);
     int reactToClick(ActionElement * ability, MTGCardInstance * card);
@@ -64,6 +68,23 @@ protected:
     ActionElement * currentWaitingAction;
     int cantCancel;
     std::set<ActionElement*> mReactions;
+
+    struct ReactionsContext
+    {
+        unsigned long version;
+        int phase;
+        Player * acting;
+        Player * interrupting;
+        size_t stackSize;
+        ExtraCosts * extraPayment;
+        TargetChooser * targetChooser;
+
+        bool operator==(const ReactionsContext& other) const;
+    };
+    typedef std::pair<std::pair<ActionElement *, MTGCardInstance *>, vector<int> > ReactionKey;
+    ReactionsContext reactionsContext;
+    std::map<ReactionKey, int> reactions;
+    ReactionsContext getReactionsContext();
 };
 
 #endif
@@ -38,441 +38,106 @@ public:
     virtual MTGEventText * clone() const;
 };
 
+/*
+ Compiled form of the strings WParsedInt understands ("type:creature:mybattlefield", "halfuplifetotal", "-storedp"...).
+ Each string is compiled once for the whole program: the keywords, the rounding and bonus words and the target
+ chooser descriptions are sorted out up front, so evaluating an expression parses nothing.
+ */
+class WParsedIntExpression
+{
+public:
+    // Compiled expression for s, shared by everyone and kept until the program exits
+    static const WParsedIntExpression * get(const string& s);
+
+    // If chooser is not NULL, it keeps the target chooser used to count cards from one evaluation to the next
+    // (it is bound to the game of the card), and the caller deletes it.
+    int evaluate(Spell * spell, MTGCardInstance * card, TargetChooser ** chooser = NULL) const;
+
+    // Same value whatever the card and the state of the game
+    bool isConstant() const { return kind == EMPTY || kind == CONSTANT; }
+
+protected:
+    enum Kind
+    {
+        EMPTY,
+        CONSTANT,
+        STORED,
+        PREX,
+        X,
+        XX,
+        CASTX,
+        GEAR,
+        COLORS,
+        AURAS,
+        MANACOST,
+        TYPE_COUNT,
+        RESTRICTION,
+        COUNTER,
+        HIGHEST_OR_LOWEST,
+        SUNBURST,
+        TARGETED_CURSES,
+        LIFE_TOTAL,
+        HIGHEST_LIFE_TOTAL,
+        LOWEST_LIFE_TOTAL,
+        THAT_MUCH,
+        OPPONENT_LIFE_LOST,
+        LIFE_LOST,
+        PLAYER_DAMAGE_COUNT,
+        OPPONENT_DAMAGE_COUNT,
+        PLAYER_POISON_COUNT,
+        OPPONENT_POISON_COUNT,
+        OPPONENT_LIFE_TOTAL,
+        PLAYER_DRAW_COUNT,
+        OPPONENT_DRAW_COUNT,
+        POWER,
+        TOUGHNESS,
+        KICKED,
+        HAND_SIZE,
+        CONTROLLER_TURN,
+        OPPONENT_TURN,
+        PLAYER_HAND_COUNT,
+        OPPONENT_HAND_COUNT
+    };
+
+    // What HIGHEST_OR_LOWEST compares
+    enum Property
+    {
+        CONVERTED_COST,
+        POWER_OF,
+        TOUGHNESS_OF
+    };
+
+    Kind kind;
+    int value; // CONSTANT: the result, TYPE_COUNT: the mana color counted, if any
+    int multiplier;
+    bool halfup, halfdown, twice, thrice;
+    int bonus;
+    string argument; // target chooser or restrictions
+    string counterName;
+    int counterPower, counterToughness;
+    Property property;
+    bool highest;
+    const WParsedIntExpression * stored; // evaluated against the stored card
+
+    WParsedIntExpression(string s);
+    // rounding and bonus words, then the sign
+    int applyModifiers(int result) const;
+    int evaluateKind(Spell * spell, MTGCardInstance * card, MTGCardInstance * target, TargetChooser ** chooser) const;
+    TargetChooser * getChooser(MTGCardInstance * card, TargetChooser ** chooser) const;
+};
+
 class WParsedInt
 {
 public:
     int intValue;
 
-    int computeX(Spell * spell, MTGCardInstance * card)
+    static int computeX(Spell * spell, MTGCardInstance * card)
     {
         if (spell) return spell->computeX(card);
         if (card) return card->X;
         return 1; //this should only hapen when the ai calls the ability. This is to give it an idea of the "direction" of X (positive/negative)
     }
 
-private:
-    void init(string s, Spell * spell, MTGCardInstance * card)
-    {
-        if(!s.size())
-            return;
-        if(!card)
-            return;
-        MTGCardInstance * target = card->target;
-        if(!card->storedCard)
-            card->storedCard = card->storedSourceCard;
-        intValue = 0;
-        bool halfup = false;
-        bool halfdown = false;
-        bool twice = false;
-        bool thrice = false;
-        bool plusone = false;
-        bool plustwo = false;
-        bool plusthree = false;
-        if (!target) target = card;
-        int multiplier = 1;
-        if (s[0] == '-')
-        {
-            s = s.substr(1);
-            multiplier = -1;
-            if(s.find("stored") != string::npos)
-            {
-                string altered ="-";
-                altered.append(s.substr(+6));
-                return init(altered,spell,card->storedCard);
-            }
-        }
-        if(s[0] == '+')
-        {
-            //ignore "+" signs....
-            s = s.substr(1);
-        }
-        if(s.find("stored") != string::npos)
-        {
-            return init(s.substr(+6),spell,card->storedCard);
-        }
-        //rounding values, the words can be written anywhere in the line,
-        //they are erased after parsing.
-        if(s.find("halfup") != string::npos)
-        {
-            halfup = true;
-            size_t hU = s.find("halfup");
-            s.erase(hU,hU + 6);
-        }
-        if(s.find("halfdown") != string::npos)
-        {
-            halfdown = true;
-            size_t hD = s.find("halfdown");
-            s.erase(hD,hD + 8);
-        }
-        if(s.find("twice") != string::npos)
-        {
-            twice = true;
-            size_t tXX = s.find("twice");
-            s.erase(tXX,tXX + 5);
-        }
-        if(s.find("thrice") != string::npos)
-        {
-            thrice = true;
-            size_t tXXX = s.find("thrice");
-            s.erase(tXXX,tXXX + 6);
-        }
-        if(s.find("plusone") != string::npos)
-        {
-            plusone = true;
-            size_t pOne = s.find("plusone");
-            s.erase(pOne,pOne + 7);
-        }
-        if(s.find("plustwo") != string::npos)
-        {
-            plustwo = true;
-            size_t pTwo = s.find("plustwo");
-            s.erase(pTwo,pTwo + 7);
-        }
-        if(s.find("plusthree") != string::npos)
-        {
-            plusthree = true;
-            size_t pThree = s.find("plusthree");
-            s.erase(pThree,pThree + 9);
-        }
-        if(s == "prex")
-        {
-            ManaCost * cX = card->controller()->getManaPool()->Diff(card->getManaCost());
-            intValue = cX->getCost(Constants::NB_Colors);
-            delete cX;
-        }
-        else if (s == "x" || s == "X")
-        {
-            intValue = computeX(spell, card);
-            if(intValue < 0)
-                intValue = 0;
-        }
-        else if (s == "xx" || s == "XX")
-        {
-            intValue = computeX(spell, card) / 2;
-            if(intValue < 0)
-                intValue = 0;
-        }
-        else if (s == "castx")
-        {
-            intValue = card->castX;
-        }
-        else if (s == "gear")
-        {
-            intValue = target->equipment;
-        }
-        else if (s == "colors")
-        {
-            intValue = target->countColors();
-        }
-        else if (s == "auras")
-        {
-            intValue = target->auras;
-        }
-        else if (s == "manacost")
-        {
-            intValue = target->getManaCost()->getConvertedCost();
-        }
-        else if (s.find("type:") != string::npos)
-        {
-            size_t begins = s.find("type:");
-            string theType = s.substr(begins + 5);
-            size_t zoned = theType.find(":");
-            if(zoned == string::npos)
-            {
-                theType.append("|mybattlefield");
-            }
-            else
-            {
-                replace(theType.begin(), theType.end(), ':', '|');
-            }
-            int color = 0;
-            if (theType.find("mana") != string::npos) {
-                color = ManaCost::parseManaSymbol(theType[4]);
-                theType.replace(0, 5, "*");
-            }
-            TargetChooserFactory tf(card->getObserver());
-            TargetChooser * tc = tf.createTargetChooser(theType.c_str(),NULL);
-            for (int i = 0; i < 2; i++)
-            {
-                Player * p = card->getObserver()->players[i];
-                MTGGameZone * zones[] = { p->game->inPlay, p->game->graveyard, p->game->hand, p->game->library };
-                for (int k = 0; k < 4; k++)
-                {
-                    MTGGameZone * zone = zones[k];
-                    if (tc->targetsZone(zone, card))
-                    {
-                        if (color)
-                        {
-                            intValue += zone->countTotalManaSymbols(tc, color);
-                        }
-                        else
-                        {
-                            intValue += zone->countByCanTarget(tc);
-                        }
-                    }
-                }
-            }
-            SAFE_DELETE(tc);
-        }
-        else if (s.find("restriction{") != string::npos)
-        {
-            vector<string> splitRest = parseBetween(s,"restriction{","}");
-            if (splitRest.size())
-            {
-                AbilityFactory abf(target->getObserver());
-                int checkCond = abf.parseCastRestrictions(target,target->controller(),splitRest[1].c_str());
-                if(checkCond)
-                    intValue = 1;
-            }
-        }
-        else if (s.find("counter{") != string::npos)
-        {
-            intValue = 0;
-            vector<string>counterName = parseBetween(s,"counter{","}");
-            if(counterName.size())
-            {
-                AbilityFactory abf(target->getObserver());
-                Counter * counter = abf.parseCounter(counterName[1], NULL);
-                if(counter && target->counters && target->counters->hasCounter(counter->name.c_str(),counter->power,counter->toughness))
-                {
-                    Counter * targetCounter = target->counters->hasCounter(counter->name.c_str(), counter->power, counter->toughness);
-                    intValue = targetCounter->nb;
-                }
-                SAFE_DELETE(counter);
-            }
-        }
-        else if (s.find("convertedcost:") != string::npos || s.find("power:") != string::npos || s.find("toughness:") != string::npos)
-        {
-            bool powerCheck = false;
-            bool toughnessCheck = false;
-            bool costCheck = false;
-            intValue = 0;
-            vector<string>convertedType = parseBetween(s,"convertedcost:",":");
-            if(convertedType.size())
-                costCheck = true;
-            else
-            {
-                convertedType = parseBetween(s,"power:",":");
-                if(convertedType.size())
-                    powerCheck = true;
-                else
-                {
-                    convertedType = parseBetween(s,"toughness:",":");
-                    if(convertedType.size())
-                        toughnessCheck = true;
-                }
-            }
-            if(!convertedType.size())
-                return;
-            bool high = false;
-            int highest = 0;
-            int lowest = 5000;
-            if(convertedType[1].find("highest") != string::npos)
-                high = true;
-
-            string theType = convertedType[2];
-            size_t zoned = theType.find(":");
-            if(zoned == string::npos)
-            {
-                theType.append("|mybattlefield");
-            }
-            else
-            {
-                replace(theType.begin(), theType.end(), ':', '|');
-            }
-            TargetChooserFactory tf(card->getObserver());
-            TargetChooser * tc = tf.createTargetChooser(theType.c_str(),NULL);
-            int check = 0;
-            for (int i = 0; i < 2; i++)
-            {
-                Player * p = card->getObserver()->players[i];
-                MTGGameZone * zones[] = { p->game->battlefield, p->game->graveyard, p->game->hand, p->game->library };
-                for (int k = 0; k < 4; k++)
-                {
-                    MTGGameZone * zone = zones[k];
-                    if(tc->targetsZone(zone,target))
-                    {
-                        for(unsigned int w = 0;w < zone->cards.size();++w)
-                        {
-                            MTGCardInstance * cCard = zone->cards[w];
-                            if(tc->canTarget(cCard))
-                            {
-                                if(costCheck)
-                                    check = cCard->getManaCost()->getConvertedCost();
-                                if(powerCheck)
-                                    check = cCard->power;
-                                if(toughnessCheck)
-                                    check = cCard->toughness;
-
-                                if(check > highest)
-                                    highest = check;
-                                if(check <= lowest)
-                                    lowest = check;
-                            }
-                        }
-                    }
-                }
-            }
-            if(lowest == 5000)
-                lowest = 0;
-            SAFE_DELETE(tc);
-            intValue = high?highest:lowest;
-        }
-        else if (s == "sunburst")
-        {
-            intValue = 0;
-            if (card && card->previous && card->previous->previous)
-            {
-                intValue = card->previous->previous->sunburst;
-            }
-        }
-        else if (s == "targetedcurses")
-        {
-            if(card->playerTarget)
-                intValue = card->playerTarget->curses.size();
-        }
-        else if (s == "lifetotal")
-        {
-            intValue = target->controller()->life;
-        }
-        else if (s == "highestlifetotal")
-        {
-            intValue = target->controller()->life <= target->controller()->opponent()->life? target->controller()->opponent()->life:target->controller()->life;
-        }
-        else if (s == "lowestlifetotal")
-        {
-            intValue = target->controller()->life <= target->controller()->opponent()->life? target->controller()->life:target->controller()->opponent()->life;
-        }
-        else if (s == "thatmuch")
-        {
-            //the value that much is a variable to be used with triggered abilities.
-            //ie:when ever you gain life, draw that many cards. when used in a trigger draw:thatmuch, will return the value
-            //that the triggered event stored in the card for "that much".
-            intValue = 0;
-            intValue = target->thatmuch;
-            int checkagain = 0;
-            if(target->hasSubtype(Subtypes::TYPE_AURA) || target->hasSubtype(Subtypes::TYPE_EQUIPMENT))
-            {
-            if(target->target)
-            {
-            checkagain = target->target->thatmuch;
-            }
-            }
-            if(checkagain > intValue)
-                intValue = checkagain;
-            if(card && card->thatmuch > intValue)
-                intValue = card->thatmuch;
-        }
-        else if (s == "oplifelost")
-        {
-            intValue = target->controller()->opponent()->lifeLostThisTurn;
-        }
-        else if (s == "lifelost")
-        {
-            intValue = target->controller()->lifeLostThisTurn;
-        }
-        else if (s == "pdcount")
-        {
-            intValue = target->controller()->damageCount;
-        }
-        else if (s == "odcount")
-        {
-            intValue = target->controller()->opponent()->damageCount;
-        }
-        else if (s == "playerpoisoncount")
-        {
-            intValue = target->controller()->poisonCount;
-        }
-        else if (s == "opponentpoisoncount")
-        {
-            intValue = target->controller()->opponent()->poisonCount;
-        }
-        else if (s == "opponentlifetotal")
-        {
-            intValue = target->controller()->opponent()->life;
-        }
-        else if (s == "pdrewcount")
-        {
-            intValue = target->controller()->drawCounter;
-        }
-        else if (s == "odrewcount")
-        {
-            intValue = target->controller()->opponent()->drawCounter;
-        }
-        else if (s == "p" || s == "power")
-        {
-            intValue = target->getPower();
-        }
-        else if (s == "t" || s == "toughness")
-        {
-            intValue = target->getToughness();
-        }
-        else if (s == "kicked")
-        {
-            intValue = target->kicked;
-        }
-        else if (s == "handsize")
-        {
-            intValue = target->controller()->handsize;
-        }
-        else if (s == "controllerturn")//intvalue = 1 if its your turn this(variable{controllerturn})
-        {
-            intValue = 0;
-            if ( target->controller() == target->getObserver()->currentPlayer)
-                intValue = 1;
-        }
-        else if (s == "opponentturn")//intvalue = 1 if its your turn this(variable{opponentturn})
-        {
-            intValue = 0;
-            if ( target->controller()->opponent() == target->getObserver()->currentPlayer)
-                intValue = 1;
-        }
-        else if (s == "phandcount")
-        {
-            intValue = target->controller()->game->hand->nb_cards;
-        }
-        else if (s == "ohandcount")
-        {
-            intValue = target->controller()->opponent()->game->hand->nb_cards;
-        }
-        else
-        {
-            intValue = atoi(s.c_str());
-        }
-        if(intValue > 0)
-        {
-            if(halfup)
-            {
-                if(intValue%2 == 1)
-                    intValue++;
-                intValue = intValue/2;
-            }
-            if(halfdown)
-                intValue = intValue/2;
-            if(twice)
-                intValue = intValue*2;
-            if(thrice)
-                intValue = intValue*3;
-            if(plusone)
-                intValue = intValue+1;
-            if(plustwo)
-                intValue = intValue+2;
-            if(plusthree)
-                intValue = intValue+3;
-        }
-        else
-        {
-            if(plusone)
-                intValue = intValue+1;
-            if(plustwo)
-                intValue = intValue+2;
-            if(plusthree)
-                intValue = intValue+3;
-        }
-        intValue *= multiplier;
-    }
-public:
-
     WParsedInt(int value = 0)
     {
         intValue = value;
@@ -480,12 +145,12 @@ public:
 
     WParsedInt(string s, Spell * spell, MTGCardInstance * card)
     {
-        init(s, spell, card);
+        intValue = WParsedIntExpression::get(s)->evaluate(spell, card);
     }
 
     WParsedInt(string s, MTGCardInstance * card)
     {
-        init(s, NULL, card);
+        intValue = WParsedIntExpression::get(s)->evaluate(NULL, card);
     }
 
     int getValue()
@@ -509,23 +174,55 @@ public:
 
     WParsedPT(string s, Spell * spell, MTGCardInstance * card)
     {
-        size_t found = s.find("/");
-        ok = false;
-        if (found != string::npos)
+        string p, t;
+        ok = split(s, p, t);
+        if (ok)
         {
-            size_t end = s.find(" ", found);
-            if (end == string::npos) end = s.size();
-            size_t start = s.find_last_of(" ", found);
-            if (start == string::npos)
-                start = 0;
-            else
-                start++;
-            power = WParsedInt(s.substr(start, found - start), spell, card);
-            toughness = WParsedInt(s.substr(found + 1, end - found - 1), spell, card);
-
-            ok = true;
+            power = WParsedInt(p, spell, card);
+            toughness = WParsedInt(t, spell, card);
         }
     }
+
+    // Splits the "p/t" word of s
+    static bool split(const string& s, string& power, string& toughness)
+    {
+        size_t found = s.find("/");
+        if (found == string::npos)
+            return false;
+        size_t end = s.find(" ", found);
+        if (end == string::npos) end = s.size();
+        size_t start = s.find_last_of(" ", found);
+        if (start == string::npos)
+            start = 0;
+        else
+            start++;
+        power = s.substr(start, found - start);
+        toughness = s.substr(found + 1, end - found - 1);
+        return true;
+    }
+};
+
+// A "p/t" string compiled once, for the abilities that evaluate it again and again
+class WParsedPTExpression
+{
+public:
+    bool ok;
+
+    WParsedPTExpression(const string& s);
+    WParsedPTExpression(const WParsedPTExpression& other);
+    ~WParsedPTExpression();
+
+    bool isConstant() const;
+    void evaluate(WParsedPT& result, Spell * spell, MTGCardInstance * card);
+
+protected:
+    const WParsedIntExpression * power;
+    const WParsedIntExpression * toughness;
+    TargetChooser * powerChooser;
+    TargetChooser * toughnessChooser;
+
+private:
+    WParsedPTExpression& operator=(const WParsedPTExpression&);
 };
 
 //
@@ -2009,36 +1706,35 @@ public:
     WParsedPT * wppt;
     string PT;
     bool nonstatic;
+    WParsedPTExpression * expression; //PT compiled once, NULL without PT
     APowerToughnessModifier(GameObserver* observer, int id, MTGCardInstance * _source, MTGCardInstance * _target, WParsedPT * wppt,string PT,bool nonstatic) :
         MTGAbility(observer, id, _source, _target), wppt(wppt),PT(PT),nonstatic(nonstatic)
     {
         aType = MTGAbility::STANDARD_PUMP;
+        expression = PT.size() ? NEW WParsedPTExpression(PT) : NULL;
     }
     
         void Update(float)
         {
-            if(!nonstatic)
+            //a constant pump keeps the value it got in addToGame
+            if(!nonstatic || !expression || expression->isConstant())
+                return;
+            int oldPower = wppt->power.getValue();
+            int oldToughness = wppt->toughness.getValue();
+            expression->evaluate(*wppt, NULL, (MTGCardInstance *) source);
+            if(wppt->power.getValue() == oldPower && wppt->toughness.getValue() == oldToughness)
                 return;
-            ((MTGCardInstance *) target)->power -= wppt->power.getValue();
-            ((MTGCardInstance *) target)->addToToughness(-wppt->toughness.getValue());
-            if(PT.size())
-            {
-                SAFE_DELETE(wppt);
-                wppt = NEW WParsedPT(PT,NULL,(MTGCardInstance *) source);
-            }
             MTGCardInstance * _target = (MTGCardInstance *) target;
-            _target->power += wppt->power.getValue();
-            _target->addToToughness(wppt->toughness.getValue());
+            _target->power += wppt->power.getValue() - oldPower;
+            _target->addToToughness(wppt->toughness.getValue() - oldToughness);
+            game->stateChanged();
         }
         
     int addToGame()
     {
         MTGCardInstance * _target = (MTGCardInstance *) target;
-        if(PT.size())
-        {
-            SAFE_DELETE(wppt);
-            wppt = NEW WParsedPT(PT,NULL,(MTGCardInstance *) source);
-        }
+        if(expression)
+            expression->evaluate(*wppt, NULL, (MTGCardInstance *) source);
         _target->power += wppt->power.getValue();
         _target->addToToughness(wppt->toughness.getValue());
         if(_target->has(Constants::INDESTRUCTIBLE) && wppt->toughness.getValue() < 0 && _target->toughness <= 0)
@@ -2056,11 +1752,8 @@ public:
     }
     const char * getMenuText()
     {                
-        if(PT.size())
-        {
-            SAFE_DELETE(wppt);
-            wppt = NEW WParsedPT(PT,NULL,(MTGCardInstance *) source);
-        }
+        if(expression)
+            expression->evaluate(*wppt, NULL, (MTGCardInstance *) source);
         sprintf(menuText, "%i/%i", wppt->power.getValue(), wppt->toughness.getValue());
         return menuText;
     }
@@ -2068,12 +1761,15 @@ public:
     {
         APowerToughnessModifier * a = NEW APowerToughnessModifier(*this);
         a->wppt = NEW WParsedPT(*(a->wppt));
+        if(expression)
+            a->expression = NEW WParsedPTExpression(*expression);
         return a;
     }
 
     ~APowerToughnessModifier()
     {
         delete (wppt);
+        SAFE_DELETE(expression);
     }
 
 };
@@ -2368,12 +2064,15 @@ public:
         a = NULL;
     }
 
-    void Update(float dt)
+    void Update(float)
     {
-        ListMaintainerAbility::Update(dt);
+        if (!gameChanged())
+            return;
         if(!ability->oneShot) {
             SorterFunction();
         }
+        else
+            updateTargets();
     }
 
     void findMatchingAmount()
@@ -2427,8 +2126,7 @@ public:
             }
         }
         /////////////////////////////////////////////////////////////////////////
-        cards.clear();
-        players.clear();
+        //the list is kept between calls: updateTargets only adds and removes what changed
         return 1;
     }
 
@@ -2455,6 +2153,7 @@ public:
     int addAbilityToGame()
     {
         if (a) return 0;
+        game->stateChanged();
         a = ability->clone();
         if (a->oneShot)
         {
@@ -2471,6 +2170,7 @@ public:
     int removeAbilityFromGame()
     {
         if (!a) return 0;
+        game->stateChanged();
         game->removeObserver(a);
         a = NULL;
         return 1;
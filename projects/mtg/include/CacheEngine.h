@@ -1,7 +1,8 @@
 #include "PrecompiledHeader.h"
 
 #include "Threading.h"
-#include <queue>
+#include <deque>
+#include <map>
 #include <set>
 
 
@@ -11,17 +12,26 @@ struct CacheRequest
     {
     }
 
-    CacheRequest(std::string inFilename, int inSubmode, int inCacheID)
-        : filename(inFilename), submode(inSubmode), cacheID(inCacheID)
+    CacheRequest(std::string inFilename, int inSubmode, int inCacheID, int inPriority = PREFETCH_HIGH)
+        : filename(inFilename), submode(inSubmode), cacheID(inCacheID), priority(inPriority), queuedAt(JGEGetTime())
     {
     }
 
     std::string filename;
     int submode;
     int cacheID;
+    int priority;
+    int queuedAt;
 };
 
-const boost::posix_time::milliseconds kIdleTime(100);
+// upper bound on the number of decode workers, whatever the core count
+const unsigned int kMaxDecodeWorkers = 8;
+const size_t kMaxPendingUploads = 64;
+
+// capping the number of queued decodes per priority, 7 being
+// the maximum # of cards we display concurrently in the deck editor.
+// Past the cap, the oldest requests are demoted to the priority below.
+const unsigned int kMaxQueuedRequests[PREFETCH_PRIORITY_COUNT] = { 16, 16, 7 };
 
 
 class CardRetrieverBase
@@ -37,11 +47,40 @@ public:
     {
     }
 
-    virtual void QueueRequest(const std::string& inFilePath, int inSubmode, int inCacheID) = 0;
+    virtual void QueueRequest(const std::string& inFilePath, int inSubmode, int inCacheID, int inPriority = PREFETCH_HIGH) = 0;
+
+    /*
+    ** Removes a pending request. Returns false if it wasn't queued (or is already being decoded).
+    */
+    virtual bool CancelRequest(int inCacheID)
+    {
+        return false;
+    }
+
+    /*
+    ** Removes all pending requests strictly below inPriority.
+    */
+    virtual void CancelRequests(int inPriority)
+    {
+    }
+
+    virtual PrefetchStats GetStats()
+    {
+        return mStats;
+    }
+
+    /*
+    ** Hands over (at most inMax of) the ids of the textures decoded since the last call, so that
+    ** the UI thread can upload them to GL in one go.
+    */
+    virtual void TakeDecoded(std::vector<int>& outCacheIDs, unsigned int inMax)
+    {
+    }
 
 protected:
 
     WCache<WCachedTexture,JTexture>& mTextureCache;
+    PrefetchStats mStats;
 };
 
 /*
@@ -64,14 +103,31 @@ public:
     /*
     **  In a non-threaded model, simply pass on the request to the texture cache directly
     */
-    void QueueRequest(const std::string& inFilePath, int inSubmode, int inCacheID)
+    void QueueRequest(const std::string& inFilePath, int inSubmode, int inCacheID, int inPriority = PREFETCH_HIGH)
     {
-        mTextureCache.LoadIntoCache(inCacheID, inFilePath, inSubmode);
+        mStats.requested[inPriority]++;
+        if (mTextureCache.LoadIntoCache(inCacheID, inFilePath, inSubmode))
+            mStats.completed++;
+        else
+            mStats.failed++;
     }
 };
 
 /**
 ** Threaded implementation. 
+** A pool of workers (one per core, leaving one to the UI thread) decodes card images into the textures'
+** CPU buffers. Reading the file goes through JFileSystem, which only has one open file at a time, so it
+** is serialized by sLoadFunctionMutex; the decompression itself runs in parallel. The GL upload is
+** left to the UI thread, see TakeDecoded().
+**
+** Requests are kept in one FIFO per priority; the workers always serve the highest priority first.
+** mRequestLookup holds the live priority of every pending id: queue entries that don't match it
+** (cancelled, or re-queued at a higher priority) are stale and simply skipped when they reach the front.
+** When a priority is over its cap, its oldest requests (most likely scrolled out of view by now) move
+** down one priority; only the lowest priority drops requests.
+**
+** Idle workers block on mWorkAvailable, which QueueRequest signals, so a request is picked up as soon as
+** it is queued.
 */
 class ThreadedCardRetriever : public CardRetrieverBase
 {
@@ -81,93 +137,316 @@ public:
         : CardRetrieverBase(inCache), mProcessing(true)
     {
         DebugTrace("Threaded Version");
-        mWorkerThread = boost::thread(ThreadProc, this);
+        for (int i = 0; i < PREFETCH_PRIORITY_COUNT; ++i)
+            mPendingCount[i] = 0;
+
+        unsigned int workerCount = boost::thread::hardware_concurrency();
+        workerCount = (workerCount > 1) ? workerCount - 1 : 1;
+        if (workerCount > kMaxDecodeWorkers)
+            workerCount = kMaxDecodeWorkers;
+
+        DebugTrace("Starting " << workerCount << " decode workers");
+        for (unsigned int i = 0; i < workerCount; ++i)
+            mWorkerThreads.push_back(NEW boost::thread(ThreadProc, this));
     }
 
     virtual ~ThreadedCardRetriever()
     {
         LOG("Tearing down ThreadedCardRetriever");
-        mProcessing = false;
-        mWorkerThread.join();
+        {
+            boost::mutex::scoped_lock lock(mMutex);
+            mProcessing = false;
+            mWorkAvailable.notify_all();
+        }
+        for (size_t i = 0; i < mWorkerThreads.size(); ++i)
+        {
+            mWorkerThreads[i]->join();
+            SAFE_DELETE(mWorkerThreads[i]);
+        }
     }
 
-    void QueueRequest(const std::string& inFilePath, int inSubmode, int inCacheID)
+    void QueueRequest(const std::string& inFilePath, int inSubmode, int inCacheID, int inPriority = PREFETCH_HIGH)
     {
+        if (inPriority < PREFETCH_LOW) inPriority = PREFETCH_LOW;
+        if (inPriority > PREFETCH_HIGH) inPriority = PREFETCH_HIGH;
+
         boost::mutex::scoped_lock lock(mMutex);
+        mStats.requested[inPriority]++;
+
         // mRequestLookup is used to prevent duplicate requests for the same id
-        if (mRequestLookup.find(inCacheID) == mRequestLookup.end() && mTextureCache.cache.find(inCacheID) == mTextureCache.cache.end())
+        std::map<int, int>::iterator it = mRequestLookup.find(inCacheID);
+        if (mInFlight.find(inCacheID) != mInFlight.end() || (it != mRequestLookup.end() && it->second >= inPriority))
         {
+            mStats.duplicates++;
+            return;
+        }
+
+        {
+            boost::mutex::scoped_lock cacheLock(sCacheMutex);
+            if (mTextureCache.cache.find(inCacheID) != mTextureCache.cache.end())
+            {
+                mStats.alreadyCached++;
+                return;
+            }
+        }
+
 #ifdef DOLOG
-            std::ostringstream stream;
-            stream << "Queueing request: " << inFilePath;
-            LOG(stream.str().c_str());
+        std::ostringstream stream;
+        stream << "Queueing request: " << inFilePath << " priority " << inPriority;
+        LOG(stream.str().c_str());
 #endif
-            mRequestLookup.insert(inCacheID);
-            mRequestQueue.push(CacheRequest(inFilePath, inSubmode, inCacheID));
+        if (it != mRequestLookup.end())
+        {
+            // upgrade: the entry in the lower priority queue becomes stale
+            mPendingCount[it->second]--;
+            it->second = inPriority;
+        }
+        else
+        {
+            mRequestLookup[inCacheID] = inPriority;
+        }
+        mPendingCount[inPriority]++;
+        mRequestQueues[inPriority].push_back(CacheRequest(inFilePath, inSubmode, inCacheID, inPriority));
 
-            // capping the number of queued decodes to 7, as this is 
-            // the maximum # of cards we display concurrently in the deck editor.
-            if (mRequestQueue.size() > 7)
+        for (int priority = inPriority; priority >= PREFETCH_LOW; --priority)
+        {
+            CacheRequest request;
+            while (mPendingCount[priority] > kMaxQueuedRequests[priority] && PopFront(priority, request))
             {
-                int cacheIDToRemove;
-                while (mRequestQueue.size() > 7)
+                if (priority == PREFETCH_LOW)
                 {
-                    // pop the older requests out of the queue
-                    cacheIDToRemove = mRequestQueue.front().cacheID;
-                    mRequestQueue.pop();
-                    mRequestLookup.erase(cacheIDToRemove);
-
-                    assert(mRequestLookup.size() - mRequestQueue.size() < 2);
+                    mStats.dropped++;
+                    continue;
                 }
+                request.priority = priority - 1;
+                mRequestLookup[request.cacheID] = request.priority;
+                mPendingCount[request.priority]++;
+                mRequestQueues[request.priority].push_back(request);
+                mStats.demoted++;
             }
         }
+
+        unsigned int depth = PendingCount();
+        if (depth > mStats.maxQueueDepth)
+            mStats.maxQueueDepth = depth;
+
+        mWorkAvailable.notify_one();
+    }
+
+    bool CancelRequest(int inCacheID)
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        std::map<int, int>::iterator it = mRequestLookup.find(inCacheID);
+        if (it == mRequestLookup.end())
+            return false;
+
+        mPendingCount[it->second]--;
+        mRequestLookup.erase(it);
+        mStats.cancelled++;
+        return true;
+    }
+
+    void CancelRequests(int inPriority)
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        std::map<int, int>::iterator it = mRequestLookup.begin();
+        while (it != mRequestLookup.end())
+        {
+            if (it->second < inPriority)
+            {
+                mPendingCount[it->second]--;
+                mRequestLookup.erase(it++);
+                mStats.cancelled++;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        for (int i = 0; i < inPriority && i < PREFETCH_PRIORITY_COUNT; ++i)
+            mRequestQueues[i].clear();
+    }
+
+    PrefetchStats GetStats()
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        mStats.queueDepth = PendingCount();
+        return mStats;
+    }
+
+    void TakeDecoded(std::vector<int>& outCacheIDs, unsigned int inMax)
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        while (!mDecoded.empty() && outCacheIDs.size() < inMax)
+        {
+            outCacheIDs.push_back(mDecoded.front());
+            mDecoded.pop_front();
+        }
     }
 
 protected:
     ThreadedCardRetriever();
 
+    /*
+    ** Number of live requests waiting for a worker. Call with mMutex held.
+    */
+    unsigned int PendingCount() const
+    {
+        unsigned int count = 0;
+        for (int i = 0; i < PREFETCH_PRIORITY_COUNT; ++i)
+            count += mPendingCount[i];
+        return count;
+    }
+
+    /*
+    ** Pops the oldest live request of a given priority, discarding stale entries. Call with mMutex held.
+    */
+    bool PopFront(int inPriority, CacheRequest& outRequest)
+    {
+        std::deque<CacheRequest>& queue = mRequestQueues[inPriority];
+        while (!queue.empty())
+        {
+            outRequest = queue.front();
+            queue.pop_front();
+
+            std::map<int, int>::iterator it = mRequestLookup.find(outRequest.cacheID);
+            if (it != mRequestLookup.end() && it->second == inPriority)
+            {
+                mRequestLookup.erase(it);
+                mPendingCount[inPriority]--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+    ** Pops the next request to decode, highest priority first. Call with mMutex held.
+    */
+    bool PopNext(CacheRequest& outRequest)
+    {
+        for (int i = PREFETCH_PRIORITY_COUNT - 1; i >= 0; --i)
+        {
+            if (PopFront(i, outRequest))
+                return true;
+        }
+        return false;
+    }
+
+    /*
+    ** Reads the image file under the JFileSystem lock, then decodes it without holding any lock.
+    */
+    bool Decode(const CacheRequest& inRequest)
+    {
+        std::string realname;
+        u8* rawdata = NULL;
+        int rawsize = 0;
+        {
+            boost::mutex::scoped_lock functionLock(sLoadFunctionMutex);
+            realname = WCachedTexture::RealFilename(inRequest.filename, inRequest.submode);
+
+            JFileSystem* fileSystem = JFileSystem::GetInstance();
+            if (realname.size() && fileSystem->OpenFile(realname))
+            {
+                rawsize = fileSystem->GetFileSize();
+                rawdata = NEW u8[rawsize];
+                fileSystem->ReadFile(rawdata, rawsize);
+                fileSystem->CloseFile();
+            }
+        }
+
+        WCachedTexture* item = NULL;
+        if (rawdata)
+        {
+            int error = CACHE_ERROR_NONE;
+            item = NEW WCachedTexture;
+            if (!item->Attempt(inRequest.filename, realname, inRequest.submode, rawdata, rawsize, error))
+                SAFE_DELETE(item);
+            SAFE_DELETE_ARRAY(rawdata);
+        }
+
+        // missing file, or no in-memory decoder for this format: let the cache load it the
+        // usual way (serialized), which also takes care of recording the miss.
+        if (!item)
+            return mTextureCache.LoadIntoCache(inRequest.cacheID, inRequest.filename, inRequest.submode) != NULL;
+
+        return mTextureCache.InsertIntoCache(inRequest.cacheID, item) != NULL;
+    }
+
     static void ThreadProc(void* inParam)
     {
+        JLogger::SetThreadTag("decode");
         LOG("Entering ThreadedCardRetriever::ThreadProc");
         ThreadedCardRetriever* instance = reinterpret_cast<ThreadedCardRetriever*>(inParam);
         if (instance)
         {
-            while (instance->mProcessing)
+            while (true)
             {
-                while (!instance->mRequestQueue.empty())
+                CacheRequest request;
                 {
-                    CacheRequest request;
-                    {
-                        boost::mutex::scoped_lock lock(instance->mMutex);
-                        request = instance->mRequestQueue.front();
-                        instance->mRequestQueue.pop();
-                    }
+                    boost::mutex::scoped_lock lock(instance->mMutex);
+                    while (instance->mProcessing && !instance->PopNext(request))
+                        instance->mWorkAvailable.wait(lock);
 
-                    instance->mTextureCache.LoadIntoCache(request.cacheID, request.filename, request.submode);
+                    if (!instance->mProcessing)
+                        break;
+                    instance->mInFlight.insert(request.cacheID);
+                }
+
+                int startTime = JGEGetTime();
+                bool success = instance->Decode(request);
+                int endTime = JGEGetTime();
 
+                {
+                    boost::mutex::scoped_lock lock(instance->mMutex);
+                    instance->mInFlight.erase(request.cacheID);
+                    if (success)
                     {
-                        boost::mutex::scoped_lock lock(instance->mMutex);
-                        instance->mRequestLookup.erase(request.cacheID);
+                        // nobody flushing (no rendering): the JQuad will upload it lazily anyway
+                        if (instance->mDecoded.size() >= kMaxPendingUploads)
+                            instance->mDecoded.pop_front();
+                        instance->mDecoded.push_back(request.cacheID);
                     }
 
-                    // not sure this is necessary, adding it to potentially prevent SIGHUP on the psp
-                    // rumour has it that if a worker thread doesn't allow the main thread a chance to run, it can hang the unit
-#ifdef PSP
-                    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
-#endif
+                    PrefetchStats::Record record;
+                    record.cacheID = request.cacheID;
+                    record.priority = request.priority;
+                    record.waitTime = startTime - request.queuedAt;
+                    record.decodeTime = endTime - startTime;
+                    record.success = success;
+
+                    PrefetchStats& stats = instance->mStats;
+                    stats.AddRecord(record);
+                    stats.totalWaitTime += record.waitTime;
+                    stats.totalDecodeTime += record.decodeTime;
+                    if (record.waitTime + record.decodeTime > (int) stats.maxLatency)
+                        stats.maxLatency = record.waitTime + record.decodeTime;
+                    if (success)
+                        stats.completed++;
+                    else
+                        stats.failed++;
                 }
 
-                boost::this_thread::sleep(kIdleTime);
+                // not sure this is necessary, adding it to potentially prevent SIGHUP on the psp
+                // rumour has it that if a worker thread doesn't allow the main thread a chance to run, it can hang the unit
+#ifdef PSP
+                boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+#endif
             }
         }
     }
 
-    boost::thread mWorkerThread;
+    std::vector<boost::thread*> mWorkerThreads;
 
-    std::queue<CacheRequest> mRequestQueue;
-    std::set<int> mRequestLookup;
+    std::deque<CacheRequest> mRequestQueues[PREFETCH_PRIORITY_COUNT];
+    std::map<int, int> mRequestLookup;
+    unsigned int mPendingCount[PREFETCH_PRIORITY_COUNT];
+    std::set<int> mInFlight;
+    std::deque<int> mDecoded;
     boost::mutex mMutex;
-    volatile bool mProcessing;
+    boost::condition_variable mWorkAvailable;
+    bool mProcessing;
 
 };
 
@@ -2,6 +2,8 @@
  * For MTG we have thousands of those, that stay constantly in Ram
  * on low-end devices such as the PSP, adding stuff to this class can have a very high cost
  * As an example, with 16'000 card primitives (the rough number of cards in MTG), adding a simple 16 bytes attribute costs 250kB (2% of the total available ram on the PSP)
+ * This is why the rules text, abilities and target of the primitives of the database are left in their card file
+ * until a card needs them: see loadDetails.
  */
 #ifndef _CARDPRIMITIVE_H_
 #define _CARDPRIMITIVE_H_
@@ -42,12 +44,20 @@ class CardPrimitive
     : public InstanceCounter<CardPrimitive>
 #endif
 {
+    friend class MTGAllCards;
 private:
     CastRestrictions * restrictions;
 
 protected:
     string lcname;
     ManaCost manaCost;
+    //Where MTGAllCards::load left text, magicText, magicTexts and spellTargetType: index of the card file and
+    //position of the card in it. detailsFile is -1 once they are in memory.
+    int detailsFile;
+    unsigned int detailsOffset;
+
+    //After a plain copy, gives the copy restrictions of its own, so that each deletes its own
+    void unshareRestrictions();
 
 public:
     vector<string> formattedText;
@@ -73,6 +83,19 @@ public:
     CardPrimitive(CardPrimitive * source);
     virtual ~CardPrimitive();
 
+    //Reads the rules text, abilities and target from the card file if they are still there.
+    //Anything reading them from a primitive of the database, rather than from a card instance, calls this first.
+    void loadDetails()
+    {
+        if (detailsFile >= 0)
+            readDetails();
+    }
+    const string& getMagicText()
+    {
+        loadDetails();
+        return magicText;
+    }
+
     void setColor(int _color, int removeAllOthers = 0);
     void setColor(const string& _color, int removeAllOthers = 0);
     void removeColor(int color);
@@ -120,6 +143,9 @@ public:
     const string getRestrictions();
     void setOtherRestrictions(string _restriction);
     const string getOtherRestrictions();
+
+private:
+    void readDetails();
 };
 
 
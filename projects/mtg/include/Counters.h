@@ -1,6 +1,7 @@
 #ifndef _COUNTERS_H_
 #define _COUNTERS_H_
 #include <string>
+#include <stdint.h>
 
 using std::string;
 class MTGCardInstance;
@@ -31,6 +32,8 @@ public:
     int mCount;
    vector<Counter *>counters;
     MTGCardInstance * target;
+    // xor of the keys of the counters, see StateHash
+    uint64_t stateHash;
     Counters(MTGCardInstance * _target);
     ~Counters();
     int addCounter(const char * _name, int _power = 0, int _toughness = 0);
@@ -41,6 +44,7 @@ public:
     Counter * hasCounter(int _power, int _toughness);
     Counter * getNext(Counter * previous = NULL);
     int init();
+    void updateStateHash();
 };
 
 #endif
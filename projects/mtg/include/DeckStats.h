@@ -6,6 +6,7 @@
 #include <vector>
 #include "MTGDefinitions.h"
 #include <DeckDataWrapper.h>
+#include <Threading.h>
 
 using namespace std;
 
@@ -23,11 +24,26 @@ public:
     int percentVictories();
 };
 
+/*
+ Victories of the player decks against each AI deck, one stats file per player deck.
+ A game is recorded by appending one line to the journal of the stats file (same name, .log). The stats file
+ itself is only rewritten once the journal holds JOURNAL_MAX_GAMES games, and loading a stats file replays its
+ journal. All the loading and saving is serialized, for the games running in several threads.
+ */
 class DeckStats
 {
 protected:
     static DeckStats * mInstance;
+    boost::recursive_mutex mMutex;
+    // games in the journal of each loaded stats file. No entry: the stats file doesn't exist yet
+    map<string, int> journalSizes;
+
+    static string journalFile(const string& filename);
+    void loadJournal(const string& filename);
+    void addGame(const string& filename, const string& opponentsFile, int victory, const string& manaColorIndex);
 public:
+    enum { JOURNAL_MAX_GAMES = 64 };
+
     string currentDeck;
     map<string, map<string, DeckStat*> > masterDeckStats;
     
@@ -83,6 +99,14 @@ public:
     float noLandsProbInTurn[Constants::STATS_FOR_TURNS];
     float noCreaturesProbInTurn[Constants::STATS_FOR_TURNS];
 
+    // Goldfish games, see GoldfishSimulator. Played by simulate, only when they are looked at
+    bool simulationNeedUpdate;
+    int simulatedGames;
+    float mulliganProb;
+    float spellCastByTurn[Constants::STATS_FOR_TURNS];
+    float colorScrewProbInTurn[Constants::STATS_FOR_TURNS];
+    float manaUsedInTurn[Constants::STATS_FOR_TURNS]; //percentage of the lands in play
+
     int countCardsPerCost[Constants::STATS_MAX_MANA_COST + 1];
     int countCardsPerCostAndColor[Constants::STATS_MAX_MANA_COST + 1][Constants::MTG_NB_COLORS + 1];
     int countCreaturesPerCost[Constants::STATS_MAX_MANA_COST + 1];
@@ -98,6 +122,7 @@ public:
     string getManaColorIndex();
     void updateStats(string filename, MTGAllCards * collection);
     void updateStats(DeckDataWrapper *mtgDeck);
+    void simulate(DeckDataWrapper *mtgDeck);
     int countCardsByType(const char * _type, DeckDataWrapper * myDeck);
     float noLuck(int n, int a, int x);
 
@@ -10,8 +10,10 @@
 #include "PhaseRing.h"
 #include "ReplacementEffects.h"
 #include "GuiStatic.h"
+#include "MemoryPool.h"
 #include <queue>
 #include <time.h>
+#include <stdint.h>
 #ifdef NETWORK_SUPPORT
 #include "JNetwork.h"
 #endif //NETWORK_SUPPORT
@@ -43,8 +45,10 @@ class GameObserver{
   WResourceManager* mResourceManager;
   JGE* mJGE;
   DeckManager* mDeckManager;
+  MemoryPool* mPool; //events, abilities and cards of this game
   Player * gameOver;
   GamePhase mCurrentGamePhase;
+  unsigned long mStateVersion;
 
   int untap(MTGCardInstance * card);
   bool WaitForExtraPayment(MTGCardInstance* card);
@@ -89,6 +93,7 @@ class GameObserver{
   Trash* mTrash;
 
   GameType gameType() const { return mGameType; };
+  MemoryPool* getPool() { return mPool; };
   TargetChooser * getCurrentTargetChooser();
   void stackObjectClicked(Interruptible * action);
 
@@ -157,6 +162,13 @@ class GameObserver{
   WResourceManager* getResourceManager() { if(this) return mResourceManager;else return 0;};
   CardSelectorBase* getCardSelector() { return mLayers->getCardSelector();};
   bool operator==(const GameObserver& aGame);
+  // 64 bits Zobrist hash of the phase, the players, their zones, the cards with their counters and the stack.
+  // Zones keep the hash of their cards up to date as they change, so this is O(1) in the size of the game.
+  uint64_t getStateHash();
+  // Changes whenever the game may have changed: with every event, and when continuous effects change cards.
+  // Effects that only depend on the state of the game can skip their work while it stays the same.
+  unsigned long getStateVersion() { return mStateVersion; };
+  void stateChanged() { mStateVersion++; };
   JGE* getInput(){return mJGE;};
   DeckManager* getDeckManager(){ return mDeckManager; };
   void dumpAssert(bool val);
@@ -186,13 +198,40 @@ class GameObserver{
 };
 
 #ifdef NETWORK_SUPPORT
+/*
+ Both sides play the game locally and only exchange the actions they log.
+ Every HASH_INTERVAL actions, each side records the hash of its game; the server sends its own to the client,
+ which compares them and asks for a full snapshot of the server's game when they differ.
+ What goes over the network and what is computed per action does not depend on the length of the game,
+ only a divergence costs a snapshot.
+ */
 class NetworkGameObserver : public GameObserver
 {
 protected:
+	enum
+	{
+		HASH_INTERVAL = 8,
+		HASH_HISTORY = 8
+	};
+
+	struct Checkpoint
+	{
+		size_t actions;
+		uint64_t hash;
+	};
+
 	JNetwork* mpNetworkSession;
 	bool mSynchronized;
 	bool mForwardAction;
+	bool mSnapshotPending;
+	// hashes of this game and of the server's one, oldest first
+	deque<Checkpoint> mLocalHashes;
+	deque<Checkpoint> mRemoteHashes;
 	virtual void logAction(const string& s);
+	void addCheckpoint();
+	void compareHashes();
+	static void parseCheckpoint(stringstream& in, Checkpoint& checkpoint);
+	static void writeCheckpoint(stringstream& out, const Checkpoint& checkpoint);
 public:
 	// no serverIp means a server is being instantiated, otherwise a client
 	NetworkGameObserver(JNetwork* pNetwork, WResourceManager* output = 0, JGE* input = 0);
@@ -204,8 +243,13 @@ public:
 	static void sendAction(void*pThis, stringstream& in, stringstream& out);
 	static void synchronize(void*pThis, stringstream& in, stringstream& out);
 	static void checkSynchro(void*pxThis, stringstream& in, stringstream& out);
+	static void stateHash(void*pxThis, stringstream& in, stringstream& out);
+	static void requestSnapshot(void*pxThis, stringstream& in, stringstream& out);
+	static void loadSnapshot(void*pxThis, stringstream& in, stringstream& out);
     static void ignoreResponse(void*, stringstream&, stringstream&){};
 	static void disconnect(void*pxThis, stringstream& in, stringstream& out);
+
+	unsigned long hashesSent, snapshotsLoaded;
 };
 #endif
 
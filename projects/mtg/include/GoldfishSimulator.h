@@ -0,0 +1,81 @@
+#ifndef _GOLDFISHSIMULATOR_H_
+#define _GOLDFISHSIMULATOR_H_
+
+#include <vector>
+#include "MTGDefinitions.h"
+
+class DeckDataWrapper;
+
+/*
+ Goldfish games of a deck: shuffle, draw an opening hand, mulligan it if needed, then play alone for
+ STATS_FOR_TURNS turns (on the play), one land per turn and as many spells of the hand as the lands can pay for,
+ most expensive first.
+ Games are split between worker threads, each with its own random generator and counters, merged at the end.
+ Only the first cards of the library are shuffled, since a game never sees the rest.
+ Mana only comes from lands, and hybrid symbols count as generic mana.
+ */
+class GoldfishSimulator
+{
+public:
+    enum
+    {
+#if defined(PSP)
+        DEFAULT_GAMES = 10000,
+#elif defined(ANDROID) || defined(IOS)
+        DEFAULT_GAMES = 100000,
+#else
+        DEFAULT_GAMES = 1000000,
+#endif
+        MAX_THREADS = 8
+    };
+
+    struct Results
+    {
+        int games;
+        int mulligans; //games that took at least one mulligan
+        int spellCastBy[Constants::STATS_FOR_TURNS]; //games that cast a spell on or before each turn
+        int colorScrewed[Constants::STATS_FOR_TURNS]; //games with a spell the lands could pay for but for its colors
+        int manaUsed[Constants::STATS_FOR_TURNS];
+        int manaAvailable[Constants::STATS_FOR_TURNS];
+
+        Results();
+        void add(const Results& other);
+    };
+
+    GoldfishSimulator(DeckDataWrapper * deck);
+
+    void run(Results& results, int games = DEFAULT_GAMES, unsigned int seed = 0);
+
+protected:
+    enum
+    {
+        NB_MANA_COLORS = 5, //green to white
+        COLOR_MASKS = 1 << NB_MANA_COLORS
+    };
+
+    struct Card
+    {
+        bool land;
+        int producedColors; //lands: mask of the colors they can add
+        int cost; //converted mana cost
+        int needs[NB_MANA_COLORS]; //colored symbols of the cost
+        int neededColors; //mask of the colors of the cost
+    };
+
+    struct Worker
+    {
+        const GoldfishSimulator * simulator;
+        int games;
+        unsigned int seed;
+        Results results;
+    };
+
+    std::vector<Card> cards;
+    std::vector<int> library; //one entry per copy, index in cards
+
+    static void ThreadProc(void * inParam);
+    void play(int games, unsigned int seed, Results& results) const;
+    static bool canPay(const int supply[COLOR_MASKS], int lands, const int needs[NB_MANA_COLORS], int neededColors, int cost);
+};
+
+#endif
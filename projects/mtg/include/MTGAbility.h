@@ -16,6 +16,7 @@ class Counter;
 
 #include "GameObserver.h"
 #include "ActionElement.h"
+#include "MemoryPool.h"
 #include <string>
 #include <map>
 #include <hge/hgeparticle.h>
@@ -40,7 +41,7 @@ using std::map;
 #define PARSER_FOREACH 2
 #define PARSER_ASLONGAS 3
 
-class MTGAbility : public ActionElement
+class MTGAbility : public ActionElement, public PoolAllocated
 {
 private:
      ManaCost* mCost;
@@ -339,25 +340,37 @@ public:
     virtual ostream& toString(ostream& out) const;
 };
 
-/* State based effects. This class works ONLY for InPlay and needs to be extended for other areas of the game !!! */
+/*
+ State based effects. This class works ONLY for InPlay and needs to be extended for other areas of the game !!!
+ The list is only looked at again when the state version of the game moved: it changes with every event, and when a
+ list maintainer adds or removes cards, so effects that depend on each other still settle. Only the zones the
+ TargetChooser can target are scanned.
+ */
 class ListMaintainerAbility:public MTGAbility
 {
+protected:
+    unsigned long listVersion; //state version of the game the list was last updated for
+    bool listUpToDate;
+
+    // true if the list needs to be updated, and considers it done
+    bool gameChanged();
+
 public:
     map<MTGCardInstance *,bool> cards;
     map<MTGCardInstance *,bool> checkCards;
     map<Player *,bool> players;
     ListMaintainerAbility(GameObserver* observer, int _id)
-        : MTGAbility(observer, _id, NULL)
+        : MTGAbility(observer, _id, NULL), listVersion(0), listUpToDate(false)
     {
     }
 
     ListMaintainerAbility(GameObserver* observer, int _id, MTGCardInstance *_source)
-        : MTGAbility(observer, _id, _source)
+        : MTGAbility(observer, _id, _source), listVersion(0), listUpToDate(false)
     {
     }
 
     ListMaintainerAbility(GameObserver* observer, int _id, MTGCardInstance *_source,Damageable * _target)
-        : MTGAbility(observer, _id, _source, _target)
+        : MTGAbility(observer, _id, _source, _target), listVersion(0), listUpToDate(false)
     {
     }
 
@@ -9,6 +9,7 @@
 #include "ManaCost.h"
 #include "Damage.h"
 #include "Targetable.h"
+#include "MemoryPool.h"
 
 
 class MTGCardInstance;
@@ -22,9 +23,10 @@ class Counters;
 struct Pos;
 
 #include <list>
+#include <stdint.h>
 using namespace std;
 
-class MTGCardInstance: public CardPrimitive, public MTGCard, public Damageable
+class MTGCardInstance: public CardPrimitive, public MTGCard, public Damageable, public PoolAllocated
 #ifdef TRACK_OBJECT_USAGE
     , public InstanceCounter<MTGCardInstance>
 #endif
@@ -38,6 +40,7 @@ protected:
     string sample;
     int tapped;
     int lifeOrig;
+    uint64_t mStateHash;
     MTGPlayerCards * belongs_to;
     MTGCardInstance * getNextPartner();
     void initMTGCI();
@@ -52,6 +55,8 @@ public:
     int setAttacker(int value);
     int setDefenser(MTGCardInstance * c);
     MTGGameZone * currentZone;
+    // zone whose state hash includes this card, see StateHash
+    MTGGameZone * hashedZone;
     Pos* view;
     int X;
     int castX;
@@ -214,6 +219,10 @@ public:
     void tap();
     void attemptUntap();
 
+    // Keys of the card, its tapped state and its counters, kept up to date in the hash of its zone
+    uint64_t getStateHash() { return mStateHash; };
+    void updateStateHash();
+
     void eventattacked();
     void eventattackedAlone();
     void eventattackednotblocked();
@@ -10,12 +10,15 @@
 #include <Threading.h>
 #include <Subtypes.h>
 #include <string>
+#include <time.h>
+#include <boost/shared_ptr.hpp>
 
 using std::string;
 class GameApp;
 class MTGCard;
 class CardPrimitive;
 class MTGPack;
+class AIHint;
 class MTGSetInfo
 {
 public:
@@ -128,6 +131,27 @@ public:
     void loadFolder(const string& folder, const string& filename="" );
 
     int load(const char * config_file, const char * setName = NULL, int autoload = 1);
+
+    /*
+     Few of the cards of the database are ever played or displayed, so load only keeps the rules text, the abilities
+     and the target of the primitives where they are in the card files (see CardPrimitive::loadDetails).
+     Reading them for several primitives at once goes through each file once, in order.
+     */
+    class DetailsVisitor
+    {
+    public:
+        virtual ~DetailsVisitor()
+        {
+        }
+        ;
+        //details only lasts for the call. It is primitive itself when it was already loaded.
+        virtual void visit(CardPrimitive * primitive, CardPrimitive * details) = 0;
+    };
+    void loadDetails(CardPrimitive * primitive);
+    void loadDetails(const vector<CardPrimitive *>& primitives);
+    //Gives the details of the primitives without keeping them, for the ones that were not loaded yet
+    void visitDetails(const vector<CardPrimitive *>& primitives, DetailsVisitor& visitor);
+
     int countByType(const char * _type);
     int countByColor(int color);
     int countBySet(int setId);
@@ -190,13 +214,64 @@ private:
     boost::mutex mMutex;
     Subtypes subtypesList;
     map<string, MTGCard *> mtgCardByNameCache;
+    boost::mutex mDetailsMutex;
+    vector<string> detailsFiles; //Card files loaded, by index
     int processConfLine(string &s, MTGCard* card, CardPrimitive * primitive);
+    static bool isDetailsLine(const string& s);
+    static bool detailsBefore(CardPrimitive * a, CardPrimitive * b);
+    void readDetails(vector<CardPrimitive *> primitives, DetailsVisitor * visitor);
     bool addCardToCollection(MTGCard * card, int setId);
     CardPrimitive * addPrimitive(CardPrimitive * primitive, MTGCard * card = NULL);
 };
 
 #define MTGCollection() MTGAllCards::getInstance()
 
+/*
+ Contents of a deck file, with the cards resolved to ids and the AI hints already parsed.
+ Deck files that are loaded again and again (AI decks are rebuilt for every game) are kept in a cache
+ keyed by path and modification time, and shared by every MTGDeck built from them.
+ A list is never modified once built.
+*/
+class MTGDeckList
+{
+public:
+    typedef boost::shared_ptr<const MTGDeckList> Ptr;
+
+    struct Line
+    {
+        int copies;
+        int cardId;
+        int hardCardId; //differs from cardId for "toggledifficulty:" lines
+    };
+
+    string name; //empty if the file has no NAME: line
+    string desc;
+    vector<string> hintLines;
+    vector<boost::shared_ptr<AIHint> > hints;
+    string unlockRequirements;
+    vector<Line> lines;
+
+    //Returns the cached list for this file, parsing it if needed. NULL if the file can't be read.
+    //metaOnly lists stop at the first card line and resolve nothing.
+    static Ptr get(const string& filename, MTGAllCards * database, bool metaOnly = false);
+    //Drops a file from the cache, for files that just got written
+    static void forget(const string& filename);
+    static void clearCache();
+
+private:
+    static MTGDeckList * parse(const string& contents, MTGAllCards * database, bool metaOnly);
+
+    struct CacheEntry
+    {
+        time_t lastModified;
+        MTGAllCards * database;
+        Ptr list;
+    };
+    static map<string, CacheEntry> sCache;
+    static map<string, CacheEntry> sMetaCache;
+    static boost::mutex sCacheMutex;
+};
+
 class MTGDeck
 {
 private:
@@ -205,6 +280,7 @@ private:
 protected:
     string filename;
     int total_cards;
+    MTGDeckList::Ptr mList;
 
 public:
     MTGAllCards * database;
@@ -219,6 +295,8 @@ public:
     int totalPrice();
     MTGDeck(MTGAllCards * _allcards);
     MTGDeck(const char * config_file, MTGAllCards * _allcards, int meta_only = 0,int difficultySetting = 0);
+    //Pre-parsed AI hints of the deck file, same order as meta_AIHints
+    const vector<boost::shared_ptr<AIHint> >& getAIHints();
     int addRandomCards(int howmany, int * setIds = NULL, int nbSets = 0, int rarity = -1, const char * subtype = NULL,
             int * colors = NULL, int nbcolors = 0);
     int add(int cardid);
@@ -84,6 +84,8 @@ class MTGGameZone {
     //list of cards that have been through this zone in the last turn
     vector<MTGCardInstance *> cardsSeenLastTurn;
    int nb_cards;
+   // xor of the state hashes of the cards, whatever their order
+   uint64_t stateHash;
    MTGGameZone();
    virtual ~MTGGameZone();
    void shuffle();
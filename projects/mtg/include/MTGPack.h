@@ -6,12 +6,20 @@ class ShopBooster;
 class MTGPackEntry
 {
 public:
+    MTGPackEntry()
+    {
+        copies = 1;
+        weight = 1;
+    }
+    ;
     virtual ~MTGPackEntry()
     {
     }
     ;
-    virtual int addCard(WSrcCards * pool, MTGDeck * to) = 0;
+    //Puts in cards those the entry picks from. Returns false if the entry can't give anything from this pool.
+    virtual bool getCards(WSrcCards * pool, vector<MTGCard *>& cards) = 0;
     int copies;
+    int weight; //Chances of the entry against the others of its slot
 };
 
 class MTGPackEntryRandom: public MTGPackEntry
@@ -29,22 +37,22 @@ public:
         copies = c;
     }
     ;
-    int addCard(WSrcCards * pool, MTGDeck * to);
+    bool getCards(WSrcCards * pool, vector<MTGCard *>& cards);
     string filter;
 };
 class MTGPackEntrySpecific: public MTGPackEntry
 {
 public:
-    int addCard(WSrcCards * pool, MTGDeck * to);
+    bool getCards(WSrcCards * pool, vector<MTGCard *>& cards);
     MTGCard * card;
 };
 
 class MTGPackEntryNothing: public MTGPackEntry
 {
 public:
-    int addCard(WSrcCards *, MTGDeck *)
+    bool getCards(WSrcCards *, vector<MTGCard *>&)
     {
-        return 0;
+        return true;
     }
     ;
 };
@@ -53,7 +61,6 @@ class MTGPackSlot
 {
 public:
     ~MTGPackSlot();
-    int add(WSrcCards * ocean, MTGDeck * to, int carryover);
     void addEntry(MTGPackEntry*item);
     int copies;
     string pool;
@@ -66,6 +73,7 @@ public:
     friend class MTGPacks;
     friend class ShopBooster;
     friend class MTGSetInfo;
+    friend class MTGPackGenerator;
     bool meetsRequirements(); //Check if pool contains locked cards.
     bool isUnlocked();
     bool isValid()
@@ -119,6 +127,44 @@ protected:
     vector<MTGPackSlot*> slotss;
 };
 
+/*
+ A pack compiled against its card pools, to make many packs quickly: each entry of a slot knows the cards it can
+ give, and the slot picks one of its entries in constant time, with an alias table built from their weights.
+ The generator draws from its own random numbers, so the packs only depend on the seed: a seed always gives the
+ same packs, whatever else uses rand() meanwhile. The pools are the ones of the pack when the generator is made.
+ */
+class MTGPackGenerator
+{
+public:
+    MTGPackGenerator(MTGPack * pack, unsigned int seed = 1);
+    void setSeed(unsigned int seed);
+    //Same as MTGPack::assemblePack
+    int assemblePack(MTGDeck * to);
+    //Adds nbPacks packs, as for a sealed pool. Returns the number of cards that could not be found
+    int assemblePool(MTGDeck * to, int nbPacks);
+
+protected:
+    struct Entry
+    {
+        vector<MTGCard *> cards;
+        int copies;
+    };
+    struct Slot
+    {
+        int copies;
+        bool empty; //Has no entries at all
+        vector<Entry> entries; //Those that can give something
+        vector<float> probability; //Alias table
+        vector<int> alias;
+    };
+    vector<Slot> slots;
+    bool bValid;
+    unsigned int state;
+
+    void compile(Slot& slot, MTGPackSlot * source, WSrcCards * pool);
+    unsigned int random();
+};
+
 class MTGPacks
 {
 public:
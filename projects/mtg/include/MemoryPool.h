@@ -0,0 +1,100 @@
+#ifndef _MEMORYPOOL_H_
+#define _MEMORYPOOL_H_
+
+#include <cstddef>
+#include <vector>
+
+/*
+ Pool allocator owned by a GameObserver.
+
+ Small objects are carved out of large chunks and recycled through per size free lists,
+ so a game does not go through the global heap (and its lock) for every event, ability
+ and card instance it creates. The chunks are freed all at once when the game is released.
+
+ Each allocation is preceded by a small header pointing to the pool it comes from, so an object
+ can be deleted whatever pool is current. Objects still alive when the owner releases the pool
+ keep it around until they are deleted too.
+
+ A pool is not thread safe: a game and the objects it allocates belong to one thread at a time.
+ */
+class MemoryPool
+{
+public:
+    MemoryPool();
+
+    // Called by the owner instead of delete
+    void release();
+
+    // Allocates from the pool current for the thread, or from the global heap if there's none
+    static void * allocate(size_t size);
+    static void deallocate(void * p);
+
+    // Pool in use for the calling thread, NULL to use the global heap
+    static MemoryPool * current();
+    static void setCurrent(MemoryPool * pool);
+
+    size_t liveObjects() const { return mLiveObjects; }
+    size_t chunks() const { return mChunks.size(); }
+
+    // Makes a pool current for the duration of a scope
+    class Scope
+    {
+    public:
+        Scope(MemoryPool * pool);
+        ~Scope();
+    private:
+        MemoryPool * mPrevious;
+    };
+
+protected:
+    ~MemoryPool();
+
+    void * allocateFromPool(size_t size);
+
+    struct Header
+    {
+        MemoryPool * pool;
+        size_t sizeClass;
+    };
+
+    enum
+    {
+        HEADER_SIZE = (sizeof(Header) + 7) & ~7,
+        GRANULARITY = 16,
+        MAX_SIZE = 2048,
+        NB_SIZE_CLASSES = MAX_SIZE / GRANULARITY,
+#if defined (PSP)
+        CHUNK_SIZE = 32 * 1024,
+#else
+        CHUNK_SIZE = 128 * 1024,
+#endif
+    };
+
+    std::vector<char *> mChunks;
+    char * mChunkPos;
+    char * mChunkEnd;
+    void * mFreeLists[NB_SIZE_CLASSES];
+    size_t mLiveObjects;
+    bool mReleased;
+
+private:
+    MemoryPool(const MemoryPool&);
+    MemoryPool& operator=(const MemoryPool&);
+};
+
+/*
+ Base for the classes a game allocates by the thousands (events, abilities, card instances):
+ they are allocated from the pool current for the thread.
+ */
+class PoolAllocated
+{
+public:
+    static void * operator new(size_t size) { return MemoryPool::allocate(size); }
+    static void operator delete(void * p) { MemoryPool::deallocate(p); }
+
+    // Forms used by the debug NEW of the windows builds
+    static void * operator new(size_t size, int, const char *, int) { return MemoryPool::allocate(size); }
+    static void operator delete(void * p, int, const char *, int) { MemoryPool::deallocate(p); }
+};
+
+#endif
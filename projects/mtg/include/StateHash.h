@@ -0,0 +1,65 @@
+#ifndef _STATEHASH_H_
+#define _STATEHASH_H_
+
+#include <stdint.h>
+#include <string>
+
+/*
+ Zobrist style keys for the game state hash.
+
+ Every feature of the state (a card in a zone, a tapped card, a counter, the life of a player...) has a
+ pseudo random 64 bits key, and the hash of a state is the xor of the keys of its features, so adding or
+ removing a feature is a single xor. Card ids and counter names are unbounded, so instead of a table of
+ random numbers, keys are derived from the feature and its values by a 64 bits mixing function: they are
+ the same in every process and on every platform, which is what network and test comparisons need.
+ Zones hash their cards as a set: the order of a library is not part of the hash.
+ */
+class StateHash
+{
+public:
+    enum Feature
+    {
+        CARD = 1,
+        TAPPED,
+        COUNTER,
+        ZONE,
+        PHASE,
+        CURRENT_PLAYER,
+        LIFE,
+        POISON,
+        MANA,
+        STACK
+    };
+
+    // splitmix64 finalizer
+    static uint64_t mix(uint64_t value)
+    {
+        value += 0x9E3779B97F4A7C15ULL;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+
+    static uint64_t key(int feature, int a, int b = 0)
+    {
+        return mix(((uint64_t) (uint32_t) feature << 56) ^ mix(((uint64_t) (uint32_t) a << 32) | (uint32_t) b));
+    }
+
+    static uint64_t key(int feature, int a, int b, int c, int d)
+    {
+        return key(feature, a, b) ^ mix(key(feature, c, d));
+    }
+
+    static int stringKey(const std::string& s)
+    {
+        uint32_t hash = 2166136261U;
+        for (size_t i = 0; i < s.size(); i++)
+        {
+            hash ^= (unsigned char) s[i];
+            hash *= 16777619U;
+        }
+        return (int) hash;
+    }
+};
+
+#endif
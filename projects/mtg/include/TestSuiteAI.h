@@ -55,10 +55,17 @@ protected:
     int currentAction;
     GameObserver* observer;
 
+    // Number of AI steps and wall time (ms) spent on the test so far
+    int steps;
+    int testStart;
+    bool timedOut;
+
     static boost::mutex mMutex;
+    static string mLogFile;
     virtual void handleResults(bool wasAI, int error);
     TestSuite* testsuite;
     bool load();
+    bool wasAI();
 
 public:
     virtual ~TestSuiteGame();
@@ -67,6 +74,8 @@ public:
     void ResetManapools();
     void initGame();
     void assertGame();
+    // Counts one step of the test, and aborts it as failed when it runs past the suite limits
+    bool limitReached();
     MTGPlayerCards * buildDeck(Player* player, int playerId);
     GameType getGameType() { return gameType; };
     string getNextAction();
@@ -75,12 +84,39 @@ public:
     void setObserver(GameObserver* anObserver) {observer = anObserver; };
 };
 
+struct TestSuiteResult
+{
+    string filename;
+    bool wasAI;
+    int errors;
+    string abortReason;
+    int steps;
+    int time;
+    // GameObserver::getStateHash() at the end of the test, to spot behavior changes between two runs
+    uint64_t stateHash;
+
+    bool operator<(const TestSuiteResult& other) const { return filename < other.filename; };
+};
+
+/*
+ Runs the tests listed in test/_tests.txt, on the main thread and on one worker per extra hardware thread.
+
+ Command line options:
+   --shard i/n          only run the i-th (1 based) of n interleaved slices of the test list
+   --threads n          number of threads running tests, defaults to the hardware threads
+   --max-steps n        AI steps after which a test is aborted as failed, 0 for no limit
+   --test-timeout s     seconds after which a test is aborted as failed, 0 for no limit
+   --junit file         JUnit report, defaults to test/results.xml
+   --json file          JSON report, defaults to test/results.json
+ Report paths are relative to the user folder. Built with AI_PROFILER, the suite also writes the AI
+ profile to test/results_ai_profile.txt.
+ */
 class TestSuite : public TestSuiteGame
 {
 private:
     int currentfile;
     int nbfiles;
-    string files[1024];
+    vector<string> files;
 
     void cleanup();
     vector<boost::thread*> mWorkerThread;
@@ -97,10 +133,20 @@ private:
     };
     void pregameTests();
 
+    int shard, nbShards;
+    int nbThreads;
+    string junitFile, jsonFile, profileFile;
+    vector<TestSuiteResult> results;
+
+    void parseOptions();
+    void waitForWorkers();
+    void writeReports();
+
 public:
     int getElapsedTime() {return endTime-startTime;};
     unsigned int seed;
     int nbFailed, nbTests, nbAIFailed, nbAITests;
+    int maxSteps, maxTime;
     TestSuite(const char * filename);
     ~TestSuite();
     void initGame(GameObserver* g);
@@ -108,7 +154,8 @@ public:
     void setRules(Rules* rules) {
       mRules = rules;
     };
-    void handleResults(bool wasAI, int error);
+    // Counts the result of a test, the caller holds mMutex
+    void addResult(const string& filename, bool wasAI, int error, int steps, int time, const string& abortReason = "", uint64_t stateHash = 0);
     // run the test suite in turbo mode without UI, 
     // returns the amount of failed tests (AI or not), so 0 if everything went fine.
     int run();
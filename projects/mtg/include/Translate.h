@@ -3,6 +3,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 #if defined _DEBUG
 #define DEBUG_TRANSLATE
@@ -10,15 +11,43 @@
 
 using namespace std;
 
+/*
+** Translation key for string literals, meant to be declared static at the call site:
+**   static const TranslationKey kDone("Done");
+**   font->DrawString(_(kDone), x, y);
+** The key is resolved to its interned id once, after which translating it is a table lookup.
+*/
+class TranslationKey
+{
+public:
+    explicit TranslationKey(const char * key) : mKey(key), mId(-1), mGeneration(-1) {};
+    const string& getKey() const
+    {
+        return mKey;
+    }
+
+protected:
+    friend class Translator;
+    string mKey;
+    mutable int mId;
+    mutable int mGeneration;
+};
+
 class Translator
 {
 protected:
     static Translator * mInstance;
     bool initDone;
 
+    // Translation keys are interned to ids when the dictionaries are loaded,
+    // the translated strings live in a flat table indexed by those ids.
+    // Ids are never reused, so an id stays valid once it has been handed out.
+    map<string, int> keyIds;
+    vector<string> translations;
+    int generation;
+
     void load(string filename, map<string, string> * dictionary);
 public:
-    map<string, string> values;
     map<string, string> tempValues;
     map<string, string> deckValues;
 #if defined DEBUG_TRANSLATE
@@ -26,7 +55,11 @@ public:
     map<string,int> dontCareValues;
     int checkMisses;
 #endif
-    string translate(string toTranslate);
+    const string& translate(const string& toTranslate);
+    const string& translate(const TranslationKey& key);
+    const string& translate(int keyId) const;
+    // Returns the id of a translated key, or -1 if there is no translation for it.
+    int getKeyId(const string& key) const;
     Translator();
     ~Translator();
     int Add(string from, string to);
@@ -37,7 +70,10 @@ public:
     static void EndInstance();
 };
 
-string _(string toTranslate);
+// The returned reference is either the translation or toTranslate itself,
+// copy it if it has to outlive toTranslate.
+const string& _(const string& toTranslate);
+const string& _(const TranslationKey& key);
 
 extern bool neofont;
 #endif
@@ -63,6 +63,9 @@ public:
     bool isGood();
     bool isLocked();  //Is the resource locked?
     bool Attempt(const string& filename, int submode, int & error);
+    //Same as above, but decodes the contents of realname, already read in memory. Doesn't touch JFileSystem.
+    bool Attempt(const string& filename, const string& realname, int submode, u8 * data, int size, int & error);
+    static string RealFilename(const string& filename, int submode); //Resolves the file actually loaded for a filename and submode.
     bool compare(JTexture * t)
     {
         return (t == texture);
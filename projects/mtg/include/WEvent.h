@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include "PhaseRing.h"
+#include "MemoryPool.h"
 
 class MTGCardInstance;
 class MTGGameZone;
@@ -15,7 +16,7 @@ class Counters;
 class MTGAbility;
 class DrawAction;
 
-class WEvent {
+class WEvent : public PoolAllocated {
 public:
   enum {
     NOT_SPECIFIED = 0,
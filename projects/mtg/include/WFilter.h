@@ -9,6 +9,173 @@
 */
 
 class WCardFilter;
+class MTGCard;
+class MTGAllCards;
+class CardPrimitive;
+
+/**
+  A fixed size set of bits, one per card of a WCardIndex.
+*/
+class WCardBits
+{
+public:
+    WCardBits(size_t size = 0, bool value = false)
+    {
+        resize(size, value);
+    }
+    ;
+    void resize(size_t size, bool value = false);
+    size_t size() const
+    {
+        return mSize;
+    }
+    ;
+    bool test(size_t i) const
+    {
+        return (words[i / kWordBits] >> (i % kWordBits)) & 1;
+    }
+    ;
+    void set(size_t i)
+    {
+        words[i / kWordBits] |= 1U << (i % kWordBits);
+    }
+    ;
+    bool any() const;
+    WCardBits& operator&=(const WCardBits& other);
+    WCardBits& operator|=(const WCardBits& other);
+    /**
+      Clears the bits set in other.
+    */
+    WCardBits& operator-=(const WCardBits& other);
+protected:
+    enum
+    {
+        kWordBits = sizeof(unsigned int) * 8
+    };
+    vector<unsigned int> words;
+    size_t mSize;
+};
+
+/**
+  An index of the card collection, one bit set per value of a card attribute (color, type, set...).
+  It lets a WCardFilter tree be evaluated with bitwise operations for the whole collection at once,
+  rather than card by card. The bits of an attribute value are only gathered the first time a filter
+  asks for them, and kept for the next ones.
+  The index is rebuilt when the collection changes.
+*/
+class WCardIndex
+{
+public:
+    enum Attribute
+    {
+        COLOR,
+        PRODUCES,
+        RARITY,
+        SET,
+        CMC,
+        POWER,
+        TOUGHNESS,
+        TYPE,
+        ABILITY,
+        LETTER
+    };
+
+    static WCardIndex * GetInstance();
+    static void Destroy();
+
+    size_t size() const
+    {
+        return cards.size();
+    }
+    ;
+    MTGCard * getCard(size_t i) const
+    {
+        return cards[i];
+    }
+    ;
+    /**
+      Returns the position of the card in the index, or -1 if it is not part of the collection.
+    */
+    int position(MTGCard * c) const;
+    /**
+      Returns the cards of the index which have the given value for an attribute.
+    */
+    const WCardBits& get(Attribute attribute, int value);
+    /**
+      Returns all the cards of the index.
+    */
+    const WCardBits& all() const
+    {
+        return allCards;
+    }
+    ;
+    /**
+      Returns a mask of the colors the card can add to its controller's mana pool, as in bit 1 << color.
+    */
+    unsigned int producedColors(MTGCard * c);
+    /**
+      Sets in result the cards whose name, or name and rules text, have a word containing each
+      of the words of the search.
+    */
+    void search(const string& words, bool namesOnly, WCardBits& result);
+    /**
+      Splits a text in lower case words, the way the search index does.
+    */
+    static void splitWords(const string& text, vector<string>& words);
+    /**
+      Returns the rules text of a card. Once the card has been displayed, its text only remains formatted in lines.
+    */
+    static string getRulesText(CardPrimitive * data);
+private:
+    /**
+      The words of a text field of the primitives, sorted, with the primitives each is found in.
+    */
+    struct TextIndex
+    {
+        vector<string> words;
+        vector<vector<int> > primitives;
+        void add(int primitive, const string& text, map<string, vector<int> >& postings);
+        void build(map<string, vector<int> >& postings);
+        void find(const string& part, vector<int>& found) const;
+    };
+    enum
+    {
+        kBasicLands = 6 //Colorless, then green to white.
+    };
+    WCardIndex(MTGAllCards * collection);
+    static WCardIndex * me;
+    MTGAllCards * collection;
+    vector<MTGCard *> cards; //Sorted by MTGID, like the collection.
+    vector<unsigned int> produced; //Computed once, parsing the mana abilities is slow.
+    WCardBits allCards;
+    map<pair<int, int> , WCardBits> columns;
+    int basicLandTypes[kBasicLands];
+    //Search index, built on the first search. Primitives are shared by the editions of a card.
+    bool textIndexed;
+    TextIndex names;
+    TextIndex texts;
+    vector<vector<int> > primitiveCards;
+    void buildTextIndex();
+    unsigned int computeProducedColors(CardPrimitive * data, const string& magicText);
+    class ProducedColorsVisitor: public MTGAllCards::DetailsVisitor
+    {
+    public:
+        ProducedColorsVisitor(WCardIndex * index) : index(index) {};
+        void visit(CardPrimitive * primitive, CardPrimitive * details);
+        WCardIndex * index;
+        map<CardPrimitive *, unsigned int> produced;
+    };
+    class TextVisitor: public MTGAllCards::DetailsVisitor
+    {
+    public:
+        TextVisitor(WCardIndex * index) : index(index) {};
+        void visit(CardPrimitive * primitive, CardPrimitive * details);
+        WCardIndex * index;
+        map<CardPrimitive *, int> ids;
+        map<string, vector<int> > postings;
+    };
+    bool hasValue(MTGCard * c, size_t i, Attribute attribute, int value);
+};
 
 /**
   A factory class used to construct a WCardFilter from a string. It does so via
@@ -47,6 +214,11 @@ public:
         return true;
     }
     ;
+    /**
+      Sets in result the cards of the index that match, the same as calling isMatch() on each of them.
+      Children that can be answered from the index override this to use bitwise operations.
+    */
+    virtual void match(WCardIndex& index, WCardBits& result);
     /**
       Returns the filter in the same string form used by WCFilterFactory to construct it.
     */
@@ -111,6 +283,7 @@ public:
     }
     ;
     bool isMatch(MTGCard *c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee();
 };
@@ -132,6 +305,7 @@ public:
         return (lhs->isMatch(c) && rhs->isMatch(c));
     }
     ;
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee();
 };
@@ -158,6 +332,11 @@ public:
         return kid->isMatch(c);
     }
     ;
+    void match(WCardIndex& index, WCardBits& result)
+    {
+        kid->match(index, result);
+    }
+    ;
     string getCode();
     float filterFee()
     {
@@ -190,6 +369,7 @@ public:
         return !kid->isMatch(c);
     }
     ;
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
 protected:
     WCardFilter * kid;
@@ -216,6 +396,11 @@ public:
         return true;
     }
     ;
+    void match(WCardIndex& index, WCardBits& result)
+    {
+        result = index.all();
+    }
+    ;
 };
 
 /**
@@ -235,6 +420,7 @@ public:
         return (setid == MTGSets::ALL_SETS || c->setId == setid);
     }
     ;
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee()
     {
@@ -253,6 +439,7 @@ class WCFilterLetter: public WCardFilter
 public:
     WCFilterLetter(string arg);
     bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee()
     {
@@ -276,6 +463,7 @@ public:
     ;
     WCFilterColor(string arg);
     bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee()
     {
@@ -295,6 +483,7 @@ public:
     WCFilterOnlyColor(int _c) : WCFilterColor(_c) {};
     WCFilterOnlyColor(string arg) : WCFilterColor(arg) {};
     bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
 };
 
@@ -307,6 +496,7 @@ public:
     WCFilterProducesColor(int _c) : WCFilterColor(_c) {};
     WCFilterProducesColor(string arg) : WCFilterColor(arg) {};
     bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
 };
 
@@ -338,6 +528,7 @@ public:
     WCFilterCMC(int amt) : WCFilterNumeric(amt) {};
     WCFilterCMC(string arg) : WCFilterNumeric(arg) {};
     bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee()
     {
@@ -355,6 +546,7 @@ public:
     WCFilterPower(int amt) : WCFilterNumeric(amt) {};
     WCFilterPower(string arg) : WCFilterNumeric(arg) {};
     bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee()
     {
@@ -372,6 +564,7 @@ public:
     WCFilterToughness(int amt) : WCFilterNumeric(amt) {};
     WCFilterToughness(string arg) : WCFilterNumeric(arg) {};
     bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee()
     {
@@ -389,9 +582,11 @@ public:
     WCFilterType(string arg)
     {
         type = arg;
+        typeId = -1;
     }
     ;
     bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee()
     {
@@ -400,6 +595,7 @@ public:
     ;
 protected:
     string type;
+    int typeId; //Looked up on first use, finding it takes a lock.
 };
 
 
@@ -416,6 +612,7 @@ public:
     ;
     WCFilterRarity(string arg);
     bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee();
 protected:
@@ -436,11 +633,34 @@ public:
     ;
     WCFilterAbility(string arg);
     bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
     string getCode();
     float filterFee();
 protected:
     int ability;
 };
 
+/**
+  Matches a card whose name (or name and rules text) contains all the words of a search,
+  each of them possibly a part of a word of the card: "gob king" matches "Goblin King".
+*/
+class WCFilterText: public WCardFilter
+{
+public:
+    WCFilterText(string arg, bool namesOnly = false);
+    bool isMatch(MTGCard * c);
+    void match(WCardIndex& index, WCardBits& result);
+    string getCode();
+    float filterFee()
+    {
+        return 4.0f; //Text searches are as expensive as alpha searches!
+    }
+    ;
+protected:
+    string search;
+    vector<string> words;
+    bool namesOnly;
+};
+
 /**@} This comment used by Doxyyen. */
 #endif
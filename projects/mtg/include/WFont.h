@@ -4,6 +4,7 @@
 #include <JLBFont.h>
 #include <JRenderer.h>
 #include <JSprite.h>
+#include <JGlyphCache.h>
 #include "config.h"
 
 namespace Fonts
@@ -149,6 +150,11 @@ public:
     virtual int GetCode(const u8 *ch, int *charLength) const = 0;
     virtual int GetMana(const u8 *ch) const = 0;
 
+    // Start a new frame for the glyph cache statistics.
+    void NewFrame();
+    // Glyph cache hits and misses of the last frame.
+    void GetCacheStats(unsigned int *hits, unsigned int *misses) const;
+
 protected:
     static JRenderer* mRenderer;
 
@@ -169,11 +175,13 @@ protected:
     int mRow;
     int mCacheSize;
     JTexture * mTexture;
+    JTexture * mRetiredTexture;
     JQuad ** mSprites;
-    int *mGBCode;
-    int mCurr;
+    JGlyphCache mGlyphCache;
 
 	PIXEL_TYPE* mCharBuffer;
+    void InitCache(int width, int height);
+    int GetCacheSlot(int code, bool& isCached);
     virtual int PreCacheChar(const u8 *ch);
 };
 
@@ -57,6 +57,72 @@ enum ENUM_CACHE_ERROR
     CACHE_ERROR_NOT_MANAGED,
 };
 
+enum ENUM_PREFETCH_PRIORITY
+{
+    PREFETCH_LOW = 0,       //Speculative: upcoming library cards, booster contents.
+    PREFETCH_NORMAL,        //Likely to be shown soon: hand, adjacent deck viewer pages.
+    PREFETCH_HIGH,          //About to be shown.
+    PREFETCH_PRIORITY_COUNT,
+};
+
+//Counters of record for the card image prefetcher. Times are in milliseconds.
+struct PrefetchStats
+{
+    struct Record
+    {
+        int cacheID;
+        int priority;
+        int waitTime;       //Time spent in the queue.
+        int decodeTime;     //Time spent loading the image.
+        bool success;
+    };
+
+    enum
+    {
+        kHistorySize = 32
+    };
+
+    PrefetchStats()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        for (int i = 0; i < PREFETCH_PRIORITY_COUNT; ++i)
+            requested[i] = 0;
+        duplicates = alreadyCached = cancelled = demoted = dropped = completed = failed = 0;
+        queueDepth = maxQueueDepth = 0;
+        totalWaitTime = totalDecodeTime = 0;
+        maxLatency = 0;
+        historyCount = 0;
+    }
+
+    void AddRecord(const Record& inRecord)
+    {
+        history[historyCount % kHistorySize] = inRecord;
+        historyCount++;
+    }
+
+    unsigned int requested[PREFETCH_PRIORITY_COUNT];
+    unsigned int duplicates;    //Already queued at the same or a higher priority.
+    unsigned int alreadyCached;
+    unsigned int cancelled;
+    unsigned int demoted;       //Moved down a priority by newer requests.
+    unsigned int dropped;       //Evicted from a full queue.
+    unsigned int completed;
+    unsigned int failed;
+    unsigned int queueDepth;    //Requests waiting for a worker.
+    unsigned int maxQueueDepth;
+    unsigned long totalWaitTime;
+    unsigned long totalDecodeTime;
+    unsigned int maxLatency;    //Longest time from request to decoded image.
+
+    //Ring buffer of the last kHistorySize completed requests.
+    Record history[kHistorySize];
+    unsigned int historyCount;
+};
+
 struct WManagedQuad; 
 class WFont;
 class MTGCard;
@@ -81,6 +147,17 @@ public:
 	};
     virtual JQuadPtr RetrieveCard(MTGCard * card, int style = RETRIEVE_NORMAL,int submode = CACHE_NORMAL) = 0;
     virtual JSample * RetrieveSample(const string& filename, int style = RETRIEVE_NORMAL, int submode = CACHE_NORMAL) = 0;
+
+    //Card image prefetching. Queues a background load of a card image that is likely to be displayed soon.
+    //style is either RETRIEVE_NORMAL or RETRIEVE_THUMB. Without a worker thread, only PREFETCH_HIGH requests are honoured (synchronously).
+    virtual void PrefetchCard(MTGCard * card, int priority = PREFETCH_NORMAL, int style = RETRIEVE_NORMAL) = 0;
+    virtual void CancelPrefetch(MTGCard * card, int style = RETRIEVE_NORMAL) = 0;
+    //Cancels all pending requests strictly below the given priority.
+    virtual void CancelPrefetches(int belowPriority = PREFETCH_PRIORITY_COUNT) = 0;
+    virtual PrefetchStats GetPrefetchStats() = 0;
+    //Uploads to GL the card images decoded by the worker threads since the last call. UI thread only, once per frame.
+    virtual void FlushDecodedTextures() = 0;
+
     virtual JTexture * RetrieveTexture(const string& filename, int style = RETRIEVE_NORMAL, int submode = CACHE_NORMAL) = 0;
     virtual JQuadPtr RetrieveQuad(const string& filename, float offX=0.0f, float offY=0.0f, float width=0.0f, float height=0.0f,  string resname="",  int style = RETRIEVE_NORMAL, int submode = CACHE_NORMAL, int id = 0) = 0;
     virtual JQuadPtr RetrieveTempQuad(const string& filename, int submode = CACHE_NORMAL) = 0;
@@ -63,6 +63,12 @@ protected:
 
     cacheItem* LoadIntoCache(int id, const string& filename, int submode, int style = RETRIEVE_NORMAL);
 
+    /*
+    ** Adds an item loaded outside of the cache (ie by a decode worker). If the id got loaded in the meantime,
+    ** the new item is deleted and the cached one returned.
+    */
+    cacheItem* InsertIntoCache(int id, cacheItem* item);
+
     /*
     ** Attempts a new cache item, progressively clearing cache if it fails.
     */
@@ -139,6 +145,11 @@ public:
     JQuadPtr RetrieveCard(MTGCard * card, int style = RETRIEVE_NORMAL,int submode = CACHE_NORMAL);
     JSample * RetrieveSample(const string& filename, int style = RETRIEVE_NORMAL, int submode = CACHE_NORMAL);
     JTexture * RetrieveTexture(const string& filename, int style = RETRIEVE_NORMAL, int submode = CACHE_NORMAL);
+    void PrefetchCard(MTGCard * card, int priority = PREFETCH_NORMAL, int style = RETRIEVE_NORMAL);
+    void CancelPrefetch(MTGCard * card, int style = RETRIEVE_NORMAL);
+    void CancelPrefetches(int belowPriority = PREFETCH_PRIORITY_COUNT);
+    PrefetchStats GetPrefetchStats();
+    void FlushDecodedTextures();
     JQuadPtr RetrieveQuad(const string& filename, float offX=0.0f, float offY=0.0f, float width=0.0f, float height=0.0f,  string resname="",  int style = RETRIEVE_LOCK, int submode = CACHE_NORMAL, int id = 0);
     JQuadPtr RetrieveTempQuad(const string& filename, int submode = CACHE_NORMAL);
     hgeParticleSystemInfo * RetrievePSI(const string& filename, JQuad * texture, int style = RETRIEVE_NORMAL, int submode = CACHE_NORMAL);
@@ -204,6 +215,7 @@ public:
 private:
     bool bThemedCards;		//Does the theme have a "sets" directory for overwriting cards?
     void FlattenTimes();	//To prevent bad cache timing on int overflow
+    bool CardImageRequest(MTGCard * card, int style, string& filename, int& submode, int& lookup); //Resolves the file and cache id of a card image.
 
     //For cached stuff
     WCache<WCachedTexture,JTexture> textureWCache;
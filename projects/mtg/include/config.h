@@ -37,5 +37,7 @@
 #endif
 //#define RENDER_AI_STATS
 #endif
+// Times and counts what the AI does, see AIProfiler.h
+//#define AI_PROFILER
 
 #endif
@@ -58,7 +58,9 @@ std::vector<std::string> split(const std::string& s, char delim); //splits a str
 std::vector<std::string>&  parseBetween(const std::string& s, string start, string stop, bool stopRequired, std::vector<std::string>& elems);
 std::vector<std::string> parseBetween(const std::string& s, string start, string stop, bool stopRequired = true);
 
-std::string wordWrap(const std::string& s, float width, int fontId);
+// Wraps s to the given pixel width with the current scale of the font.
+// Results are cached: the returned reference stays valid until the next call.
+const std::string& wordWrap(const std::string& s, float width, int fontId);
 
 //basic hash function
 unsigned long hash_djb2(const char *str);
@@ -4,6 +4,7 @@
 #include "AIPlayerBaka.h"
 #include "utils.h"
 #include "AllAbilities.h"
+#include "AIProfiler.h"
 
 #include <sstream>
 
@@ -78,7 +79,51 @@ AIHint::AIHint(string _line)
         Combo = action.c_str() + 6;
         combos.push_back(Combo);
     }
-    
+
+    //disect the different parts of the combo right away, hints are shared between games
+    for(unsigned int cPart = 0; cPart < combos.size(); cPart++)
+    {
+        //here we disect the different parts of a given combo
+        partOfCombo = split(combos[cPart],'^');
+        for(int dPart = int(partOfCombo.size()-1);dPart >= 0;dPart--)
+        {
+            vector<string>asTc;
+            asTc = parseBetween(partOfCombo[dPart],"hold(",")");
+            if(asTc.size())
+            {
+                hold.push_back(asTc[1]);
+                asTc.clear();
+            }
+            asTc = parseBetween(partOfCombo[dPart],"until(",")");
+            if(asTc.size())
+            {
+                until.push_back(asTc[1]);
+                asTc.clear();
+            }
+            asTc = parseBetween(partOfCombo[dPart],"restriction{","}");
+            if(asTc.size())
+            {
+                restrict.push_back(asTc[1]);
+                asTc.clear();
+            }
+            asTc = parseBetween(partOfCombo[dPart],"cast(",")");
+            if(asTc.size())
+            {
+                casting.push_back(asTc[1]);
+                vector<string>cht = parseBetween(partOfCombo[dPart],"targeting(",")");
+                if(cht.size())
+                cardTargets[asTc[1]] = cht[1];
+            }
+            asTc = parseBetween(partOfCombo[dPart],"totalmananeeded(",")");
+            if(asTc.size())
+            {
+                manaNeeded = asTc[1];
+                asTc.clear();
+            }
+            if(dPart == 0)
+                break;
+        }
+    }
 }
 
 AIHints::AIHints(AIPlayerBaka * player): mPlayer(player)
@@ -87,13 +132,16 @@ AIHints::AIHints(AIPlayerBaka * player): mPlayer(player)
 
 void AIHints::add(string line)
 {
-    hints.push_back(NEW AIHint(line)); 
+    hints.push_back(boost::shared_ptr<AIHint>(NEW AIHint(line)));
+}
+
+void AIHints::add(const boost::shared_ptr<AIHint>& hint)
+{
+    hints.push_back(hint);
 }
 
 AIHints::~AIHints()
 {
-    for (size_t i = 0; i < hints.size(); ++i)
-        SAFE_DELETE(hints[i]);
     hints.clear();
 }
 
@@ -105,7 +153,7 @@ AIHint * AIHints::getByCondition (string condition)
     for (size_t i = 0; i < hints.size(); ++i)
     {
         if (hints[i]->mCondition.compare(condition) == 0)
-            return hints[i];
+            return hints[i].get();
     }
     return NULL;
 }
@@ -239,55 +287,6 @@ bool AIHints::HintSaysItsForCombo(GameObserver* observer,MTGCardInstance * card)
     {
         if (hints[i]->combos.size())
         {
-            //time to find the parts and condiations of the combo.
-            string part = "";
-            if(!hints[i]->partOfCombo.size() && hints[i]->combos.size())
-            {
-                for(unsigned int cPart = 0; cPart < hints[i]->combos.size(); cPart++)
-                {
-                    //here we disect the different parts of a given combo
-                    part = hints[i]->combos[cPart];
-                    hints[i]->partOfCombo = split(part,'^');
-                    for(int dPart = int(hints[i]->partOfCombo.size()-1);dPart >= 0;dPart--)
-                    {
-                        vector<string>asTc;
-                        asTc = parseBetween(hints[i]->partOfCombo[dPart],"hold(",")");
-                        if(asTc.size())
-                        {
-                            hints[i]->hold.push_back(asTc[1]);
-                            asTc.clear();
-                        }
-                        asTc = parseBetween(hints[i]->partOfCombo[dPart],"until(",")");
-                        if(asTc.size())
-                        {
-                            hints[i]->until.push_back(asTc[1]);
-                            asTc.clear();
-                        }
-                        asTc = parseBetween(hints[i]->partOfCombo[dPart],"restriction{","}");
-                        if(asTc.size())
-                        {
-                            hints[i]->restrict.push_back(asTc[1]);
-                            asTc.clear();
-                        }
-                        asTc = parseBetween(hints[i]->partOfCombo[dPart],"cast(",")");
-                        if(asTc.size())
-                        {
-                            hints[i]->casting.push_back(asTc[1]);
-                            vector<string>cht = parseBetween(hints[i]->partOfCombo[dPart],"targeting(",")");
-                            if(cht.size())
-                            hints[i]->cardTargets[asTc[1]] = cht[1];
-                        }
-                        asTc = parseBetween(hints[i]->partOfCombo[dPart],"totalmananeeded(",")");
-                        if(asTc.size())
-                        {
-                            hints[i]->manaNeeded = asTc[1];
-                            asTc.clear();
-                        }
-                        if(dPart == 0)
-                            break;
-                    }
-                }
-            }//we collect the peices of a combo on first run.
             for(unsigned int hPart = 0; hPart < hints[i]->hold.size(); hPart++)
             {
                 hintTc = tfc.createTargetChooser(hints[i]->hold[hPart],card);
@@ -299,11 +298,12 @@ bool AIHints::HintSaysItsForCombo(GameObserver* observer,MTGCardInstance * card)
             }
         }
     }
-    return forCombo;//return forCombo that way all hints that are combos are predisected.
+    return forCombo;
 }
 //if it's not part of a combo or there is more to gather, then return false
 bool AIHints::canWeCombo(GameObserver* observer,MTGCardInstance * card,AIPlayerBaka * Ai)
 {
+    AI_PROFILE("AIHints::canWeCombo");
     TargetChooserFactory tfc(observer);
     TargetChooser * hintTc = NULL;
     bool gotCombo = false;
@@ -361,7 +361,7 @@ bool AIHints::canWeCombo(GameObserver* observer,MTGCardInstance * card,AIPlayerB
             if(Ai->canPayManaCost(card,needed).size()||!needed->getConvertedCost())
             {
                 gotCombo = true;
-                Ai->comboHint = hints[i];//set the combo we are doing.
+                Ai->comboHint = hints[i].get();//set the combo we are doing.
             }
             SAFE_DELETE(needed);
         }
@@ -439,6 +439,7 @@ vector<MTGAbility *> AIHints::findAbilities(AIHint * hint)
 //Finds a mtgAbility matching the Hint description, and returns a valid AIAction matching this mtgability
 RankingContainer AIHints::findActions(AIHint * hint)
 {
+    AI_PROFILE("AIHints::findActions");
     RankingContainer ranking;
 
     vector<MTGAbility *> abilities = findAbilities(hint);
@@ -475,6 +476,7 @@ bool AIHints::findSource(int sourceId)
 
 string AIHints::constraintsNotFulfilled(AIAction * action, AIHint * hint, ManaCost * potentialMana)
 {
+    AI_PROFILE("AIHints::constraintsNotFulfilled");
     std::stringstream out;
 
     if (!action)
@@ -568,13 +570,14 @@ AIAction * AIHints::findAbilityRecursive(AIHint * hint, ManaCost * potentialMana
 
 AIAction * AIHints::suggestAbility(ManaCost * potentialMana)
 {
+    AI_PROFILE("AIHints::suggestAbility");
     for (size_t i = 0; i < hints.size(); ++i)
     {
         //Don't suggest abilities that require a condition, for now
         if (hints[i]->mCondition.size())
             continue;
 
-        AIAction * a = findAbilityRecursive(hints[i], potentialMana);
+        AIAction * a = findAbilityRecursive(hints[i].get(), potentialMana);
         if (a)
         {  
             DebugTrace("**I Decided that the best to fulfill " << hints[i]->mAction << " is to play " << a->ability->getMenuText() << "\n\n");
@@ -31,13 +31,13 @@ AIAction::AIAction(AIPlayer * owner, MTGCardInstance * c, MTGCardInstance * t)
     {
         //DebugTrace("Prefetching AI card going into play: " << c->getImageName());
         if(owner->getObserver()->getResourceManager())
-            owner->getObserver()->getResourceManager()->RetrieveCard(c, RETRIEVE_THUMB);
+            owner->getObserver()->getResourceManager()->PrefetchCard(c, PREFETCH_HIGH, RETRIEVE_THUMB);
         
         // also cache the large image if we're using kNormal mode
         if (owner->getObserver()->getCardSelector()->GetDrawMode() == DrawMode::kNormal)
         {
             if(owner->getObserver()->getResourceManager())
-                owner->getObserver()->getResourceManager()->RetrieveCard(c);
+                owner->getObserver()->getResourceManager()->PrefetchCard(c, PREFETCH_HIGH);
         }
     }
 }
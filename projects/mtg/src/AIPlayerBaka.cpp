@@ -9,6 +9,7 @@
 #include "AIHints.h"
 #include "ManaCostHybrid.h"
 #include "MTGRules.h"
+#include "AIProfiler.h"
 
 //
 // AIAction
@@ -63,7 +64,11 @@ int OrderedAIAction::getEfficiency(AADamager * aad)
 int OrderedAIAction::getEfficiency()
 {
     if (efficiency > -1)
+    {
+        AI_COUNT("OrderedAIAction::getEfficiency cached");
         return efficiency;
+    }
+    AI_PROFILE("OrderedAIAction::getEfficiency");
     if (!ability)
         return 0;
     GameObserver * g = owner->getObserver();
@@ -802,7 +807,7 @@ bool AIPlayerBaka::payTheManaCost(ManaCost * cost, MTGCardInstance * target,vect
             {
                 used[card] = true;
             } //http://code.google.com/p/wagic/issues/detail?id=76
-            if (!used[card] && amp->isReactingToClick(card) && amp->output->getConvertedCost() >= 1)
+            if (!used[card] && observer->mLayers->actionLayer()->isReactingToClick(amp, card) && amp->output->getConvertedCost() >= 1)
             {
                 used[card] = true;
                 int doUse = 1;
@@ -856,7 +861,7 @@ ManaCost * AIPlayerBaka::getPotentialMana(MTGCardInstance * target)
             MTGCardInstance * card = amp->source;
             if (card == target)
                 used[card] = true; //http://code.google.com/p/wagic/issues/detail?id=76
-            if (!used[card] && amp->isReactingToClick(card) && amp->output->getConvertedCost() == 1)
+            if (!used[card] && observer->mLayers->actionLayer()->isReactingToClick(amp, card) && amp->output->getConvertedCost() == 1)
             {//ai can't use cards which produce more then 1 converted while using the old pMana method.
                 result->add(amp->output);
                 used[card] = true;
@@ -877,6 +882,7 @@ vector<MTGAbility*> AIPlayerBaka::canPayMana(MTGCardInstance * target,ManaCost *
 
 vector<MTGAbility*> AIPlayerBaka::canPayMana(MTGCardInstance * target,ManaCost * cost, map<MTGCardInstance*,bool> &used ,bool searchingAgain)
 {
+    AI_PROFILE("AIPlayerBaka::canPayMana");
     if(!cost->getConvertedCost())
         return vector<MTGAbility*>();
     ManaCost * result = NEW ManaCost();
@@ -906,7 +912,7 @@ vector<MTGAbility*> AIPlayerBaka::canPayMana(MTGCardInstance * target,ManaCost *
                     MTGCardInstance * card = amp->source;
                     if (card == target)
                         used[card] = true; //http://code.google.com/p/wagic/issues/detail?id=76
-                    if (!used[card] && amp->isReactingToClick(card) && amp->output->getConvertedCost() >= 1)
+                    if (!used[card] && observer->mLayers->actionLayer()->isReactingToClick(amp, card) && amp->output->getConvertedCost() >= 1)
                     {
                         if(!(result->canAfford(cost)))//if we got to this point we should be filling colorless mana requirements.
                         {
@@ -937,7 +943,7 @@ vector<MTGAbility*> AIPlayerBaka::canPayMana(MTGCardInstance * target,ManaCost *
                         used[fecard];
                         continue;
                     }
-                    if (!used[fecard] && gmp->isReactingToClick(fecard) && amp->output->getConvertedCost() >= 1 && (cost->getConvertedCost() > 1 || cost->hasX()))//wasteful to tap a potential big mana source for a single mana.
+                    if (!used[fecard] && observer->mLayers->actionLayer()->isReactingToClick(gmp, fecard) && amp->output->getConvertedCost() >= 1 && (cost->getConvertedCost() > 1 || cost->hasX()))//wasteful to tap a potential big mana source for a single mana.
                     {
                         int outPut = fmp->checkActivation();
                         for(int k = 0;k < outPut;k++)
@@ -957,7 +963,7 @@ vector<MTGAbility*> AIPlayerBaka::canPayMana(MTGCardInstance * target,ManaCost *
                     MTGCardInstance * card = amp->source;
                     if (card == target)
                         used[card] = true; //http://code.google.com/p/wagic/issues/detail?id=76
-                    if (!used[card] && amp->isReactingToClick(card) && amp->output->getConvertedCost() >= 1)
+                    if (!used[card] && observer->mLayers->actionLayer()->isReactingToClick(amp, card) && amp->output->getConvertedCost() >= 1)
                     {
                         ManaCost * check = NEW ManaCost();
                         check->add(k,cost->getCost(k));
@@ -1003,7 +1009,7 @@ vector<MTGAbility*> AIPlayerBaka::canPayMana(MTGCardInstance * target,ManaCost *
                         MTGCardInstance * card = amp->source;
                         if (card == target)
                             used[card] = true; //http://code.google.com/p/wagic/issues/detail?id=76
-                        if (!used[card] && amp->isReactingToClick(card) && amp->output->getConvertedCost() >= 1)
+                        if (!used[card] && observer->mLayers->actionLayer()->isReactingToClick(amp, card) && amp->output->getConvertedCost() >= 1)
                         {
                             ManaCost * check = NEW ManaCost();
                             check->add(foundColor1?hybridCost->color1:hybridCost->color2,foundColor1?hybridCost->value1:hybridCost->value2);
@@ -1082,7 +1088,7 @@ vector<MTGAbility*> AIPlayerBaka::canPayMana(MTGCardInstance * target,ManaCost *
             AManaProducer * amp = dynamic_cast<AManaProducer*> (a);
             if (amp && canHandleCost(amp))
             {
-                if (!used[amp->source] && amp->isReactingToClick(amp->source) && amp->output->getConvertedCost() >= 1)
+                if (!used[amp->source] && observer->mLayers->actionLayer()->isReactingToClick(amp, amp->source) && amp->output->getConvertedCost() >= 1)
                 {
                     payments.push_back(amp);
                 }
@@ -1124,7 +1130,7 @@ vector<MTGAbility*> AIPlayerBaka::canPaySunBurst(ManaCost * cost)
                 if (amp->output->hasColor(k) && result->getCost(k) < 1 && result->getConvertedCost() < cost->getConvertedCost())
                 {
                     MTGCardInstance * card = amp->source;
-                    if (!used[card] && amp->isReactingToClick(card) && amp->output->getConvertedCost() >= 1)
+                    if (!used[card] && observer->mLayers->actionLayer()->isReactingToClick(amp, card) && amp->output->getConvertedCost() >= 1)
                     {
                         ManaCost * check = NEW ManaCost();
                         check->add(k,1);
@@ -1154,7 +1160,7 @@ vector<MTGAbility*> AIPlayerBaka::canPaySunBurst(ManaCost * cost)
             if (amp && canHandleCost(amp))
             {
                 MTGCardInstance * card = amp->source;
-                if (!used[card] && amp->isReactingToClick(card) && amp->output->getConvertedCost() >= 1)
+                if (!used[card] && observer->mLayers->actionLayer()->isReactingToClick(amp, card) && amp->output->getConvertedCost() >= 1)
                 {
                     if(!(result->canAfford(cost)))//if we got to this point we should be filling colorless mana requirements.
                     {
@@ -1207,6 +1213,7 @@ int AIPlayerBaka::canHandleCost(MTGAbility * ability)
 
 int AIPlayerBaka::createAbilityTargets(MTGAbility * a, MTGCardInstance * c, RankingContainer& ranking)
 {
+    AI_PROFILE("AIPlayerBaka::createAbilityTargets");
     if (!a->getActionTc())
     {
         OrderedAIAction aiAction(this, a, c, NULL);
@@ -1328,6 +1335,7 @@ TargetChooser * AIPlayerBaka::GetComboTc( GameObserver * observer,TargetChooser
 
 int AIPlayerBaka::selectHintAbility()
 {
+    AI_PROFILE("AIPlayerBaka::selectHintAbility");
     if (!hints)
         return 0;
 
@@ -1354,6 +1362,7 @@ int AIPlayerBaka::selectHintAbility()
 
 int AIPlayerBaka::selectAbility()
 {
+    AI_PROFILE("AIPlayerBaka::selectAbility");
     if(observer->mExtraPayment && observer->mExtraPayment->source->controller() == this)
     {
         ExtraManaCost * check = NULL;
@@ -1400,12 +1409,13 @@ int AIPlayerBaka::selectAbility()
         for (int j = 0; j < game->inPlay->nb_cards; j++)
         {
             MTGCardInstance * card = game->inPlay->cards[j];
-            if(a->getCost() && !a->isReactingToClick(card, totalPotentialMana))//for performance reason only look for specific mana if the payment couldnt be made with potential.
+            int reacting = observer->mLayers->actionLayer()->isReactingToClick(a, card, totalPotentialMana);
+            if(a->getCost() && !reacting)//for performance reason only look for specific mana if the payment couldnt be made with potential.
             {
                 abilityPayment = vector<MTGAbility*>();
                 abilityPayment = canPayMana(card,a->getCost());
             }
-            if (a->isReactingToClick(card, totalPotentialMana) || abilityPayment.size())
+            if (reacting || abilityPayment.size())
             { //This test is to avoid the huge call to getPotentialManaCost after that
                 if(a->getCost() && a->getCost()->hasX() && totalPotentialMana->getConvertedCost() < a->getCost()->getConvertedCost()+1)
                     continue;
@@ -1420,7 +1430,7 @@ int AIPlayerBaka::selectAbility()
                         if(ampp)
                             fullPayment->add(ampp->output);
                     }
-                    if (fullPayment && a->isReactingToClick(card, fullPayment))
+                    if (fullPayment && observer->mLayers->actionLayer()->isReactingToClick(a, card, fullPayment))
                         createAbilityTargets(a, card, ranking);
                     delete fullPayment;
                 }
@@ -1428,7 +1438,7 @@ int AIPlayerBaka::selectAbility()
                 {
                     ManaCost * pMana = getPotentialMana(card);
                     pMana->add(this->getManaPool());
-                    if (a->isReactingToClick(card, pMana))
+                    if (observer->mLayers->actionLayer()->isReactingToClick(a, card, pMana))
                         createAbilityTargets(a, card, ranking);
                     delete (pMana);
                 }     
@@ -1466,6 +1476,7 @@ int AIPlayerBaka::selectAbility()
 
 int AIPlayerBaka::interruptIfICan()
 {
+    AI_PROFILE("AIPlayerBaka::interruptIfICan");
     if (observer->mLayers->stackLayer()->askIfWishesToInterrupt == this)
     {
         if (!clickstream.empty())
@@ -1496,6 +1507,7 @@ int AIPlayerBaka::effectBadOrGood(MTGCardInstance * card, int mode, TargetChoose
 
 int AIPlayerBaka::chooseTarget(TargetChooser * _tc, Player * forceTarget,MTGCardInstance * chosenCard,bool checkOnly)
 {
+    AI_PROFILE("AIPlayerBaka::chooseTarget");
     if(observer->mExtraPayment)
     {
     observer->mExtraPayment->action->CheckUserInput(JGE_BTN_SEC);
@@ -1644,6 +1656,7 @@ int AIPlayerBaka::chooseTarget(TargetChooser * _tc, Player * forceTarget,MTGCard
 //Returns -1 if error, a number between 0 and 100 otherwise
 int AIPlayerBaka::getEfficiency(MTGAbility * ability)
 {
+    AI_PROFILE("AIPlayerBaka::getEfficiency(MTGAbility)");
     if (!ability)
         return -1;
 
@@ -1962,6 +1975,7 @@ void AIPlayerBaka::initTimer()
 
 int AIPlayerBaka::computeActions()
 {
+    AI_PROFILE("AIPlayerBaka::computeActions");
     /*Zeth fox:TODO:rewrite this entire function, It's a mess.
     I made it far to complicated for what it does and is prone to error and inefficiency.
     Ai run's certain part's when it doesn't need to and run's certain actions when it shouldn't, 
@@ -2236,6 +2250,7 @@ int AIPlayerBaka::getCreaturesInfo(Player * player, int neededInfo, int untapMod
 
 int AIPlayerBaka::chooseAttackers()
 {
+    AI_PROFILE("AIPlayerBaka::chooseAttackers");
     //Attack with all creatures
     //How much damage can the other player do during his next Attack ?
     int opponentForce = getCreaturesInfo(opponent(), INFO_CREATURESPOWER);
@@ -2297,6 +2312,7 @@ int AIPlayerBaka::canFirstStrikeKill(MTGCardInstance * card, MTGCardInstance *en
 
 int AIPlayerBaka::chooseBlockers()
 {
+    AI_PROFILE("AIPlayerBaka::chooseBlockers");
     //Should not block during my own turn...
     if (observer->currentPlayer == this)
         return 0;
@@ -2488,8 +2504,18 @@ AIPlayerBaka::AIPlayerBaka(GameObserver *observer, string file, string fileSmall
     if (mDeck && mDeck->meta_AIHints.size())
     {
         hints = NEW AIHints(this);
-        for (size_t i = 0; i <  mDeck->meta_AIHints.size(); ++i)
-            hints->add(mDeck->meta_AIHints[i]);
+        //hints are parsed when the deck file is, and shared by all the games using it
+        const vector<boost::shared_ptr<AIHint> >& parsedHints = mDeck->getAIHints();
+        if (parsedHints.size() == mDeck->meta_AIHints.size())
+        {
+            for (size_t i = 0; i < parsedHints.size(); ++i)
+                hints->add(parsedHints[i]);
+        }
+        else
+        {
+            for (size_t i = 0; i <  mDeck->meta_AIHints.size(); ++i)
+                hints->add(mDeck->meta_AIHints[i]);
+        }
     }
 
 
@@ -2544,6 +2570,9 @@ int AIPlayerBaka::Act(float dt)
     }
     initTimer();
 
+    AI_PROFILE_CONTEXT(currentGamePhase, deckFileSmall);
+    AI_PROFILE("AIPlayerBaka::Act");
+
     if (combatDamages())
     {
         return 0;
@@ -0,0 +1,300 @@
+#include "PrecompiledHeader.h"
+
+#include "AIProfiler.h"
+
+#ifdef AI_PROFILER
+
+#include "MTGDefinitions.h"
+#include "Threading.h"
+#include <set>
+
+#if defined(WIN32)
+#include <windows.h>
+#elif defined(PSP)
+#include <psprtc.h>
+#elif defined(LINUX) || defined(ANDROID)
+#include <time.h>
+#else
+#include <sys/time.h>
+#endif
+
+namespace
+{
+    // Nanoseconds, from an arbitrary origin
+    uint64_t now()
+    {
+#if defined(WIN32)
+        static LARGE_INTEGER frequency;
+        if (!frequency.QuadPart)
+            QueryPerformanceFrequency(&frequency);
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return (uint64_t) ((double) counter.QuadPart * 1e9 / (double) frequency.QuadPart);
+#elif defined(PSP)
+        u64 ticks;
+        sceRtcGetCurrentTick(&ticks);
+        return (uint64_t) ticks * 1000000000ULL / sceRtcGetTickResolution();
+#elif defined(LINUX) || defined(ANDROID)
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        return (uint64_t) t.tv_sec * 1000000000ULL + t.tv_nsec;
+#else
+        struct timeval t;
+        gettimeofday(&t, NULL);
+        return (uint64_t) t.tv_sec * 1000000000ULL + (uint64_t) t.tv_usec * 1000;
+#endif
+    }
+
+    struct Key
+    {
+        const char * name;
+        int phase;
+        const char * deck;
+
+        Key(const char * name, int phase, const char * deck) : name(name), phase(phase), deck(deck) {}
+
+        bool operator<(const Key& other) const
+        {
+            if (name != other.name)
+                return name < other.name;
+            if (phase != other.phase)
+                return phase < other.phase;
+            return deck < other.deck;
+        }
+    };
+
+    struct Entry
+    {
+        uint64_t calls;
+        uint64_t total;
+        uint64_t self;
+        uint64_t max;
+        bool timed;
+
+        Entry() : calls(0), total(0), self(0), max(0), timed(false) {}
+
+        void add(const Entry& other)
+        {
+            calls += other.calls;
+            total += other.total;
+            self += other.self;
+            if (other.max > max)
+                max = other.max;
+            timed = timed || other.timed;
+        }
+    };
+
+    typedef std::map<Key, Entry> Entries;
+
+    struct ThreadData
+    {
+        Entries entries;
+        AIProfiler::Scope * current;
+        int phase;
+        const char * deck;
+        std::string deckName;
+
+        ThreadData() : current(NULL), phase(MTG_PHASE_INVALID), deck("") {}
+    };
+
+    boost::mutex sMutex;
+    // what the threads that exited measured
+    Entries sMerged;
+    std::set<ThreadData *> sThreads;
+    // deck names never go away, their addresses are part of the keys
+    std::set<std::string> sDecks;
+
+    void mergeThread(ThreadData * data)
+    {
+        boost::mutex::scoped_lock lock(sMutex);
+        for (Entries::iterator it = data->entries.begin(); it != data->entries.end(); ++it)
+            sMerged[it->first].add(it->second);
+        sThreads.erase(data);
+        delete data;
+    }
+
+    boost::thread_specific_ptr<ThreadData> sThreadData(mergeThread);
+
+    ThreadData * threadData()
+    {
+        ThreadData * data = sThreadData.get();
+        if (!data)
+        {
+            data = new ThreadData;
+            sThreadData.reset(data);
+            boost::mutex::scoped_lock lock(sMutex);
+            sThreads.insert(data);
+        }
+        return data;
+    }
+
+    template <class T>
+    struct ByTotal
+    {
+        bool operator()(const std::pair<T, Entry>& a, const std::pair<T, Entry>& b) const
+        {
+            if (a.second.total != b.second.total)
+                return a.second.total > b.second.total;
+            return a.second.calls > b.second.calls;
+        }
+    };
+
+    const char * phaseName(int phase)
+    {
+        if (phase < 0 || phase >= NB_MTG_PHASES)
+            return "none";
+        return Constants::MTGPhaseNames[phase];
+    }
+
+    void writeLine(std::ostream& out, const std::string& label, const Entry& entry)
+    {
+        char buffer[512];
+        if (entry.timed)
+            sprintf(buffer, "%-60s %10lu %12.2f %12.2f %10.1f %10.1f", label.c_str(), (unsigned long) entry.calls,
+                    entry.total / 1e6, entry.self / 1e6, entry.calls ? entry.total / 1e3 / entry.calls : 0.0, entry.max / 1e3);
+        else
+            sprintf(buffer, "%-60s %10lu", label.c_str(), (unsigned long) entry.calls);
+        out << buffer << "\n";
+    }
+
+    template <class T>
+    void writeSection(std::ostream& out, const char * title, const std::map<T, Entry>& entries, std::string (*label)(const T&))
+    {
+        std::vector<std::pair<T, Entry> > sorted(entries.begin(), entries.end());
+        std::sort(sorted.begin(), sorted.end(), ByTotal<T>());
+
+        char header[512];
+        if (sorted.size() && !sorted[0].second.timed)
+            sprintf(header, "%-60s %10s", title, "count");
+        else
+            sprintf(header, "%-60s %10s %12s %12s %10s %10s", title, "calls", "total ms", "self ms", "avg us", "max us");
+        out << "\n" << header << "\n";
+        for (size_t i = 0; i < sorted.size(); i++)
+            writeLine(out, label(sorted[i].first), sorted[i].second);
+    }
+
+    std::string functionLabel(const std::string& name)
+    {
+        return name;
+    }
+
+    std::string phaseLabel(const std::pair<std::string, int>& key)
+    {
+        return key.first + " @ " + phaseName(key.second);
+    }
+
+    std::string deckLabel(const std::pair<std::string, std::string>& key)
+    {
+        return key.first + " @ " + key.second;
+    }
+}
+
+AIProfiler::Scope::Scope(const char * name)
+    : mChildren(0), mName(name)
+{
+    ThreadData * data = threadData();
+    mParent = data->current;
+    data->current = this;
+    mStart = now();
+}
+
+AIProfiler::Scope::~Scope()
+{
+    uint64_t elapsed = now() - mStart;
+    ThreadData * data = sThreadData.get();
+
+    Entry& entry = data->entries[Key(mName, data->phase, data->deck)];
+    entry.timed = true;
+    entry.calls++;
+    entry.total += elapsed;
+    entry.self += elapsed > mChildren ? elapsed - mChildren : 0;
+    if (elapsed > entry.max)
+        entry.max = elapsed;
+
+    data->current = mParent;
+    if (mParent)
+        mParent->mChildren += elapsed;
+}
+
+AIProfiler::Context::Context(int phase, const std::string& deck)
+{
+    ThreadData * data = threadData();
+    mPhase = data->phase;
+    mDeck = data->deck;
+
+    data->phase = phase;
+    if (data->deckName != deck)
+    {
+        boost::mutex::scoped_lock lock(sMutex);
+        data->deck = sDecks.insert(deck).first->c_str();
+        data->deckName = deck;
+    }
+}
+
+AIProfiler::Context::~Context()
+{
+    ThreadData * data = sThreadData.get();
+    data->phase = mPhase;
+    if (data->deck != mDeck)
+    {
+        data->deck = mDeck;
+        data->deckName = mDeck;
+    }
+}
+
+void AIProfiler::count(const char * name)
+{
+    ThreadData * data = threadData();
+    data->entries[Key(name, data->phase, data->deck)].calls++;
+}
+
+void AIProfiler::report(const std::string& filename)
+{
+    // the other threads are expected to be idle: their tables are read as they are
+    Entries all;
+    {
+        boost::mutex::scoped_lock lock(sMutex);
+        all = sMerged;
+        for (std::set<ThreadData *>::iterator t = sThreads.begin(); t != sThreads.end(); ++t)
+            for (Entries::iterator it = (*t)->entries.begin(); it != (*t)->entries.end(); ++it)
+                all[it->first].add(it->second);
+    }
+
+    std::map<std::string, Entry> byFunction;
+    std::map<std::pair<std::string, int>, Entry> byPhase;
+    std::map<std::pair<std::string, std::string>, Entry> byDeck;
+    std::map<std::string, Entry> counters;
+    for (Entries::iterator it = all.begin(); it != all.end(); ++it)
+    {
+        std::string name = it->first.name;
+        if (!it->second.timed)
+        {
+            counters[name].add(it->second);
+            continue;
+        }
+        byFunction[name].add(it->second);
+        byPhase[std::make_pair(name, it->first.phase)].add(it->second);
+        byDeck[std::make_pair(name, std::string(it->first.deck))].add(it->second);
+    }
+
+    std::ofstream out;
+    if (!JFileSystem::GetInstance()->openForWrite(out, filename))
+        return;
+
+    out << "AI profile" << "\n";
+    writeSection(out, "by function", byFunction, functionLabel);
+    writeSection(out, "by function and phase", byPhase, phaseLabel);
+    writeSection(out, "by function and deck", byDeck, deckLabel);
+    writeSection(out, "counters", counters, functionLabel);
+    out.close();
+}
+
+void AIProfiler::reset()
+{
+    boost::mutex::scoped_lock lock(sMutex);
+    sMerged.clear();
+    for (std::set<ThreadData *>::iterator t = sThreads.begin(); t != sThreads.end(); ++t)
+        (*t)->entries.clear();
+}
+
+#endif
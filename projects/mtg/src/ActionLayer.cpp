@@ -23,6 +23,7 @@ MTGAbility* ActionLayer::getAbility(int type)
 int ActionLayer::removeFromGame(ActionElement * e)
 {
     mReactions.erase(e);
+    reactions.clear();
     int i = getIndexOf(e);
     if (i == -1)
         return 0;
@@ -68,6 +69,7 @@ bool ActionLayer::moveToGarbage(ActionElement * e)
 
 void ActionLayer::cleanGarbage()
 {
+    reactions.clear();
     for (size_t i = 0; i < garbage.size(); ++i)
     {
         SAFE_DELETE(garbage[i]);
@@ -306,7 +308,7 @@ bool ActionLayer::getMenuIdFromCardAbility(MTGCardInstance *card, MTGAbility *ab
     for (size_t i = 0; i < mObjects.size(); i++)
     {
         ActionElement * currentAction = (ActionElement *) mObjects[i];
-        if (currentAction->isReactingToClick(card))
+        if (isReactingToClick(currentAction, card))
         {
             if(currentAction == ability) {
                 // code corresponding to that is in setMenuObject
@@ -335,7 +337,7 @@ int ActionLayer::isReactingToClick(MTGCardInstance * card)
     for (size_t i = 0; i < mObjects.size(); i++)
     {
         ActionElement * currentAction = (ActionElement *) mObjects[i];
-        if (currentAction->isReactingToClick(card))
+        if (isReactingToClick(currentAction, card))
         {
             ++result;
             mReactions.insert(currentAction);
@@ -345,6 +347,54 @@ int ActionLayer::isReactingToClick(MTGCardInstance * card)
     return result;
 }
 
+bool ActionLayer::ReactionsContext::operator==(const ReactionsContext& other) const
+{
+    return version == other.version && phase == other.phase && acting == other.acting && interrupting == other.interrupting
+        && stackSize == other.stackSize && extraPayment == other.extraPayment && targetChooser == other.targetChooser;
+}
+
+ActionLayer::ReactionsContext ActionLayer::getReactionsContext()
+{
+    ReactionsContext context;
+    context.version = observer->getStateVersion();
+    context.phase = observer->getCurrentGamePhase();
+    context.acting = observer->currentlyActing();
+    context.interrupting = observer->isInterrupting;
+    context.stackSize = observer->mLayers->stackLayer()->mObjects.size();
+    context.extraPayment = observer->mExtraPayment;
+    context.targetChooser = observer->targetChooser;
+    return context;
+}
+
+int ActionLayer::isReactingToClick(ActionElement * action, MTGCardInstance * card, ManaCost * mana)
+{
+    //Only plain amounts of mana are remembered, like a mana pool or the mana the AI could produce
+    vector<int> amounts;
+    if (mana)
+    {
+        if (mana->getHybridCost(0) || mana->extraCosts)
+            return action->isReactingToClick(card, mana);
+        for (int i = 0; i <= Constants::NB_Colors; i++)
+            amounts.push_back(mana->getCost(i));
+    }
+
+    ReactionsContext context = getReactionsContext();
+    if (!(context == reactionsContext))
+    {
+        reactions.clear();
+        reactionsContext = context;
+    }
+
+    ReactionKey key(std::make_pair(action, card), amounts);
+    std::map<ReactionKey, int>::iterator it = reactions.find(key);
+    if (it != reactions.end())
+        return it->second;
+
+    int result = action->isReactingToClick(card, mana);
+    reactions[key] = result;
+    return result;
+}
+
 int ActionLayer::reactToClick(MTGCardInstance * card)
 {
     int result = 0;
@@ -542,6 +592,14 @@ ActionLayer::ActionLayer(GameObserver *observer)
     stuffHappened = 0;
     currentWaitingAction = NULL;
     cantCancel = 0;
+    //The layers are not all there yet: this context matches nothing, the first question will set it
+    reactionsContext.version = (unsigned long) -1;
+    reactionsContext.phase = MTG_PHASE_INVALID;
+    reactionsContext.acting = NULL;
+    reactionsContext.interrupting = NULL;
+    reactionsContext.stackSize = 0;
+    reactionsContext.extraPayment = NULL;
+    reactionsContext.targetChooser = NULL;
 }
 
 ActionLayer::~ActionLayer()
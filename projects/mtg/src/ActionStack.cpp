@@ -447,11 +447,13 @@ void PutInGraveyard::Render()
     mFont->SetScale(DEFAULT_MAIN_FONT_SCALE);
     if (!removeFromGame)
     {
-        mFont->DrawString(_("goes to graveyard").c_str(), x + 30, y, JGETEXT_LEFT);
+        static const TranslationKey kGoesToGraveyard("goes to graveyard");
+        mFont->DrawString(_(kGoesToGraveyard).c_str(), x + 30, y, JGETEXT_LEFT);
     }
     else
     {
-        mFont->DrawString(_("is exiled").c_str(), x + 30, y, JGETEXT_LEFT);
+        static const TranslationKey kIsExiled("is exiled");
+        mFont->DrawString(_(kIsExiled).c_str(), x + 30, y, JGETEXT_LEFT);
     }
     JRenderer * renderer = JRenderer::GetInstance();
     JQuadPtr quad = observer->getResourceManager()->RetrieveCard(card, CACHE_THUMB);
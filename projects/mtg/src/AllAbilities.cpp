@@ -1,6 +1,523 @@
 #include "PrecompiledHeader.h"
 #include "AllAbilities.h"
 #include "Translate.h"
+#include "Threading.h"
+
+namespace
+{
+    // compiled expressions, by source string. They are never deleted: WParsedInt hands them out to any thread
+    boost::mutex sExpressionsMutex;
+    map<string, const WParsedIntExpression *> sExpressions;
+
+    // erase(found, found + size) is how these words have always been removed, cards are written against it
+    bool eraseWord(string& s, const string& word)
+    {
+        size_t found = s.find(word);
+        if (found == string::npos)
+            return false;
+        s.erase(found, found + word.size());
+        return true;
+    }
+
+    void toZones(string& theType)
+    {
+        if (theType.find(":") == string::npos)
+            theType.append("|mybattlefield");
+        else
+            replace(theType.begin(), theType.end(), ':', '|');
+    }
+}
+
+const WParsedIntExpression * WParsedIntExpression::get(const string& s)
+{
+    {
+        boost::mutex::scoped_lock lock(sExpressionsMutex);
+        map<string, const WParsedIntExpression *>::iterator it = sExpressions.find(s);
+        if (it != sExpressions.end())
+            return it->second;
+    }
+
+    // compiling "stored..." gets the stored expression, don't hold the lock meanwhile
+    const WParsedIntExpression * expression = NEW WParsedIntExpression(s);
+
+    boost::mutex::scoped_lock lock(sExpressionsMutex);
+    pair<map<string, const WParsedIntExpression *>::iterator, bool> inserted = sExpressions.insert(make_pair(s, expression));
+    if (!inserted.second)
+        delete expression;
+    return inserted.first->second;
+}
+
+WParsedIntExpression::WParsedIntExpression(string s) :
+    kind(EMPTY), value(0), multiplier(1), halfup(false), halfdown(false), twice(false), thrice(false), bonus(0),
+    counterPower(0), counterToughness(0), property(CONVERTED_COST), highest(false), stored(NULL)
+{
+    if (!s.size())
+        return;
+
+    if (s[0] == '-')
+    {
+        s = s.substr(1);
+        multiplier = -1;
+        if (s.find("stored") != string::npos)
+        {
+            kind = STORED;
+            multiplier = 1;
+            stored = get("-" + s.substr(6));
+            return;
+        }
+    }
+    if (s.size() && s[0] == '+')
+    {
+        //ignore "+" signs....
+        s = s.substr(1);
+    }
+    if (s.find("stored") != string::npos)
+    {
+        kind = STORED;
+        stored = get(s.substr(6));
+        return;
+    }
+
+    //rounding values, the words can be written anywhere in the line,
+    //they are erased after parsing.
+    halfup = eraseWord(s, "halfup");
+    halfdown = eraseWord(s, "halfdown");
+    twice = eraseWord(s, "twice");
+    thrice = eraseWord(s, "thrice");
+    if (eraseWord(s, "plusone"))
+        bonus += 1;
+    if (eraseWord(s, "plustwo"))
+        bonus += 2;
+    if (eraseWord(s, "plusthree"))
+        bonus += 3;
+
+    if (s == "prex")
+        kind = PREX;
+    else if (s == "x" || s == "X")
+        kind = X;
+    else if (s == "xx" || s == "XX")
+        kind = XX;
+    else if (s == "castx")
+        kind = CASTX;
+    else if (s == "gear")
+        kind = GEAR;
+    else if (s == "colors")
+        kind = COLORS;
+    else if (s == "auras")
+        kind = AURAS;
+    else if (s == "manacost")
+        kind = MANACOST;
+    else if (s.find("type:") != string::npos)
+    {
+        kind = TYPE_COUNT;
+        argument = s.substr(s.find("type:") + 5);
+        toZones(argument);
+        if (argument.find("mana") != string::npos)
+        {
+            value = ManaCost::parseManaSymbol(argument[4]);
+            argument.replace(0, 5, "*");
+        }
+    }
+    else if (s.find("restriction{") != string::npos)
+    {
+        vector<string> splitRest = parseBetween(s, "restriction{", "}");
+        kind = splitRest.size() ? RESTRICTION : CONSTANT;
+        if (splitRest.size())
+            argument = splitRest[1];
+    }
+    else if (s.find("counter{") != string::npos)
+    {
+        kind = CONSTANT;
+        vector<string> counterString = parseBetween(s, "counter{", "}");
+        if (counterString.size())
+        {
+            // without a target, parsing a counter doesn't depend on the game
+            AbilityFactory abf(NULL);
+            Counter * counter = abf.parseCounter(counterString[1], NULL);
+            if (counter)
+            {
+                kind = COUNTER;
+                counterName = counter->name;
+                counterPower = counter->power;
+                counterToughness = counter->toughness;
+            }
+            SAFE_DELETE(counter);
+        }
+    }
+    else if (s.find("convertedcost:") != string::npos || s.find("power:") != string::npos || s.find("toughness:") != string::npos)
+    {
+        property = CONVERTED_COST;
+        vector<string> convertedType = parseBetween(s, "convertedcost:", ":");
+        if (!convertedType.size())
+        {
+            property = POWER_OF;
+            convertedType = parseBetween(s, "power:", ":");
+        }
+        if (!convertedType.size())
+        {
+            property = TOUGHNESS_OF;
+            convertedType = parseBetween(s, "toughness:", ":");
+        }
+        if (!convertedType.size())
+        {
+            // always 0, rounding and bonus words included
+            kind = CONSTANT;
+            multiplier = 1;
+            halfup = halfdown = twice = thrice = false;
+            bonus = 0;
+            return;
+        }
+        kind = HIGHEST_OR_LOWEST;
+        highest = convertedType[1].find("highest") != string::npos;
+        argument = convertedType[2];
+        toZones(argument);
+    }
+    else if (s == "sunburst")
+        kind = SUNBURST;
+    else if (s == "targetedcurses")
+        kind = TARGETED_CURSES;
+    else if (s == "lifetotal")
+        kind = LIFE_TOTAL;
+    else if (s == "highestlifetotal")
+        kind = HIGHEST_LIFE_TOTAL;
+    else if (s == "lowestlifetotal")
+        kind = LOWEST_LIFE_TOTAL;
+    else if (s == "thatmuch")
+        kind = THAT_MUCH;
+    else if (s == "oplifelost")
+        kind = OPPONENT_LIFE_LOST;
+    else if (s == "lifelost")
+        kind = LIFE_LOST;
+    else if (s == "pdcount")
+        kind = PLAYER_DAMAGE_COUNT;
+    else if (s == "odcount")
+        kind = OPPONENT_DAMAGE_COUNT;
+    else if (s == "playerpoisoncount")
+        kind = PLAYER_POISON_COUNT;
+    else if (s == "opponentpoisoncount")
+        kind = OPPONENT_POISON_COUNT;
+    else if (s == "opponentlifetotal")
+        kind = OPPONENT_LIFE_TOTAL;
+    else if (s == "pdrewcount")
+        kind = PLAYER_DRAW_COUNT;
+    else if (s == "odrewcount")
+        kind = OPPONENT_DRAW_COUNT;
+    else if (s == "p" || s == "power")
+        kind = POWER;
+    else if (s == "t" || s == "toughness")
+        kind = TOUGHNESS;
+    else if (s == "kicked")
+        kind = KICKED;
+    else if (s == "handsize")
+        kind = HAND_SIZE;
+    else if (s == "controllerturn")
+        kind = CONTROLLER_TURN;
+    else if (s == "opponentturn")
+        kind = OPPONENT_TURN;
+    else if (s == "phandcount")
+        kind = PLAYER_HAND_COUNT;
+    else if (s == "ohandcount")
+        kind = OPPONENT_HAND_COUNT;
+    else
+    {
+        kind = CONSTANT;
+        value = atoi(s.c_str());
+    }
+
+    if (kind == CONSTANT)
+        value = applyModifiers(value);
+}
+
+int WParsedIntExpression::applyModifiers(int result) const
+{
+    if (result > 0)
+    {
+        if (halfup)
+        {
+            if (result % 2 == 1)
+                result++;
+            result = result / 2;
+        }
+        if (halfdown)
+            result = result / 2;
+        if (twice)
+            result = result * 2;
+        if (thrice)
+            result = result * 3;
+    }
+    return (result + bonus) * multiplier;
+}
+
+int WParsedIntExpression::evaluate(Spell * spell, MTGCardInstance * card, TargetChooser ** chooser) const
+{
+    if (kind == EMPTY)
+        return 0;
+    if (!card)
+        return kind == CONSTANT ? value : 0;
+    if (!card->storedCard)
+        card->storedCard = card->storedSourceCard;
+    if (kind == CONSTANT)
+        return value;
+    if (kind == STORED)
+        return card->storedCard ? stored->evaluate(spell, card->storedCard, chooser) : 0;
+
+    MTGCardInstance * target = card->target ? card->target : card;
+    return applyModifiers(evaluateKind(spell, card, target, chooser));
+}
+
+TargetChooser * WParsedIntExpression::getChooser(MTGCardInstance * card, TargetChooser ** chooser) const
+{
+    if (chooser && *chooser && (*chooser)->observer == card->getObserver())
+        return *chooser;
+
+    TargetChooserFactory tf(card->getObserver());
+    TargetChooser * tc = tf.createTargetChooser(argument, NULL);
+    if (chooser)
+    {
+        SAFE_DELETE(*chooser);
+        *chooser = tc;
+    }
+    return tc;
+}
+
+int WParsedIntExpression::evaluateKind(Spell * spell, MTGCardInstance * card, MTGCardInstance * target, TargetChooser ** chooser) const
+{
+    int intValue = 0;
+    switch (kind)
+    {
+    case PREX:
+    {
+        ManaCost * cX = card->controller()->getManaPool()->Diff(card->getManaCost());
+        intValue = cX->getCost(Constants::NB_Colors);
+        delete cX;
+        break;
+    }
+    case X:
+        intValue = WParsedInt::computeX(spell, card);
+        if (intValue < 0)
+            intValue = 0;
+        break;
+    case XX:
+        intValue = WParsedInt::computeX(spell, card) / 2;
+        if (intValue < 0)
+            intValue = 0;
+        break;
+    case CASTX:
+        intValue = card->castX;
+        break;
+    case GEAR:
+        intValue = target->equipment;
+        break;
+    case COLORS:
+        intValue = target->countColors();
+        break;
+    case AURAS:
+        intValue = target->auras;
+        break;
+    case MANACOST:
+        intValue = target->getManaCost()->getConvertedCost();
+        break;
+    case TYPE_COUNT:
+    {
+        TargetChooser * tc = getChooser(card, chooser);
+        if (!tc)
+            break;
+        for (int i = 0; i < 2; i++)
+        {
+            Player * p = card->getObserver()->players[i];
+            MTGGameZone * zones[] = { p->game->inPlay, p->game->graveyard, p->game->hand, p->game->library };
+            for (int k = 0; k < 4; k++)
+            {
+                MTGGameZone * zone = zones[k];
+                if (tc->targetsZone(zone, card))
+                {
+                    if (value)
+                        intValue += zone->countTotalManaSymbols(tc, value);
+                    else
+                        intValue += zone->countByCanTarget(tc);
+                }
+            }
+        }
+        if (!chooser)
+            SAFE_DELETE(tc);
+        break;
+    }
+    case RESTRICTION:
+    {
+        AbilityFactory abf(target->getObserver());
+        if (abf.parseCastRestrictions(target, target->controller(), argument))
+            intValue = 1;
+        break;
+    }
+    case COUNTER:
+    {
+        Counter * targetCounter = target->counters ? target->counters->hasCounter(counterName.c_str(), counterPower, counterToughness) : NULL;
+        if (targetCounter)
+            intValue = targetCounter->nb;
+        break;
+    }
+    case HIGHEST_OR_LOWEST:
+    {
+        TargetChooser * tc = getChooser(card, chooser);
+        if (!tc)
+            break;
+        int highestValue = 0;
+        int lowestValue = 5000;
+        for (int i = 0; i < 2; i++)
+        {
+            Player * p = card->getObserver()->players[i];
+            MTGGameZone * zones[] = { p->game->battlefield, p->game->graveyard, p->game->hand, p->game->library };
+            for (int k = 0; k < 4; k++)
+            {
+                MTGGameZone * zone = zones[k];
+                if (!tc->targetsZone(zone, target))
+                    continue;
+                for (size_t w = 0; w < zone->cards.size(); ++w)
+                {
+                    MTGCardInstance * cCard = zone->cards[w];
+                    if (!tc->canTarget(cCard))
+                        continue;
+                    int check = cCard->getManaCost()->getConvertedCost();
+                    if (property == POWER_OF)
+                        check = cCard->power;
+                    else if (property == TOUGHNESS_OF)
+                        check = cCard->toughness;
+                    if (check > highestValue)
+                        highestValue = check;
+                    if (check <= lowestValue)
+                        lowestValue = check;
+                }
+            }
+        }
+        if (lowestValue == 5000)
+            lowestValue = 0;
+        if (!chooser)
+            SAFE_DELETE(tc);
+        intValue = highest ? highestValue : lowestValue;
+        break;
+    }
+    case SUNBURST:
+        if (card->previous && card->previous->previous)
+            intValue = card->previous->previous->sunburst;
+        break;
+    case TARGETED_CURSES:
+        if (card->playerTarget)
+            intValue = card->playerTarget->curses.size();
+        break;
+    case LIFE_TOTAL:
+        intValue = target->controller()->life;
+        break;
+    case HIGHEST_LIFE_TOTAL:
+        intValue = max(target->controller()->life, target->controller()->opponent()->life);
+        break;
+    case LOWEST_LIFE_TOTAL:
+        intValue = min(target->controller()->life, target->controller()->opponent()->life);
+        break;
+    case THAT_MUCH:
+    {
+        //the value that much is a variable to be used with triggered abilities.
+        //ie:when ever you gain life, draw that many cards. when used in a trigger draw:thatmuch, will return the value
+        //that the triggered event stored in the card for "that much".
+        intValue = target->thatmuch;
+        if ((target->hasSubtype(Subtypes::TYPE_AURA) || target->hasSubtype(Subtypes::TYPE_EQUIPMENT)) && target->target
+            && target->target->thatmuch > intValue)
+            intValue = target->target->thatmuch;
+        if (card->thatmuch > intValue)
+            intValue = card->thatmuch;
+        break;
+    }
+    case OPPONENT_LIFE_LOST:
+        intValue = target->controller()->opponent()->lifeLostThisTurn;
+        break;
+    case LIFE_LOST:
+        intValue = target->controller()->lifeLostThisTurn;
+        break;
+    case PLAYER_DAMAGE_COUNT:
+        intValue = target->controller()->damageCount;
+        break;
+    case OPPONENT_DAMAGE_COUNT:
+        intValue = target->controller()->opponent()->damageCount;
+        break;
+    case PLAYER_POISON_COUNT:
+        intValue = target->controller()->poisonCount;
+        break;
+    case OPPONENT_POISON_COUNT:
+        intValue = target->controller()->opponent()->poisonCount;
+        break;
+    case OPPONENT_LIFE_TOTAL:
+        intValue = target->controller()->opponent()->life;
+        break;
+    case PLAYER_DRAW_COUNT:
+        intValue = target->controller()->drawCounter;
+        break;
+    case OPPONENT_DRAW_COUNT:
+        intValue = target->controller()->opponent()->drawCounter;
+        break;
+    case POWER:
+        intValue = target->getPower();
+        break;
+    case TOUGHNESS:
+        intValue = target->getToughness();
+        break;
+    case KICKED:
+        intValue = target->kicked;
+        break;
+    case HAND_SIZE:
+        intValue = target->controller()->handsize;
+        break;
+    case CONTROLLER_TURN:
+        //1 if it's the turn of the controller
+        if (target->controller() == target->getObserver()->currentPlayer)
+            intValue = 1;
+        break;
+    case OPPONENT_TURN:
+        if (target->controller()->opponent() == target->getObserver()->currentPlayer)
+            intValue = 1;
+        break;
+    case PLAYER_HAND_COUNT:
+        intValue = target->controller()->game->hand->nb_cards;
+        break;
+    case OPPONENT_HAND_COUNT:
+        intValue = target->controller()->opponent()->game->hand->nb_cards;
+        break;
+    default:
+        break;
+    }
+    return intValue;
+}
+
+WParsedPTExpression::WParsedPTExpression(const string& s) :
+    powerChooser(NULL), toughnessChooser(NULL)
+{
+    string p, t;
+    ok = WParsedPT::split(s, p, t);
+    power = WParsedIntExpression::get(p);
+    toughness = WParsedIntExpression::get(t);
+}
+
+// the target choosers belong to the game of the copy
+WParsedPTExpression::WParsedPTExpression(const WParsedPTExpression& other) :
+    ok(other.ok), power(other.power), toughness(other.toughness), powerChooser(NULL), toughnessChooser(NULL)
+{
+}
+
+WParsedPTExpression::~WParsedPTExpression()
+{
+    SAFE_DELETE(powerChooser);
+    SAFE_DELETE(toughnessChooser);
+}
+
+bool WParsedPTExpression::isConstant() const
+{
+    return power->isConstant() && toughness->isConstant();
+}
+
+void WParsedPTExpression::evaluate(WParsedPT& result, Spell * spell, MTGCardInstance * card)
+{
+    result.ok = ok;
+    result.power.intValue = power->evaluate(spell, card, &powerChooser);
+    result.toughness.intValue = toughness->evaluate(spell, card, &toughnessChooser);
+}
 
 
 //display a text animation, this is not a real ability.
@@ -355,7 +355,7 @@ void CardGui::Render()
 JQuadPtr CardGui::AlternateThumbQuad(MTGCard * card)
 {
     JQuadPtr q;
-    vector<ModRulesBackGroundCardGuiItem *>items = gModRules.cardgui.background;
+    const vector<ModRulesBackGroundCardGuiItem *>& items = gModRules.cardgui.background;
     ModRulesBackGroundCardGuiItem * item;
     int numItems = (int)items.size();
     if (card->data->countColors() > 1)
@@ -369,7 +369,6 @@ JQuadPtr CardGui::AlternateThumbQuad(MTGCard * card)
     
     
     q = WResourceManager::Instance()->RetrieveTempQuad(item->mDisplayThumb);
-    items.clear();  
     if (q && q->mTex)
         q->SetHotSpot(static_cast<float> (q->mTex->mWidth / 2), static_cast<float> (q->mTex->mHeight / 2));
     return q;
@@ -383,7 +382,7 @@ void CardGui::AlternateRender(MTGCard * card, const Pos& pos)
 
     float x = pos.actX;
    
-    vector<ModRulesBackGroundCardGuiItem *>items = gModRules.cardgui.background;
+    const vector<ModRulesBackGroundCardGuiItem *>& items = gModRules.cardgui.background;
     ModRulesBackGroundCardGuiItem * item;
     int numItems = (int)items.size();
     if (card->data->countColors() > 1)
@@ -397,7 +396,6 @@ void CardGui::AlternateRender(MTGCard * card, const Pos& pos)
     
     q = WResourceManager::Instance()->RetrieveTempQuad(item->mDisplayImg,TEXTURE_SUB_5551);
 
-    items.clear();
     if (q.get() && q->mTex)
     {
         q->SetHotSpot(static_cast<float> (q->mTex->mWidth / 2), static_cast<float> (q->mTex->mHeight / 2));
@@ -407,7 +405,7 @@ void CardGui::AlternateRender(MTGCard * card, const Pos& pos)
         renderer->RenderQuad(q.get(), x, pos.actY, pos.actT, scale, scale);
     }
 
-    vector<ModRulesRenderCardGuiItem *>Carditems = gModRules.cardgui.renderbig;
+    const vector<ModRulesRenderCardGuiItem *>& Carditems = gModRules.cardgui.renderbig;
     
     WFont * font = WResourceManager::Instance()->GetWFont(Fonts::MAGIC_FONT);
     float backup_scale = font->GetScale();
@@ -436,12 +434,12 @@ void CardGui::AlternateRender(MTGCard * card, const Pos& pos)
             if (Carditem->mName == "description")
             {
 
-                std::vector<string> txt = card->data->getFormattedText();
+                const std::vector<string>& txt = card->data->getFormattedText();
 
                 unsigned i = 0;
                 unsigned h = neofont ? 14 : 11;
                 for (std::vector<string>::const_iterator it = txt.begin(); it != txt.end(); ++it, ++i)
-                    font->DrawString(_(it->c_str()), x + (Carditem->mPosX - BigWidth / 2) * pos.actZ, pos.actY + (-BigHeight / 2 + Carditem->mPosY + h * i) * pos.actZ);
+                    font->DrawString(_(*it), x + (Carditem->mPosX - BigWidth / 2) * pos.actZ, pos.actY + (-BigHeight / 2 + Carditem->mPosY + h * i) * pos.actZ);
             }
             else if (Carditem->mName == "mana")
             {
@@ -668,7 +666,7 @@ void CardGui::TinyCropRender(MTGCard * card, const Pos& pos, JQuad * quad)
     float x = pos.actX;
     float displayScale = 250 / BigHeight;
    
-    vector<ModRulesBackGroundCardGuiItem *>items = gModRules.cardgui.background;
+    const vector<ModRulesBackGroundCardGuiItem *>& items = gModRules.cardgui.background;
     ModRulesBackGroundCardGuiItem * item;
     int numItems = (int)items.size();
     if (card->data->countColors() > 1)
@@ -681,7 +679,6 @@ void CardGui::TinyCropRender(MTGCard * card, const Pos& pos, JQuad * quad)
     }
     
     q = WResourceManager::Instance()->RetrieveTempQuad(item->mDisplayImg,TEXTURE_SUB_5551);
-    items.clear();
     if (q.get() && q->mTex)
     {
         q->SetHotSpot(static_cast<float> (q->mTex->mWidth / 2), static_cast<float> (q->mTex->mHeight / 2));
@@ -691,7 +688,7 @@ void CardGui::TinyCropRender(MTGCard * card, const Pos& pos, JQuad * quad)
         renderer->RenderQuad(q.get(), x, pos.actY, pos.actT, scale, scale);
     }
     
-    std::vector<string> txt = card->data->getFormattedText();
+    const std::vector<string>& txt = card->data->getFormattedText();
     size_t nbTextLines = txt.size();
 
     //Render the image on top of that
@@ -707,7 +704,7 @@ void CardGui::TinyCropRender(MTGCard * card, const Pos& pos, JQuad * quad)
 
 
 
-    vector<ModRulesRenderCardGuiItem *>Carditems = gModRules.cardgui.rendertinycrop;
+    const vector<ModRulesRenderCardGuiItem *>& Carditems = gModRules.cardgui.rendertinycrop;
     
     WFont * font = WResourceManager::Instance()->GetWFont(Fonts::MAGIC_FONT);
     float backup_scale = font->GetScale();
@@ -734,7 +731,7 @@ void CardGui::TinyCropRender(MTGCard * card, const Pos& pos, JQuad * quad)
             if (Carditem->mName == "description")
             {
 
-                std::vector<string> txt = card->data->getFormattedText();
+                const std::vector<string>& txt = card->data->getFormattedText();
                 float imgBottom = imgY + (imgScale * quad->mHeight / 2);
 
                 unsigned i = 0;
@@ -1352,7 +1349,7 @@ void CardGui::RenderCountersBig(MTGCard * mtgcard, const Pos& pos, int drawMode)
     unsigned i = 0; 
     if (drawMode == DrawMode::kText)
     {
-        std::vector<string> txt = card->data->getFormattedText();
+        const std::vector<string>& txt = card->data->getFormattedText();
         i = txt.size() + 1;
     }
     
@@ -1390,12 +1387,14 @@ void CardGui::RenderCountersBig(MTGCard * mtgcard, const Pos& pos, int drawMode)
             {
                 std::string s = c->name;
                 s[0] = toupper(s[0]);
-                sprintf(buf, _("%s: %i").c_str(), s.c_str(), c->nb);
+                static const TranslationKey kCounterFormat("%s: %i");
+                sprintf(buf, _(kCounterFormat).c_str(), s.c_str(), c->nb);
             }
         }
         else
         {
-            sprintf(buf, _("%s%i/%s%i").c_str(), ((c->power > 0) ? "+": ""), c->power * c->nb, ((c->toughness > 0) ? "+": ""),c->toughness* c->nb);
+            static const TranslationKey kPTCounterFormat("%s%i/%s%i");
+            sprintf(buf, _(kPTCounterFormat).c_str(), ((c->power > 0) ? "+": ""), c->power * c->nb, ((c->toughness > 0) ? "+": ""),c->toughness* c->nb);
         }
 
         if (!gfx.size())
@@ -30,15 +30,17 @@ namespace
 SUPPORT_OBJECT_ANALYTICS(CardPrimitive)
 
 CardPrimitive::CardPrimitive()
-    : colors(0)
+    : detailsFile(-1), detailsOffset(0), colors(0)
 {
     init();
 }
 
 CardPrimitive::CardPrimitive(CardPrimitive * source)
+    : detailsFile(-1), detailsOffset(0)
 {
     if(!source)
         return;
+    source->loadDetails();
     basicAbilities = source->basicAbilities;
 
     for (size_t i = 0; i < source->types.size(); ++i)
@@ -72,6 +74,17 @@ CardPrimitive::~CardPrimitive()
     SAFE_DELETE(restrictions);
 }
 
+void CardPrimitive::readDetails()
+{
+    MTGAllCards::getInstance()->loadDetails(this);
+}
+
+void CardPrimitive::unshareRestrictions()
+{
+    if (restrictions)
+        restrictions = restrictions->clone();
+}
+
 int CardPrimitive::init()
 {
     basicAbilities.reset();
@@ -276,6 +289,7 @@ void CardPrimitive::setText(const string& value)
 */
 const vector<string>& CardPrimitive::getFormattedText()
 {
+    loadDetails();
     if (!text.size())
         return formattedText;
 
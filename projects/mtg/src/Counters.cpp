@@ -2,6 +2,7 @@
 
 #include "Counters.h"
 #include "MTGCardInstance.h"
+#include "StateHash.h"
 
 Counter::Counter(MTGCardInstance * _target, int _power, int _toughness)
 {
@@ -44,6 +45,7 @@ int Counter::cancelCounter(int power, int toughness)
         GameObserver *g = this->target->getObserver();
         this->removed();
         this->nb--;
+        this->target->counters->updateStateHash();
         WEvent * t = NEW WEventCounters(NULL,"",power*-1,toughness*-1,false,true);
         dynamic_cast<WEventCounters*>(t)->targetCard = this->target;
         g->receiveEvent(t);
@@ -73,7 +75,7 @@ int Counter::removed()
 }
 
 Counters::Counters(MTGCardInstance * _target) :
-    target(_target)
+    target(_target), stateHash(0)
 {
     mCount = 0;
 }
@@ -99,6 +101,7 @@ int Counters::addCounter(const char * _name, int _power, int _toughness)
             {
                 counters[i]->added();
                 counters[i]->nb++;
+                updateStateHash();
                 WEvent * j = NEW WEventCounters(this,_name,_power,_toughness,true,false);
                 dynamic_cast<WEventCounters*>(j)->targetCard = this->target;
                 g->receiveEvent(j);
@@ -113,6 +116,7 @@ int Counters::addCounter(const char * _name, int _power, int _toughness)
         dynamic_cast<WEventCounters*>(w)->targetCard = this->target;
         g->receiveEvent(w);
         mCount++;
+        updateStateHash();
         this->target->doDamageTest = 1;
         this->target->afterDamage();
     }
@@ -135,9 +139,24 @@ int Counters::init()
             counters[i]->nb--;
         }
     }
+    updateStateHash();
     return 1;
 }
 
+void Counters::updateStateHash()
+{
+    uint64_t hash = 0;
+    for (int i = 0; i < mCount; i++)
+    {
+        Counter * counter = counters[i];
+        if (counter->nb > 0)
+            hash ^= StateHash::key(StateHash::COUNTER, target->getId(), StateHash::stringKey(counter->name),
+                            (counter->power << 16) ^ (counter->toughness & 0xFFFF), counter->nb);
+    }
+    stateHash = hash;
+    target->updateStateHash();
+}
+
 int Counters::removeCounter(const char * _name, int _power, int _toughness)
 {
     for (int i = 0; i < mCount; i++)
@@ -148,6 +167,7 @@ int Counters::removeCounter(const char * _name, int _power, int _toughness)
                 return 0;
             counters[i]->removed();
             counters[i]->nb--;
+            updateStateHash();
             GameObserver *g = target->getObserver();
             WEvent * e = NEW WEventCounters(this,_name,_power,_toughness,false,true);
             dynamic_cast<WEventCounters*>(e)->targetCard = this->target;
@@ -292,7 +292,7 @@ void DeckMenu::Render()
                 }
                 
                 // fill in the description part of the screen
-				string text = wordWrap(_(currentMenuItem->getDescription()), descWidth, descriptionFont->mFontID );
+				const string& text = wordWrap(_(currentMenuItem->getDescription()), descWidth, descriptionFont->mFontID );
                 descriptionFont->DrawString(text.c_str(), descX, descY);
                 
                 // fill in the statistical portion
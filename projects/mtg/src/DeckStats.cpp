@@ -6,6 +6,7 @@
 #include "GameObserver.h"
 #include "MTGDeck.h"
 #include "ManaCostHybrid.h"
+#include "GoldfishSimulator.h"
 
 DeckStats * DeckStats::mInstance = NULL;
     
@@ -119,8 +120,58 @@ int DeckStats::percentVictories()
     return 50;
 }
 
+string DeckStats::journalFile(const string& filename)
+{
+    size_t extension = filename.rfind(".txt");
+    if (extension == string::npos)
+        return filename + ".log";
+    return filename.substr(0, extension) + ".log";
+}
+
+void DeckStats::addGame(const string& filename, const string& opponentsFile, int victory, const string& manaColorIndex)
+{
+    map<string, DeckStat *>& stats = masterDeckStats[filename];
+    map<string, DeckStat *>::iterator it = stats.find(opponentsFile);
+    if (it == stats.end())
+    {
+        stats.insert(make_pair(opponentsFile, NEW DeckStat(1, victory, manaColorIndex)));
+        return;
+    }
+    it->second->victories += victory;
+    it->second->nbgames += 1;
+    if (it->second->manaColorIndex == "")
+        it->second->manaColorIndex = manaColorIndex;
+}
+
+void DeckStats::loadJournal(const string& filename)
+{
+    int games = 0;
+    std::string contents;
+    if (JFileSystem::GetInstance()->readIntoString(journalFile(filename), contents))
+    {
+        std::stringstream stream(contents);
+        std::string s;
+        while (std::getline(stream, s))
+        {
+            // victory opponentdeck manacolorindex ;
+            std::stringstream record(s);
+            int victory = 0;
+            string deckfile, manaColorIndex, end;
+            record >> victory >> deckfile >> manaColorIndex >> end;
+            if (end != ";")
+                continue; //the game was being written when we stopped
+            if (manaColorIndex == "-")
+                manaColorIndex = "";
+            addGame(filename, deckfile, victory, manaColorIndex);
+            games++;
+        }
+    }
+    journalSizes[filename] = games;
+}
+
 void DeckStats::load(const std::string& filename)
 {
+    boost::recursive_mutex::scoped_lock lock(mMutex);
 
     currentDeck = filename;
     if ( masterDeckStats.find(filename) != masterDeckStats.end() )
@@ -175,25 +226,32 @@ void DeckStats::load(const std::string& filename)
             DeckStat * newDeckStat = NEW DeckStat(games, victories, manaColorIndex);
             (masterDeckStats[filename])[deckfile] = newDeckStat;
         }
+
+        // the games played since the file was written
+        loadJournal(filename);
     }
 }
 
 void DeckStats::save(const std::string& filename)
 {
+    boost::recursive_mutex::scoped_lock lock(mMutex);
+
+    // written aside then renamed, so that the file is never seen half written
+    string tempFile = filename + ".tmp";
     std::ofstream file;
-    if (JFileSystem::GetInstance()->openForWrite(file, filename))
+    if (JFileSystem::GetInstance()->openForWrite(file, tempFile))
     {
         char writer[512];
-        map<string, DeckStat *> stats = masterDeckStats[currentDeck];
+        map<string, DeckStat *> stats = masterDeckStats[filename];
         map<string, DeckStat *>::iterator it;
-        string manaColorIndex = "";
         int deckId = atoi(filename.substr(filename.find("_deck") + 5, filename.find(".txt")).c_str());
         char buffer[512];
         sprintf(buffer, "deck%i.txt", deckId);
         string playerDeckFilePath= options.profileFile( buffer);
         DeckManager *deckManager = DeckManager::GetInstance();
         DeckMetaData *playerDeckMeta = deckManager->getDeckMetaDataByFilename(playerDeckFilePath, false);
-        if (playerDeckMeta && playerDeckMeta->getColorIndex() == "" )
+        string manaColorIndex = playerDeckMeta ? playerDeckMeta->getColorIndex() : "";
+        if (playerDeckMeta && manaColorIndex == "" )
         {
             StatsWrapper *stw = deckManager->getExtendedDeckStats( playerDeckMeta, MTGAllCards::getInstance(), false);
             manaColorIndex = stw->getManaColorIndex();
@@ -212,6 +270,14 @@ void DeckStats::save(const std::string& filename)
             file << "MANA:" << it->second->manaColorIndex <<endl;
         }
         file.close();
+        JFileSystem::GetInstance()->Rename(tempFile, filename);
+
+        // everything in the journal is in the file now
+        std::ofstream journal;
+        if (JFileSystem::GetInstance()->openForWrite(journal, journalFile(filename), ios_base::out | ios_base::trunc))
+            journal.close();
+        journalSizes[filename] = 0;
+
         if(playerDeckMeta)
             playerDeckMeta->Invalidate();
     }
@@ -229,37 +295,53 @@ void DeckStats::saveStats(Player *player, Player *opponent, GameObserver * game)
     {
         victory = 0;
     }
+
+    boost::recursive_mutex::scoped_lock lock(mMutex);
     load(currentDeck);
-    map<string, DeckStat *> *stats = &masterDeckStats[currentDeck];
-    map<string, DeckStat *>::iterator it = stats->find(opponent->deckFileSmall);
-    string manaColorIndex = "";
     DeckManager *deckManager = DeckManager::GetInstance();
-    DeckMetaData *aiDeckMeta = deckManager->getDeckMetaDataByFilename( opponent->deckFile, true);
-    StatsWrapper *stw = deckManager->getExtendedDeckStats( aiDeckMeta, MTGAllCards::getInstance(), true);
-    manaColorIndex = stw->getManaColorIndex();
-    if (it == stats->end())
+
+    // the mana colors of the AI deck only need to be worked out the first time we play against it
+    string manaColorIndex = "";
+    map<string, DeckStat *>::iterator it = masterDeckStats[currentDeck].find(opponent->deckFileSmall);
+    if (it == masterDeckStats[currentDeck].end() || it->second->manaColorIndex == "")
+    {
+        DeckMetaData *aiDeckMeta = deckManager->getDeckMetaDataByFilename( opponent->deckFile, true);
+        StatsWrapper *stw = deckManager->getExtendedDeckStats( aiDeckMeta, MTGAllCards::getInstance(), true);
+        manaColorIndex = stw->getManaColorIndex();
+    }
+    addGame(currentDeck, opponent->deckFileSmall, victory, manaColorIndex);
+
+    map<string, int>::iterator journal = journalSizes.find(currentDeck);
+    if (journal == journalSizes.end() || journal->second + 1 >= JOURNAL_MAX_GAMES)
     {
-        stats->insert( make_pair( opponent->deckFileSmall, NEW DeckStat(1, victory, manaColorIndex) ));
+        save(currentDeck);
     }
     else
     {
-        it->second->victories += victory;
-        it->second->nbgames += 1;
-        if ( it->second->manaColorIndex == "" )
+        std::ofstream file;
+        if (JFileSystem::GetInstance()->openForWrite(file, journalFile(currentDeck), ios_base::out | ios_base::app))
+        {
+            // one write per game, a game is either in the journal or not
+            std::ostringstream record;
+            record << victory << " " << opponent->deckFileSmall << " " << (manaColorIndex.size() ? manaColorIndex : "-") << " ;\n";
+            file << record.str();
+            file.close();
+            journal->second++;
+        }
+        else
         {
-            it->second->manaColorIndex = manaColorIndex;
+            save(currentDeck);
         }
     }
-    save(currentDeck);
     
-    DeckMetaData* playerMeta = DeckManager::GetInstance()->getDeckMetaDataByFilename(player->deckFile, false);
+    DeckMetaData* playerMeta = deckManager->getDeckMetaDataByFilename(player->deckFile, false);
 
     // metadata caches its internal data (number of games, victories, etc)
     // tell it to refresh when stats are updated
     if (playerMeta)
         playerMeta->Invalidate();
 
-    DeckMetaData* aiMeta = DeckManager::GetInstance()->getDeckMetaDataByFilename(opponent->deckFile, true);
+    DeckMetaData* aiMeta = deckManager->getDeckMetaDataByFilename(opponent->deckFile, true);
     if (aiMeta)
         aiMeta->Invalidate();
 }
@@ -301,7 +383,12 @@ void StatsWrapper::initValues()
     avgManaCost = avgCreatureCost = avgSpellCost = 0.0f;
 
     countCreatures = countSpells = countInstants = countEnchantments = countSorceries = countArtifacts = 0;
-    
+
+    simulationNeedUpdate = true;
+    simulatedGames = 0;
+    mulliganProb = 0.0f;
+    for (int i = 0; i < Constants::STATS_FOR_TURNS; i++)
+        spellCastByTurn[i] = colorScrewProbInTurn[i] = manaUsedInTurn[i] = 0.0f;
 }
 
 StatsWrapper::StatsWrapper(int deckId)
@@ -396,6 +483,7 @@ void StatsWrapper::updateStats(DeckDataWrapper *myDeck)
 	if (!this->needUpdate || !myDeck) return;
 
 	this->needUpdate = false;
+    this->simulationNeedUpdate = true;
     this->cardCount = myDeck->getCount(WSrcDeck::UNFILTERED_COPIES);
     this->countLands = myDeck->getCount(Constants::MTG_COLOR_LAND);
     this->totalPrice = myDeck->totalPrice();
@@ -485,7 +573,7 @@ void StatsWrapper::updateStats(DeckDataWrapper *myDeck)
         }
 
         vector<string> abilitiesVector;
-        string thisstring = current->data->magicText;
+        string thisstring = current->data->getMagicText();
         abilitiesVector = split(thisstring, '\n');
 
         for (int v = 0; v < (int) abilitiesVector.size(); v++)
@@ -584,6 +672,26 @@ void StatsWrapper::updateStats(DeckDataWrapper *myDeck)
     }
 }
 
+void StatsWrapper::simulate(DeckDataWrapper *myDeck)
+{
+    if (!this->simulationNeedUpdate || !myDeck) return;
+
+    this->simulationNeedUpdate = false;
+    GoldfishSimulator simulator(myDeck);
+    GoldfishSimulator::Results results;
+    simulator.run(results);
+
+    this->simulatedGames = results.games;
+    float games = (float) max(results.games, 1);
+    this->mulliganProb = results.mulligans * 100 / games;
+    for (int i = 0; i < Constants::STATS_FOR_TURNS; i++)
+    {
+        this->spellCastByTurn[i] = results.spellCastBy[i] * 100 / games;
+        this->colorScrewProbInTurn[i] = results.colorScrewed[i] * 100 / games;
+        this->manaUsedInTurn[i] = results.manaAvailable[i] ? (float) results.manaUsed[i] * 100 / results.manaAvailable[i] : 0;
+    }
+}
+
 // This should probably be cached in DeckDataWrapper
 // or at least be calculated for all common types in one go
 int StatsWrapper::countCardsByType(const char * _type, DeckDataWrapper * myDeck)
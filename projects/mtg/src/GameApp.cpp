@@ -316,6 +316,7 @@ void GameApp::Destroy()
 
     Translator::EndInstance();
     WCFilterFactory::Destroy();
+    WCardIndex::Destroy();
     SimpleMenu::destroy();
     DeckMenu::destroy();
     DeckEditorMenu::destroy();
@@ -420,6 +421,8 @@ void GameApp::Render()
     JRenderer * renderer = JRenderer::GetInstance();
     renderer->ClearScreen(ARGB(0,0,0,0));
 
+    WResourceManager::Instance()->FlushDecodedTextures();
+
     if (mCurrentState)
         mCurrentState->Render();
 
@@ -15,6 +15,7 @@
 #include "Trash.h"
 #include "DeckManager.h"
 #include "GuiCombat.h"
+#include "StateHash.h"
 #include <algorithm>
 #ifdef TESTSUITE
 #include "TestSuiteAI.h"
@@ -41,6 +42,7 @@ void GameObserver::cleanup()
     isInterrupting = NULL;
     currentPlayerId = 0;
     mCurrentGamePhase = MTG_PHASE_INVALID;
+    mStateVersion = 0;
     targetChooser = NULL;
     cardWaitingForTargets = NULL;
     mExtraPayment = NULL;
@@ -56,6 +58,7 @@ void GameObserver::cleanup()
 GameObserver::~GameObserver()
 {
     LOG("==Destroying GameObserver==");
+    MemoryPool::Scope poolScope(mPool);
 
     for (size_t i = 0; i < players.size(); ++i)
     {
@@ -76,12 +79,16 @@ GameObserver::~GameObserver()
     SAFE_DELETE(mTrash);
     SAFE_DELETE(mDeckManager);
 
+    mPool->release();
 }
 
 GameObserver::GameObserver(WResourceManager *output, JGE* input)
     : mSeed((unsigned int)time(0)), randomGenerator(mSeed, true), mResourceManager(output), mJGE(input)
 
 {
+    mPool = NEW MemoryPool();
+    MemoryPool::Scope poolScope(mPool);
+
     ExtraRules = new MTGCardInstance[2]();
 
     mGameType = GAME_TYPE_CLASSIC;
@@ -293,6 +300,7 @@ void GameObserver::nextCombatStep()
 
 void GameObserver::userRequestNextGamePhase(bool allowInterrupt, bool log)
 {
+    MemoryPool::Scope poolScope(mPool);
     if(log) {
         stringstream stream;
         stream << "next " << allowInterrupt << " " <<mCurrentGamePhase;
@@ -389,6 +397,7 @@ void GameObserver::resetStartupGame()
 
 void GameObserver::startGame(GameType gtype, Rules * rules)
 {
+    MemoryPool::Scope poolScope(mPool);
     mGameType = gtype;
     turn = 0;
     mRules = rules;
@@ -414,8 +423,8 @@ void GameObserver::startGame(GameType gtype, Rules * rules)
     {
         for (int i = 0; i < players[0]->game->hand->nb_cards; i++)
         {
-            WResourceManager::Instance()->RetrieveCard(players[0]->game->hand->cards[i], CACHE_THUMB);
-            WResourceManager::Instance()->RetrieveCard(players[0]->game->hand->cards[i]);
+            WResourceManager::Instance()->PrefetchCard(players[0]->game->hand->cards[i], PREFETCH_HIGH, CACHE_THUMB);
+            WResourceManager::Instance()->PrefetchCard(players[0]->game->hand->cards[i], PREFETCH_HIGH);
         }
     }
 
@@ -543,6 +552,44 @@ bool GameObserver::operator==(const GameObserver& aGame)
     return (error == 0);
 }
 
+uint64_t GameObserver::getStateHash()
+{
+    uint64_t hash = StateHash::key(StateHash::PHASE, mCurrentGamePhase) ^ StateHash::key(StateHash::CURRENT_PLAYER, currentPlayerId);
+
+    for (int i = 0; i < 2; i++)
+    {
+        Player * p = players[i];
+        if (!p)
+            continue;
+        hash ^= StateHash::key(StateHash::LIFE, i, p->life);
+        hash ^= StateHash::key(StateHash::POISON, i, p->poisonCount);
+        for (int color = 0; color < Constants::NB_Colors; color++)
+            hash ^= StateHash::key(StateHash::MANA, i * Constants::NB_Colors + color, p->getManaPool()->getCost(color));
+
+        // the cards are kept hashed by their zone, the zone sets the key they are mixed with
+        MTGGameZone * zones[] = { p->game->graveyard, p->game->library, p->game->hand, p->game->inPlay, p->game->stack, p->game->exile };
+        for (int j = 0; j < 6; j++)
+        {
+            uint64_t zoneKey = StateHash::key(StateHash::ZONE, i * 8 + j, zones[j]->nb_cards);
+            hash ^= StateHash::mix(zoneKey ^ zones[j]->stateHash);
+        }
+    }
+
+    // abilities and effects waiting on the stack, there's only a handful between two cleanups
+    if (mLayers)
+    {
+        ActionStack * stack = mLayers->stackLayer();
+        for (size_t i = 0; i < stack->mObjects.size(); i++)
+        {
+            Interruptible * action = (Interruptible *) stack->mObjects[i];
+            if (action->state == NOT_RESOLVED)
+                hash ^= StateHash::key(StateHash::STACK, action->type, action->source ? action->source->getId() : 0, (int) i, 0);
+        }
+    }
+
+    return hash;
+}
+
 void GameObserver::dumpAssert(bool val)
 {
     if(!val)
@@ -555,6 +602,7 @@ void GameObserver::dumpAssert(bool val)
 
 void GameObserver::Update(float dt)
 {
+    MemoryPool::Scope poolScope(mPool);
     Player * player = currentPlayer;
     if (MTG_PHASE_COMBATBLOCKERS == mCurrentGamePhase && BLOCKERS == combatStep)
     {
@@ -1072,6 +1120,7 @@ void GameObserver::Render()
 
 void GameObserver::ButtonPressed(PlayGuiObject * target)
 {
+    MemoryPool::Scope poolScope(mPool);
     DebugTrace("GAMEOBSERVER Click");
     if (CardView* cardview = dynamic_cast<CardView*>(target))
     {
@@ -1124,6 +1173,7 @@ void GameObserver::ButtonPressed(PlayGuiObject * target)
 
 void GameObserver::stackObjectClicked(Interruptible * action)
 {
+    MemoryPool::Scope poolScope(mPool);
     stringstream stream;
     stream << "stack[" << mLayers->stackLayer()->getIndexOf(action) << "]";
     logAction(currentlyActing(), stream.str());
@@ -1170,6 +1220,7 @@ bool GameObserver::WaitForExtraPayment(MTGCardInstance * card)
 
 int GameObserver::cardClick(MTGCardInstance * card, MTGAbility *ability)
 {
+    MemoryPool::Scope poolScope(mPool);
     MTGGameZone* zone = card->currentZone;
     size_t index  = 0;
     if(zone)
@@ -1190,6 +1241,7 @@ int GameObserver::cardClick(MTGCardInstance * card, MTGAbility *ability)
 
 int GameObserver::cardClick(MTGCardInstance * card, int abilityType)
 {
+    MemoryPool::Scope poolScope(mPool);
     int result = 0;
     MTGAbility * a = mLayers->actionLayer()->getAbility(abilityType);
 
@@ -1216,6 +1268,7 @@ int GameObserver::cardClickLog(bool log, Player* clickedPlayer, MTGGameZone* zon
 
 int GameObserver::cardClick(MTGCardInstance * card, Targetable * object, bool log)
 {
+    MemoryPool::Scope poolScope(mPool);
     Player * clickedPlayer = NULL;
     int toReturn = 0;
     MTGGameZone* zone = NULL;
@@ -1438,8 +1491,10 @@ void GameObserver::untapPhase()
 
 int GameObserver::receiveEvent(WEvent * e)
 {
+    MemoryPool::Scope poolScope(mPool);
     if (!e) 
     	return 0;
+    stateChanged();
     eventsQueue.push(e);
     if (eventsQueue.size() > 1) 
     	return -1; //resolving events can generate more events
@@ -1553,6 +1608,7 @@ bool GameObserver::load(const string& ss, bool undo, int controlledPlayerIndex
 #endif
                         )
 {
+    MemoryPool::Scope poolScope(mPool);
     bool currentPlayerSet = false;
 	int state = -1;
     string s;
@@ -1825,6 +1881,7 @@ void GameObserver::logAction(const string& s)
 
 bool GameObserver::undo()
 {
+    MemoryPool::Scope poolScope(mPool);
     stringstream stream;
     stream << *this;
     DebugTrace(stream.str());
@@ -1833,6 +1890,7 @@ bool GameObserver::undo()
 
 void GameObserver::Mulligan(Player* player)
 {
+    MemoryPool::Scope poolScope(mPool);
     if(!player) player = currentPlayer;
     logAction(player, "mulligan");
     player->takeMulligan();
@@ -1880,12 +1938,14 @@ Player* GameObserver::createPlayer(const string& playerMode
 #ifdef TESTSUITE
 void GameObserver::loadTestSuitePlayer(int playerId, TestSuiteGame* testSuite)
 {
+    MemoryPool::Scope poolScope(mPool);
     loadPlayer(playerId, new TestSuiteAI(testSuite, playerId));
 }
 #endif //TESTSUITE
 
 void GameObserver::loadPlayer(int playerId, Player* player)
 {
+    MemoryPool::Scope poolScope(mPool);
     //Because we're using a vector instead of an array (why?),
     // we have to prepare the vector in order to be the right size to accomodate the playerId variable
     // see http://code.google.com/p/wagic/issues/detail?id=772
@@ -1904,6 +1964,7 @@ void GameObserver::loadPlayer(int playerId, Player* player)
 
 void GameObserver::loadPlayer(int playerId, PlayerType playerType, int decknb, bool premadeDeck)
 {
+    MemoryPool::Scope poolScope(mPool);
     if (decknb)
     {
         if (playerType == PLAYER_TYPE_HUMAN)
@@ -1956,11 +2017,14 @@ void GameObserver::loadPlayer(int playerId, PlayerType playerType, int decknb, b
 
 #ifdef NETWORK_SUPPORT
 NetworkGameObserver::NetworkGameObserver(JNetwork* pNetwork, WResourceManager* output, JGE* input)
-	: GameObserver(output, input), mpNetworkSession(pNetwork), 	mSynchronized(false)
+	: GameObserver(output, input), mpNetworkSession(pNetwork), 	mSynchronized(false), mForwardAction(true),
+	mSnapshotPending(false), hashesSent(0), snapshotsLoaded(0)
 {
 	mpNetworkSession->registerCommand("loadPlayer", this, loadPlayer, ignoreResponse);
 	mpNetworkSession->registerCommand("synchronize", this, synchronize, checkSynchro);
-	mpNetworkSession->registerCommand("sendAction", this, sendAction, checkSynchro);
+	mpNetworkSession->registerCommand("sendAction", this, sendAction, ignoreResponse);
+	mpNetworkSession->registerCommand("stateHash", this, stateHash, ignoreResponse);
+	mpNetworkSession->registerCommand("snapshot", this, requestSnapshot, loadSnapshot);
 	mpNetworkSession->registerCommand("disconnect", this, disconnect, ignoreResponse);
 }
 
@@ -2013,6 +2077,72 @@ void NetworkGameObserver::loadPlayer(void*pxThis, stringstream& in, stringstream
     }
 }
 
+void NetworkGameObserver::parseCheckpoint(stringstream& in, Checkpoint& checkpoint)
+{
+	checkpoint.actions = 0;
+	checkpoint.hash = 0;
+	in >> checkpoint.actions >> checkpoint.hash;
+}
+
+void NetworkGameObserver::writeCheckpoint(stringstream& out, const Checkpoint& checkpoint)
+{
+	out << checkpoint.actions << " " << checkpoint.hash;
+}
+
+void NetworkGameObserver::addCheckpoint()
+{
+	Checkpoint checkpoint;
+	checkpoint.actions = actionsList.size();
+	checkpoint.hash = getStateHash();
+
+	mLocalHashes.push_back(checkpoint);
+	if(mLocalHashes.size() > HASH_HISTORY)
+		mLocalHashes.pop_front();
+
+	if(mpNetworkSession->isServer())
+	{
+		stringstream out;
+		writeCheckpoint(out, checkpoint);
+		mpNetworkSession->sendCommand("stateHash", out.str());
+		hashesSent++;
+	}
+	else
+	{
+		compareHashes();
+	}
+}
+
+void NetworkGameObserver::compareHashes()
+{
+	// both lists go by increasing number of actions: drop what the other side has no match for
+	while(mLocalHashes.size() && mRemoteHashes.size())
+	{
+		Checkpoint local = mLocalHashes.front();
+		Checkpoint remote = mRemoteHashes.front();
+		if(local.actions < remote.actions)
+		{
+			mLocalHashes.pop_front();
+			continue;
+		}
+		if(remote.actions < local.actions)
+		{
+			mRemoteHashes.pop_front();
+			continue;
+		}
+
+		mLocalHashes.pop_front();
+		mRemoteHashes.pop_front();
+		if(local.hash != remote.hash && !mSnapshotPending)
+		{
+			DebugTrace("game out of sync after " << remote.actions << " actions, requesting a snapshot");
+			mSnapshotPending = true;
+			mLocalHashes.clear();
+			mRemoteHashes.clear();
+			mpNetworkSession->sendCommand("snapshot");
+		}
+	}
+}
+
 void NetworkGameObserver::synchronize()
 {
 	if(!mSynchronized && mpNetworkSession->isServer())
@@ -2021,6 +2151,12 @@ void NetworkGameObserver::synchronize()
 		out << *this;
 		mpNetworkSession->sendCommand("synchronize", out.str());
 		mSynchronized = true;
+
+		Checkpoint checkpoint;
+		checkpoint.actions = actionsList.size();
+		checkpoint.hash = getStateHash();
+		mLocalHashes.clear();
+		mLocalHashes.push_back(checkpoint);
 	}
 }
 
@@ -2029,19 +2165,64 @@ void NetworkGameObserver::synchronize(void*pxThis, stringstream& in, stringstrea
 	NetworkGameObserver* pThis = (NetworkGameObserver*)pxThis;
 	// now, we need to load the game from player 2's perspective
 	pThis->load(in.str(), false, 1);
-	out << *pThis;
+	pThis->mLocalHashes.clear();
+	pThis->mRemoteHashes.clear();
+
+	// the server checks the hash of what we loaded
+	Checkpoint checkpoint;
+	checkpoint.actions = pThis->actionsList.size();
+	checkpoint.hash = pThis->getStateHash();
+	writeCheckpoint(out, checkpoint);
 }
 
 
 void NetworkGameObserver::checkSynchro(void*pxThis, stringstream& in, stringstream&)
 {
 	NetworkGameObserver* pThis = (NetworkGameObserver*)pxThis;
-	
-	GameObserver aGame;
-	aGame.mRules = pThis->mRules;
-	aGame.load(in.str());
+	Checkpoint checkpoint;
+	parseCheckpoint(in, checkpoint);
+
+	// the game may have gone on since, compare with the hash it had when it was sent
+	for(size_t i = 0; i < pThis->mLocalHashes.size(); i++)
+	{
+		if(pThis->mLocalHashes[i].actions == checkpoint.actions && pThis->mLocalHashes[i].hash != checkpoint.hash)
+		{
+			DebugTrace("client loaded a different game, sending it again");
+			pThis->mSynchronized = false;
+		}
+	}
+}
+
+void NetworkGameObserver::stateHash(void*pxThis, stringstream& in, stringstream&)
+{
+	NetworkGameObserver* pThis = (NetworkGameObserver*)pxThis;
+	Checkpoint checkpoint;
+	parseCheckpoint(in, checkpoint);
+
+	// what the server sent before the snapshot does not match the game we are about to load
+	if(pThis->mSnapshotPending)
+		return;
 
-	assert(aGame == *pThis);
+	pThis->mRemoteHashes.push_back(checkpoint);
+	if(pThis->mRemoteHashes.size() > HASH_HISTORY)
+		pThis->mRemoteHashes.pop_front();
+	pThis->compareHashes();
+}
+
+void NetworkGameObserver::requestSnapshot(void*pxThis, stringstream&, stringstream& out)
+{
+	NetworkGameObserver* pThis = (NetworkGameObserver*)pxThis;
+	out << *pThis;
+}
+
+void NetworkGameObserver::loadSnapshot(void*pxThis, stringstream& in, stringstream&)
+{
+	NetworkGameObserver* pThis = (NetworkGameObserver*)pxThis;
+	pThis->load(in.str(), false, 1);
+	pThis->mLocalHashes.clear();
+	pThis->mRemoteHashes.clear();
+	pThis->mSnapshotPending = false;
+	pThis->snapshotsLoaded++;
 }
 
 void NetworkGameObserver::sendAction(void*pxThis, stringstream& in, stringstream&)
@@ -2051,11 +2232,20 @@ void NetworkGameObserver::sendAction(void*pxThis, stringstream& in, stringstream
     pThis->mForwardAction = false;
 	pThis->processAction(in.str());
     pThis->mForwardAction = true;
-	//out << *pThis;
 }
 
 void NetworkGameObserver::logAction(const string& s)
 {
+	// replaying a loaded game: the other side already has these actions
+	if(mLoading)
+	{
+		GameObserver::logAction(s);
+		return;
+	}
+
+	if(actionsList.size() % HASH_INTERVAL == 0)
+		addCheckpoint();
+
 	GameObserver::logAction(s);
 	if(mForwardAction)
 		mpNetworkSession->sendCommand("sendAction", s);
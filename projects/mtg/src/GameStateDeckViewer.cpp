@@ -156,6 +156,28 @@ void GameStateDeckViewer::loadIndexes()
     {
         cardIndex[i] = displayed_deck->getCard(i);
     }
+
+    if (WResourceManager::Instance()->IsThreaded())
+    {
+        // whatever was queued for the previous position is not worth decoding anymore
+        WResourceManager::Instance()->CancelPrefetches(PREFETCH_HIGH);
+
+        // even though we want to draw the cards in a particular z order for layering, we want to prefetch them
+        // in a different order, ie the center card should appear first, then the adjacent ones
+        static const int kPrefetchOrder[7] = { 0, 3, 4, 2, 5, 1, 6 };
+        for (int i = 0; i < 7; i++)
+            WResourceManager::Instance()->PrefetchCard(cardIndex[kPrefetchOrder[i]], PREFETCH_HIGH);
+
+        // then the next and previous pages, closest cards first
+        if (displayed_deck->Size() > 7)
+        {
+            for (int i = 0; i < 7; i++)
+            {
+                WResourceManager::Instance()->PrefetchCard(displayed_deck->getCard(7 + i), PREFETCH_NORMAL);
+                WResourceManager::Instance()->PrefetchCard(displayed_deck->getCard(-1 - i), PREFETCH_NORMAL);
+            }
+        }
+    }
 }
 
 void GameStateDeckViewer::switchDisplay()
@@ -1374,6 +1396,44 @@ void GameStateDeckViewer::renderOnScreenMenu()
             }
             break;
 
+        case 10: // Goldfish games
+        {
+            // Title
+            sprintf(buffer, STATS_TITLE_FORMAT.c_str(), stw->currentPage, _("Goldfish games").c_str());
+            font->DrawString(buffer, 10 + leftTransition, 10);
+
+            stw->simulate(myDeck);
+            sprintf(buffer, _("%i games on the play, %2.2f%% with a mulligan").c_str(), stw->simulatedGames, stw->mulliganProb);
+            font->DrawString(buffer, 20 + leftTransition, 30);
+
+            posY = 50;
+            font->DrawString(_("Turn"), 20 + leftTransition, posY);
+            font->DrawString(_("Spell cast"), 60 + leftTransition, posY);
+            font->DrawString(_("Color screw"), 130 + leftTransition, posY);
+            font->DrawString(_("Mana used"), 200 + leftTransition, posY);
+            posY += 15;
+            for (int i = 0; i < Constants::STATS_FOR_TURNS; i++)
+            {
+                sprintf(buffer, _("%i:").c_str(), i + 1);
+                font->DrawString(buffer, 30 + leftTransition, posY);
+                sprintf(buffer, _("%2.2f%%").c_str(), stw->spellCastByTurn[i]);
+                font->DrawString(buffer, 60 + leftTransition, posY);
+                sprintf(buffer, _("%2.2f%%").c_str(), stw->colorScrewProbInTurn[i]);
+                font->DrawString(buffer, 130 + leftTransition, posY);
+                sprintf(buffer, _("%2.2f%%").c_str(), stw->manaUsedInTurn[i]);
+                font->DrawString(buffer, 200 + leftTransition, posY);
+                posY += 10;
+            }
+
+            posY += 10;
+            font->DrawString(_("Spell cast - At least one spell cast by that turn"), 20 + leftTransition, posY);
+            posY += 10;
+            font->DrawString(_("Color screw - A spell in hand the lands can't pay for only because of its colors"), 20 + leftTransition, posY);
+            posY += 10;
+            font->DrawString(_("Mana used - Lands in play tapped for spells"), 20 + leftTransition, posY);
+            break;
+        }
+
         case 9: // Victory statistics
             // Title
             sprintf(buffer, STATS_TITLE_FORMAT.c_str(), stw->currentPage, _("Victory statistics").c_str());
@@ -1533,19 +1593,6 @@ void GameStateDeckViewer::Render()
         order[2] = 1;
     }
 
-    // even though we want to draw the cards in a particular z order for layering, we want to prefetch them 
-    // in a different order, ie the center card should appear first, then the adjacent ones
-    if (WResourceManager::Instance()->IsThreaded())
-    {
-        WResourceManager::Instance()->RetrieveCard(cardIndex[0]);
-        WResourceManager::Instance()->RetrieveCard(cardIndex[3]);
-        WResourceManager::Instance()->RetrieveCard(cardIndex[4]);
-        WResourceManager::Instance()->RetrieveCard(cardIndex[2]);
-        WResourceManager::Instance()->RetrieveCard(cardIndex[5]);
-        WResourceManager::Instance()->RetrieveCard(cardIndex[1]);
-        WResourceManager::Instance()->RetrieveCard(cardIndex[6]);
-    }
-
     renderCard(6, mRotation);
     renderCard(5, mRotation);
     renderCard(4, mRotation);
@@ -1609,7 +1656,7 @@ int GameStateDeckViewer::loadDeck(int deckid)
     }
     
     stw->currentPage = 0;
-    stw->pageCount = 9;
+    stw->pageCount = 10;
     stw->needUpdate = true;
 
     if (!playerdata) playerdata = NEW PlayerData(MTGCollection());
@@ -13,6 +13,7 @@
 #include "Credits.h"
 #include "Translate.h"
 #include "Rules.h"
+#include "AIProfiler.h"
 #include "ModRules.h"
 
 #ifdef TESTSUITE
@@ -1014,6 +1015,8 @@ void GameStateDuel::Update(float dt)
                 mWorkerThread.back().join();
                 mWorkerThread.pop_back();
             }
+            if (totalTestGames)
+                AI_PROFILE_REPORT("ai/ai_profile.txt");
 #endif //AI_CHANGE_TESTING
 
             menu->Update(dt);
@@ -323,6 +323,8 @@ void GameStateShop::purchaseBooster(int controlId)
     for (int x = 0; x < ddw->Size(); x++)
     {
         MTGCard * c = ddw->getCard(x);
+        // the booster is shown right away, start decoding its cards in display order
+        WResourceManager::Instance()->PrefetchCard(c, PREFETCH_NORMAL);
         for (int copies = 0; copies < ddw->count(c); ++copies)
         {
             MTGCardInstance * ci = NEW MTGCardInstance(c, NULL);
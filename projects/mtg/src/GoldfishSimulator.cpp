@@ -0,0 +1,308 @@
+#include "PrecompiledHeader.h"
+
+#include "GoldfishSimulator.h"
+#include "DeckDataWrapper.h"
+#include "MTGDeck.h"
+#include "Threading.h"
+
+namespace
+{
+    const int kOpeningHand = 7;
+    const int kMaxCards = kOpeningHand + Constants::STATS_FOR_TURNS;
+
+    int colorBit(int color)
+    {
+        return 1 << (color - Constants::MTG_COLOR_GREEN);
+    }
+
+    // xorshift32, one per worker
+    inline unsigned int nextRandom(unsigned int& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    inline int countBits(int mask)
+    {
+        int result = 0;
+        for (; mask; mask &= mask - 1)
+            result++;
+        return result;
+    }
+}
+
+GoldfishSimulator::Results::Results() :
+    games(0), mulligans(0)
+{
+    for (int i = 0; i < Constants::STATS_FOR_TURNS; i++)
+        spellCastBy[i] = colorScrewed[i] = manaUsed[i] = manaAvailable[i] = 0;
+}
+
+void GoldfishSimulator::Results::add(const Results& other)
+{
+    games += other.games;
+    mulligans += other.mulligans;
+    for (int i = 0; i < Constants::STATS_FOR_TURNS; i++)
+    {
+        spellCastBy[i] += other.spellCastBy[i];
+        colorScrewed[i] += other.colorScrewed[i];
+        manaUsed[i] += other.manaUsed[i];
+        manaAvailable[i] += other.manaAvailable[i];
+    }
+}
+
+GoldfishSimulator::GoldfishSimulator(DeckDataWrapper * deck)
+{
+    //Basic lands don't produce their mana through their abilities, see StatsWrapper::updateStats
+    const int colors[] = {Constants::MTG_COLOR_GREEN, Constants::MTG_COLOR_BLUE, Constants::MTG_COLOR_RED, Constants::MTG_COLOR_BLACK, Constants::MTG_COLOR_WHITE};
+    const string lands[] = { "forest", "island", "mountain", "swamp", "plains" };
+
+    for (int ic = 0; ic < deck->Size(true); ic++)
+    {
+        MTGCard * current = deck->getCard(ic, true);
+        ManaCost * cost = current->data->getManaCost();
+
+        Card card;
+        card.land = current->data->isLand();
+        card.producedColors = 0;
+        card.cost = cost->getConvertedCost();
+        card.neededColors = 0;
+        for (int j = 0; j < NB_MANA_COLORS; j++)
+        {
+            card.needs[j] = cost->getCost(Constants::MTG_COLOR_GREEN + j);
+            if (card.needs[j])
+                card.neededColors |= 1 << j;
+        }
+
+        if (card.land)
+        {
+            for (unsigned int i = 0; i < sizeof(colors) / sizeof(colors[0]); ++i)
+            {
+                if (current->data->hasType(lands[i].c_str()))
+                    card.producedColors |= colorBit(colors[i]);
+            }
+
+            vector<string> abilities = split(current->data->getMagicText(), '\n');
+            for (size_t v = 0; v < abilities.size(); v++)
+            {
+                size_t t = abilities[v].find("add");
+                if (t == string::npos)
+                    continue;
+                ManaCost * mc = ManaCost::parseManaCost(abilities[v].substr(t + 3));
+                for (int j = Constants::MTG_COLOR_GREEN; j <= Constants::MTG_COLOR_WHITE; j++)
+                {
+                    if (mc->hasColor(j))
+                        card.producedColors |= colorBit(j);
+                }
+                SAFE_DELETE(mc);
+            }
+        }
+
+        int index = (int) cards.size();
+        cards.push_back(card);
+        for (int copies = deck->count(current); copies > 0; copies--)
+            library.push_back(index);
+    }
+}
+
+void GoldfishSimulator::ThreadProc(void * inParam)
+{
+    Worker * worker = reinterpret_cast<Worker *>(inParam);
+    if (worker)
+        worker->simulator->play(worker->games, worker->seed, worker->results);
+}
+
+void GoldfishSimulator::run(Results& results, int games, unsigned int seed)
+{
+    results = Results();
+    if (!library.size() || games <= 0)
+        return;
+
+    size_t threadCount = 1;
+#if !defined(PSP)
+    threadCount = boost::thread::hardware_concurrency();
+    if (threadCount < 1)
+        threadCount = 1;
+    if (threadCount > MAX_THREADS)
+        threadCount = MAX_THREADS;
+#endif
+
+    vector<Worker> workers(threadCount);
+    for (size_t i = 0; i < threadCount; i++)
+    {
+        workers[i].simulator = this;
+        workers[i].games = games / (int) threadCount + ((int) i < games % (int) threadCount ? 1 : 0);
+        workers[i].seed = (seed + i + 1) * 2654435761U;
+        if (!workers[i].seed)
+            workers[i].seed = 1;
+    }
+
+#if !defined(PSP)
+    // the calling thread plays its share too
+    vector<boost::thread *> threads;
+    for (size_t i = 1; i < threadCount; i++)
+        threads.push_back(new boost::thread(ThreadProc, &workers[i]));
+#endif
+    play(workers[0].games, workers[0].seed, workers[0].results);
+#if !defined(PSP)
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+    }
+#endif
+
+    for (size_t i = 0; i < threadCount; i++)
+        results.add(workers[i].results);
+}
+
+bool GoldfishSimulator::canPay(const int supply[COLOR_MASKS], int lands, const int needs[NB_MANA_COLORS], int neededColors, int cost)
+{
+    if (cost > lands)
+        return false;
+    // Hall's condition: every set of colors needs at least as many lands able to produce one of them
+    for (int colorSet = neededColors; colorSet; colorSet = (colorSet - 1) & neededColors)
+    {
+        int needed = 0;
+        for (int j = 0; j < NB_MANA_COLORS; j++)
+        {
+            if (colorSet & (1 << j))
+                needed += needs[j];
+        }
+        if (needed > supply[colorSet])
+            return false;
+    }
+    return true;
+}
+
+void GoldfishSimulator::play(int games, unsigned int seed, Results& results) const
+{
+    vector<int> deck(library);
+    int nbCards = (int) deck.size();
+    unsigned int random = seed;
+
+    for (int game = 0; game < games; game++)
+    {
+        // mulligan hands without 2 lands and 2 spells, down to 5 cards
+        int handSize = kOpeningHand;
+        while (true)
+        {
+            int drawn = min(nbCards, handSize + Constants::STATS_FOR_TURNS - 1);
+            for (int i = 0; i < drawn; i++)
+                swap(deck[i], deck[i + nextRandom(random) % (nbCards - i)]);
+
+            int lands = 0;
+            for (int i = 0; i < handSize && i < nbCards; i++)
+            {
+                if (cards[deck[i]].land)
+                    lands++;
+            }
+            if (handSize <= 5 || (lands >= 2 && handSize - lands >= 2))
+                break;
+            handSize--;
+        }
+        if (handSize < kOpeningHand)
+            results.mulligans++;
+        results.games++;
+
+        int hand[kMaxCards];
+        int handCount = 0;
+        int next = 0;
+        while (next < handSize && next < nbCards)
+            hand[handCount++] = deck[next++];
+
+        int supply[COLOR_MASKS] = {0};
+        int lands = 0;
+        int colorsInPlay = 0;
+        bool castSomething = false;
+
+        for (int turn = 0; turn < Constants::STATS_FOR_TURNS; turn++)
+        {
+            // on the play: no draw on the first turn
+            if (turn && next < nbCards)
+                hand[handCount++] = deck[next++];
+
+            // land drop, the one that brings the most colors the hand is missing
+            int missing = 0;
+            for (int h = 0; h < handCount; h++)
+            {
+                if (!cards[hand[h]].land)
+                    missing |= cards[hand[h]].neededColors;
+            }
+            missing &= ~colorsInPlay;
+            int bestLand = -1;
+            int bestScore = -1;
+            for (int h = 0; h < handCount; h++)
+            {
+                const Card& card = cards[hand[h]];
+                if (!card.land)
+                    continue;
+                int score = countBits(card.producedColors & missing) * 2 + (card.producedColors ? 1 : 0);
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestLand = h;
+                }
+            }
+            if (bestLand >= 0)
+            {
+                int produced = cards[hand[bestLand]].producedColors;
+                hand[bestLand] = hand[--handCount];
+                lands++;
+                colorsInPlay |= produced;
+                for (int colorSet = 1; colorSet < COLOR_MASKS; colorSet++)
+                {
+                    if (colorSet & produced)
+                        supply[colorSet]++;
+                }
+            }
+
+            // cast what we can, most expensive first
+            int needs[NB_MANA_COLORS] = {0};
+            int neededColors = 0;
+            int spent = 0;
+            while (true)
+            {
+                int best = -1;
+                for (int h = 0; h < handCount; h++)
+                {
+                    const Card& card = cards[hand[h]];
+                    if (card.land || (best >= 0 && card.cost <= cards[hand[best]].cost))
+                        continue;
+                    int together[NB_MANA_COLORS];
+                    for (int j = 0; j < NB_MANA_COLORS; j++)
+                        together[j] = needs[j] + card.needs[j];
+                    if (canPay(supply, lands, together, neededColors | card.neededColors, spent + card.cost))
+                        best = h;
+                }
+                if (best < 0)
+                    break;
+                const Card& cast = cards[hand[best]];
+                for (int j = 0; j < NB_MANA_COLORS; j++)
+                    needs[j] += cast.needs[j];
+                neededColors |= cast.neededColors;
+                spent += cast.cost;
+                hand[best] = hand[--handCount];
+                castSomething = true;
+            }
+
+            if (castSomething)
+                results.spellCastBy[turn]++;
+            results.manaUsed[turn] += spent;
+            results.manaAvailable[turn] += lands;
+
+            // color screw: a spell left that enough lands could cast, if they were of the right colors
+            for (int h = 0; h < handCount; h++)
+            {
+                const Card& card = cards[hand[h]];
+                if (!card.land && card.cost <= lands && !canPay(supply, lands, card.needs, card.neededColors, card.cost))
+                {
+                    results.colorScrewed[turn]++;
+                    break;
+                }
+            }
+        }
+    }
+}
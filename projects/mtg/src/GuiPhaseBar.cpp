@@ -130,11 +130,18 @@ void GuiPhaseBar::Render()
 
     //print phase name
     WFont * font = WResourceManager::Instance()->GetWFont(Fonts::MAIN_FONT);
-    string currentP = _("your turn");
+    static const TranslationKey kYourTurn("your turn");
+    static const TranslationKey kOpponentTurn("opponent's turn");
+    static const TranslationKey kSeparator(" - ");
+    static const TranslationKey kOpponentPlays("opponent plays");
+    static const TranslationKey kYouPlay("you play");
+    static const TranslationKey kPhaseFormat("(%s%s) %s");
+
+    const string * currentP = &_(kYourTurn);
     string interrupt = "";
 	if (observer->currentPlayer == mpDuelLayers->getRenderedPlayerOpponent())
     {
-        currentP = _("opponent's turn");
+        currentP = &_(kOpponentTurn);
     }
     font->SetColor(ARGB(255, 255, 255, 255));
     if (observer->currentlyActing() && observer->currentlyActing()->isAI())
@@ -145,19 +152,18 @@ void GuiPhaseBar::Render()
     {
 		if (observer->currentPlayer == mpDuelLayers->getRenderedPlayer())
         {
-            interrupt = _(" - ") + _("opponent plays");
+            interrupt = _(kSeparator) + _(kOpponentPlays);
         }
         else
         {
-            interrupt = _(" - ") + _("you play");
+            interrupt = _(kSeparator) + _(kYouPlay);
         }
     }
 
     char buf[200];
     //running this string through translate returns gibberish even though we defined the variables in the lang.txt
-    string phaseNameToTranslate = observer->phaseRing->phaseName(phase->id);
-    phaseNameToTranslate = _(phaseNameToTranslate);
-    sprintf(buf, _("(%s%s) %s").c_str(), currentP.c_str(), interrupt.c_str(),phaseNameToTranslate.c_str());
+    const string& phaseNameToTranslate = observer->phaseRing->phaseName(phase->id);
+    sprintf(buf, _(kPhaseFormat).c_str(), currentP->c_str(), interrupt.c_str(), _(phaseNameToTranslate).c_str());
     font->DrawString(buf, SCREEN_WIDTH - 5, 2, JGETEXT_RIGHT);
 }
 
@@ -3588,7 +3588,7 @@ int AbilityFactory::getAbilities(vector<MTGAbility *> * v, Spell * spell, MTGCar
 
             ManaCost * copyCost = card->model->data->getManaCost();
             card->getManaCost()->copy(copyCost);
-            magicText = card->model->data->magicText;
+            magicText = card->model->data->getMagicText();
             string faceupC= card->magicTexts["faceup"];
             magicText.append("\n");
             magicText.append(faceupC);
@@ -3596,7 +3596,7 @@ int AbilityFactory::getAbilities(vector<MTGAbility *> * v, Spell * spell, MTGCar
         }
         else if(card && card->hasType(Subtypes::TYPE_EQUIPMENT) && card->target)
         {
-            magicText = card->model->data->magicText;
+            magicText = card->model->data->getMagicText();
             string equipText = card->magicTexts["skill"];
             magicText.append("\n");
             magicText.append(equipText);
@@ -3611,7 +3611,7 @@ int AbilityFactory::getAbilities(vector<MTGAbility *> * v, Spell * spell, MTGCar
         MTGCard * c = MTGCollection()->getCardById(card->alias);
         if (!c)
             return 0;
-        magicText = c->data->magicText;
+        magicText = c->data->getMagicText();
     }
     string line;
     int size = magicText.size();
@@ -5045,19 +5045,20 @@ bool ListMaintainerAbility::canTarget(MTGGameZone * zone)
 void ListMaintainerAbility::updateTargets()
 {
     //remove invalid ones
-    map<MTGCardInstance *, bool> temp;
+    vector<MTGCardInstance *> temp;
     for (map<MTGCardInstance *, bool>::iterator it = cards.begin(); it != cards.end(); ++it)
     {
         MTGCardInstance * card = (*it).first;
         if (!canBeInList(card) || card->mPropertiesChangedSinceLastUpdate)
         {
-            temp[card] = true;
+            temp.push_back(card);
         }
     }
 
-    for (map<MTGCardInstance *, bool>::iterator it = temp.begin(); it != temp.end(); ++it)
+    bool changed = temp.size() > 0;
+    for (size_t i = 0; i < temp.size(); ++i)
     {
-        MTGCardInstance * card = (*it).first;
+        MTGCardInstance * card = temp[i];
         cards.erase(card);
         removed(card);
     }
@@ -5075,27 +5076,23 @@ void ListMaintainerAbility::updateTargets()
                 for (int j = 0; j < zone->nb_cards; j++)
                 {
                      MTGCardInstance * card = zone->cards[j];
-                    if (canBeInList(card))
+                    if (cards.find(card) == cards.end() && canBeInList(card))
                     {
-                        if (cards.find(card) == cards.end())
-                        {
-                            temp[card] = true;
-                        }
+                        temp.push_back(card);
                     }
                 }
             }
         }
     }
 
-    for (map<MTGCardInstance *, bool>::iterator it = temp.begin(); it != temp.end(); ++it)
+    changed = changed || temp.size() > 0;
+    for (size_t i = 0; i < temp.size(); ++i)
     {
-        MTGCardInstance * card = (*it).first;
+        MTGCardInstance * card = temp[i];
         cards[card] = true;
         added(card);
     }
 
-    temp.clear();
-
     for (int i = 0; i < 2; ++i)
     {
         Player * p = game->players[i];
@@ -5103,14 +5100,19 @@ void ListMaintainerAbility::updateTargets()
         {
             players[p] = true;
             added(p);
+            changed = true;
         }
         else if (players[p] && !canBeInList(p))
         {
             players[p] = false;
             removed(p);
+            changed = true;
         }
     }
 
+    //what we just did may change what other effects see
+    if (changed)
+        game->stateChanged();
 }
 
 void ListMaintainerAbility::checkTargets()
@@ -5165,9 +5167,19 @@ void ListMaintainerAbility::checkTargets()
     }
 }
 
+bool ListMaintainerAbility::gameChanged()
+{
+    if (listUpToDate && listVersion == game->getStateVersion())
+        return false;
+    listVersion = game->getStateVersion();
+    listUpToDate = true;
+    return true;
+}
+
 void ListMaintainerAbility::Update(float)
 {
-    updateTargets();
+    if (gameChanged())
+        updateTargets();
 }
 
 //Destroy the spell -> remove all targets
@@ -5175,6 +5187,8 @@ int ListMaintainerAbility::destroy()
 {
     map<MTGCardInstance *, bool>::iterator it = cards.begin();
 
+    if (it != cards.end())
+        game->stateChanged();
     while (it != cards.end())
     {
         MTGCardInstance * card = (*it).first;
@@ -10,6 +10,7 @@
 #include "MTGCardInstance.h"
 #include "CardDescriptor.h"
 #include "Counters.h"
+#include "StateHash.h"
 #include "Subtypes.h"
 
 using namespace std;
@@ -51,9 +52,29 @@ MTGCardInstance::MTGCardInstance(MTGCard * card, MTGPlayerCards * arg_belongs_to
     castMethod = Constants::NOT_CAST;
 }
 
+//A snapshot only records the state of the card for the abilities that look back at it (see storedCard):
+//it is never displayed, never put in a zone that gives it abilities, and never changes.
+//So the display text, the zone texts and the abilities of the card are put aside while copying,
+//instead of being copied and never read.
   MTGCardInstance * MTGCardInstance::createSnapShot()
     {
+        string textKept;
+        vector<string> formattedTextKept;
+        map<string, string> magicTextsKept;
+        vector<MTGAbility *> cardsAbilitiesKept;
+        textKept.swap(text);
+        formattedTextKept.swap(formattedText);
+        magicTextsKept.swap(magicTexts);
+        cardsAbilitiesKept.swap(cardsAbilities);
+
         MTGCardInstance * snapShot = NEW MTGCardInstance(*this);
+
+        text.swap(textKept);
+        formattedText.swap(formattedTextKept);
+        magicTexts.swap(magicTextsKept);
+        cardsAbilities.swap(cardsAbilitiesKept);
+
+        snapShot->unshareRestrictions();
         snapShot->previous = NULL;
         snapShot->counters = NEW Counters(snapShot);
         controller()->game->garbage->addCard(snapShot);
@@ -82,7 +103,7 @@ void MTGCardInstance::copy(MTGCardInstance * card)
     toughness = data->toughness;
     life = toughness;
     lifeOrig = life;
-    magicText = data->magicText;
+    magicText = data->getMagicText();
     spellTargetType = data->spellTargetType;
     alias = data->alias;
 
@@ -188,6 +209,8 @@ void MTGCardInstance::initMTGCI()
     type_as_damageable = DAMAGEABLE_MTGCARDINSTANCE;
     banding = NULL;
     owner = NULL;
+    mStateHash = 0;
+    hashedZone = NULL;
     counters = NEW Counters(this);
     previousZone = NULL;
     previous = NULL;
@@ -414,6 +437,7 @@ void MTGCardInstance::tap()
     if (tapped)
         return;
     tapped = 1;
+    updateStateHash();
     WEvent * e = NEW WEventCardTap(this, 0, 1);
     observer->receiveEvent(e);
 }
@@ -423,10 +447,24 @@ void MTGCardInstance::untap()
     if (!tapped)
         return;
     tapped = 0;
+    updateStateHash();
     WEvent * e = NEW WEventCardTap(this, 1, 0);
     observer->receiveEvent(e);
 }
 
+void MTGCardInstance::updateStateHash()
+{
+    uint64_t hash = StateHash::key(StateHash::CARD, getId());
+    if (tapped)
+        hash ^= StateHash::key(StateHash::TAPPED, getId());
+    if (counters)
+        hash ^= counters->stateHash;
+
+    if (hashedZone)
+        hashedZone->stateHash ^= mStateHash ^ hash;
+    mStateHash = hash;
+}
+
 void MTGCardInstance::setUntapping()
 {
     untapping = 1;
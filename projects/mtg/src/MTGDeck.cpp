@@ -12,6 +12,7 @@
 #include "DeckManager.h"
 #include <iomanip>
 #include "AbilityParser.h"
+#include "AIHints.h"
 
 #if defined (WIN32) || defined (LINUX)
 #include <time.h>
@@ -384,6 +385,11 @@ int MTGAllCards::load(const char * config_file, const char * set_name, int)
     if (!JFileSystem::GetInstance()->openForRead(file, config_file))
         return total_cards;
 
+    const int fileIndex = (int) detailsFiles.size();
+    detailsFiles.push_back(config_file);
+    unsigned int cardOffset = 0;
+    bool detailsLeft = false;
+
     string s;
 
     while (getline(file,s))
@@ -414,6 +420,8 @@ int MTGAllCards::load(const char * config_file, const char * set_name, int)
                 else
                 {
                     conf_read_mode = ('m' == s[1]) ? MTGAllCards::READ_METADATA : MTGAllCards::READ_CARD; // M for metadata.
+                    cardOffset = (unsigned int) file.tellg();
+                    detailsLeft = false;
                 }
             }
             else
@@ -442,6 +450,11 @@ int MTGAllCards::load(const char * config_file, const char * set_name, int)
             {
                 conf_read_mode = MTGAllCards::READ_ANYTHING;
                 if (tempPrimitive) tempPrimitive = addPrimitive(tempPrimitive, tempCard);
+                if (tempPrimitive && detailsLeft)
+                {
+                    tempPrimitive->detailsFile = fileIndex;
+                    tempPrimitive->detailsOffset = cardOffset;
+                }
                 if (tempCard)
                 {
                     if (tempPrimitive) tempCard->setPrimitive(tempPrimitive);
@@ -450,6 +463,12 @@ int MTGAllCards::load(const char * config_file, const char * set_name, int)
                 tempCard = NULL;
                 tempPrimitive = NULL;
             }
+            else if (isDetailsLine(s))
+            {
+                //Left in the file, see loadDetails
+                if (!tempPrimitive) tempPrimitive = NEW CardPrimitive();
+                detailsLeft = true;
+            }
             else
             {
                 if (!processConfLine(s, tempCard, tempPrimitive))
@@ -462,6 +481,99 @@ int MTGAllCards::load(const char * config_file, const char * set_name, int)
     return total_cards;
 }
 
+bool MTGAllCards::isDetailsLine(const string& s)
+{
+    //auto, autohand, autograveyard..., text and target
+    return !s.compare(0, 4, "auto") || !s.compare(0, 5, "text=") || !s.compare(0, 7, "target=");
+}
+
+bool MTGAllCards::detailsBefore(CardPrimitive * a, CardPrimitive * b)
+{
+    if (a->detailsFile != b->detailsFile)
+        return a->detailsFile < b->detailsFile;
+    return a->detailsOffset < b->detailsOffset;
+}
+
+void MTGAllCards::loadDetails(CardPrimitive * primitive)
+{
+    loadDetails(vector<CardPrimitive *>(1, primitive));
+}
+
+void MTGAllCards::loadDetails(const vector<CardPrimitive *>& primitives)
+{
+    boost::mutex::scoped_lock lock(mDetailsMutex);
+    readDetails(primitives, NULL);
+}
+
+void MTGAllCards::visitDetails(const vector<CardPrimitive *>& primitives, DetailsVisitor& visitor)
+{
+    boost::mutex::scoped_lock lock(mDetailsMutex);
+    readDetails(primitives, &visitor);
+}
+
+//Reads the details of the primitives into them, or into a copy given to the visitor. mDetailsMutex is held.
+void MTGAllCards::readDetails(vector<CardPrimitive *> primitives, DetailsVisitor * visitor)
+{
+    std::sort(primitives.begin(), primitives.end(), detailsBefore);
+
+    //processConfLine keeps what it parses in the parser state, which is not ours
+    MTGCard * cardKept = tempCard;
+    CardPrimitive * primitiveKept = tempPrimitive;
+
+    izfstream file;
+    int openFile = -1;
+    for (size_t i = 0; i < primitives.size(); i++)
+    {
+        CardPrimitive * primitive = primitives[i];
+        if (primitive->detailsFile < 0)
+        {
+            if (visitor) visitor->visit(primitive, primitive);
+            continue;
+        }
+
+        if (primitive->detailsFile != openFile)
+        {
+            if (openFile >= 0) file.close();
+            openFile = primitive->detailsFile;
+            if (!JFileSystem::GetInstance()->openForRead(file, detailsFiles[openFile]))
+                DebugTrace("MTGDECK: cannot read card details from " << detailsFiles[openFile]);
+        }
+
+        CardPrimitive details;
+        CardPrimitive * into = primitive;
+        if (visitor)
+        {
+            details.text = primitive->text;
+            details.formattedText = primitive->formattedText;
+            into = &details;
+        }
+
+        file.clear();
+        file.seekg(primitive->detailsOffset);
+        string s;
+        while (getline(file, s))
+        {
+            if (s.size() && s[s.size() - 1] == '\r')
+                s.erase(s.size() - 1); //Handle DOS files
+            if (!s.size()) continue;
+            if (s[0] == '[') break;
+            if (!isDetailsLine(s)) continue;
+            //A translated text was set by addPrimitive
+            if (!s.compare(0, 5, "text=") && (into->text.size() || into->formattedText.size())) continue;
+            processConfLine(s, NULL, into);
+        }
+
+        if (visitor)
+            visitor->visit(primitive, &details);
+        else
+            primitive->detailsFile = -1;
+    }
+    if (openFile >= 0) file.close();
+
+    tempCard = cardKept;
+    tempPrimitive = primitiveKept;
+}
+
 MTGAllCards* MTGAllCards::instance = NULL;
 
 MTGAllCards::MTGAllCards()
@@ -495,6 +607,7 @@ void MTGAllCards::unloadAll()
         delete instance;
         instance = NULL;
     }
+    MTGDeckList::clearCache();
 }
 
 int MTGAllCards::randomCardId()
@@ -760,96 +873,161 @@ int MTGDeck::totalPrice()
     return total;
 }
 
-MTGDeck::MTGDeck(const char * config_file, MTGAllCards * _allcards, int meta_only,int difficultyRating)
+map<string, MTGDeckList::CacheEntry> MTGDeckList::sCache;
+map<string, MTGDeckList::CacheEntry> MTGDeckList::sMetaCache;
+boost::mutex MTGDeckList::sCacheMutex;
+
+MTGDeckList * MTGDeckList::parse(const string& contents, MTGAllCards * database, bool metaOnly)
 {
-    total_cards = 0;
-    database = _allcards;
-    filename = config_file;
-    size_t slash = filename.find_last_of("/");
-    size_t dot = filename.find(".");
-    meta_name = filename.substr(slash + 1, dot - slash - 1);
-    meta_id = atoi(meta_name.substr(4).c_str());
-    std::string contents;
-    if (JFileSystem::GetInstance()->readIntoString(config_file, contents))
+    MTGDeckList * list = NEW MTGDeckList();
+    std::stringstream stream(contents);
+    std::string s;
+    while (std::getline(stream, s))
     {
-        std::stringstream stream(contents);
-        std::string s;
-        while (std::getline(stream, s))
+        if (!s.size()) continue;
+        if (s[s.size() - 1] == '\r') s.erase(s.size() - 1); //Handle DOS files
+        if (!s.size()) continue;
+        if (s[0] == '#')
         {
-            if (!s.size()) continue;
-            if (s[s.size() - 1] == '\r') s.erase(s.size() - 1); //Handle DOS files
-            if (!s.size()) continue;
-            if (s[0] == '#')
+            size_t found = s.find("NAME:");
+            if (found != string::npos)
             {
-                size_t found = s.find("NAME:");
-                if (found != string::npos)
-                {
-                    meta_name = s.substr(found + 5);
-                    continue;
-                }
-                found = s.find("DESC:");
-                if (found != string::npos)
-                {
-                    if (meta_desc.size()) meta_desc.append("\n");
-                    meta_desc.append(s.substr(found + 5));
-                    continue;
-                }
-                found = s.find("HINT:");
-                if (found != string::npos)
-                {
-                    meta_AIHints.push_back(s.substr(found + 5));
-                    continue;
-                }
-                found = s.find("UNLOCK:");
-                if (found != string::npos)
-                {
-                    meta_unlockRequirements = s.substr(found + 7);
-                    continue;
-                }
+                list->name = s.substr(found + 5);
                 continue;
             }
-            if (meta_only) break;
-            int numberOfCopies = 1;
-            size_t found = s.find(" *");
+            found = s.find("DESC:");
             if (found != string::npos)
             {
-                numberOfCopies = atoi(s.substr(found + 2).c_str());
-                s = s.substr(0, found);
-            }
-            size_t diff = s.find("toggledifficulty:");
-            if(diff != string::npos)
-            {
-                string cards = s.substr(diff + 17);
-                size_t separator = cards.find("|");
-                string cardeasy = cards.substr(0,separator);
-                string cardhard = cards.substr(separator + 1);
-                if(difficultyRating == HARD)
-                {
-                    s = cardhard;
-                }
-                else
-                {
-                    s = cardeasy;
-                }
+                if (list->desc.size()) list->desc.append("\n");
+                list->desc.append(s.substr(found + 5));
+                continue;
             }
-            MTGCard * card = database->getCardByName(s);
-            if (card)
+            found = s.find("HINT:");
+            if (found != string::npos)
             {
-                for (int i = 0; i < numberOfCopies; i++)
-                {
-                    add(card);
-                }
+                list->hintLines.push_back(s.substr(found + 5));
+                if (!metaOnly)
+                    list->hints.push_back(boost::shared_ptr<AIHint>(NEW AIHint(list->hintLines.back())));
+                continue;
             }
-            else
+            found = s.find("UNLOCK:");
+            if (found != string::npos)
             {
-                DebugTrace("could not find Card matching name: " << s);
+                list->unlockRequirements = s.substr(found + 7);
+                continue;
             }
+            continue;
+        }
+        if (metaOnly) break;
+        Line line;
+        line.copies = 1;
+        size_t found = s.find(" *");
+        if (found != string::npos)
+        {
+            line.copies = atoi(s.substr(found + 2).c_str());
+            s = s.substr(0, found);
         }
+        string hard = s;
+        size_t diff = s.find("toggledifficulty:");
+        if(diff != string::npos)
+        {
+            string cards = s.substr(diff + 17);
+            size_t separator = cards.find("|");
+            s = cards.substr(0,separator);
+            hard = cards.substr(separator + 1);
+        }
+        MTGCard * card = database->getCardByName(s);
+        MTGCard * hardCard = (hard == s) ? card : database->getCardByName(hard);
+        if (!card)
+            DebugTrace("could not find Card matching name: " << s);
+        if (!hardCard && hard != s)
+            DebugTrace("could not find Card matching name: " << hard);
+        line.cardId = card ? card->getId() : 0;
+        line.hardCardId = hardCard ? hardCard->getId() : 0;
+        if (line.copies > 0 && (line.cardId || line.hardCardId))
+            list->lines.push_back(line);
     }
-    else
+    return list;
+}
+
+MTGDeckList::Ptr MTGDeckList::get(const string& filename, MTGAllCards * database, bool metaOnly)
+{
+    time_t lastModified = JFileSystem::GetInstance()->GetLastModified(filename);
+
+    boost::mutex::scoped_lock lock(sCacheMutex);
+    map<string, CacheEntry>& cache = metaOnly ? sMetaCache : sCache;
+    map<string, CacheEntry>::iterator it = cache.find(filename);
+    if (it != cache.end() && it->second.lastModified == lastModified && it->second.database == database)
+        return it->second.list;
+
+    std::string contents;
+    if (!JFileSystem::GetInstance()->readIntoString(filename, contents))
+    {
+        if (it != cache.end())
+            cache.erase(it);
+        return Ptr();
+    }
+
+    CacheEntry entry;
+    entry.lastModified = lastModified;
+    entry.database = database;
+    entry.list = Ptr(parse(contents, database, metaOnly));
+    cache[filename] = entry;
+    return entry.list;
+}
+
+void MTGDeckList::forget(const string& filename)
+{
+    boost::mutex::scoped_lock lock(sCacheMutex);
+    sCache.erase(filename);
+    sMetaCache.erase(filename);
+}
+
+void MTGDeckList::clearCache()
+{
+    boost::mutex::scoped_lock lock(sCacheMutex);
+    sCache.clear();
+    sMetaCache.clear();
+}
+
+MTGDeck::MTGDeck(const char * config_file, MTGAllCards * _allcards, int meta_only,int difficultyRating)
+{
+    total_cards = 0;
+    database = _allcards;
+    filename = config_file;
+    size_t slash = filename.find_last_of("/");
+    size_t dot = filename.find(".");
+    meta_name = filename.substr(slash + 1, dot - slash - 1);
+    meta_id = atoi(meta_name.substr(4).c_str());
+
+    mList = MTGDeckList::get(filename, database, meta_only != 0);
+    if (!mList)
     {
         DebugTrace("FATAL:MTGDeck.cpp:MTGDeck - can't load deck file");
+        return;
     }
+
+    if (mList->name.size())
+        meta_name = mList->name;
+    meta_desc = mList->desc;
+    meta_AIHints = mList->hintLines;
+    meta_unlockRequirements = mList->unlockRequirements;
+
+    for (size_t i = 0; i < mList->lines.size(); ++i)
+    {
+        const MTGDeckList::Line& line = mList->lines[i];
+        int cardId = (difficultyRating == HARD) ? line.hardCardId : line.cardId;
+        if (!cardId)
+            continue;
+        cards[cardId] += line.copies;
+        total_cards += line.copies;
+    }
+}
+
+const vector<boost::shared_ptr<AIHint> >& MTGDeck::getAIHints()
+{
+    static const vector<boost::shared_ptr<AIHint> > noHints;
+    return mList ? mList->hints : noHints;
 }
 
 int MTGDeck::totalCards()
@@ -888,8 +1066,8 @@ int MTGDeck::addRandomCards(int howmany, int * setIds, int nbSets, int rarity, c
     int collectionTotal = database->totalCards();
     if (!collectionTotal) return 0;
 
-    char subtype[4096];
-    if (_subtype) sprintf(subtype, "%s", _subtype);
+    //Looked up once, rather than for each card of the collection
+    int subtypeId = _subtype ? MTGAllCards::findType(_subtype) : -1;
 
     vector<int> subcollection;
     int subtotal = 0;
@@ -899,7 +1077,7 @@ int MTGDeck::addRandomCards(int howmany, int * setIds, int nbSets, int rarity, c
         int r = card->getRarity();
         if (r != Constants::RARITY_T && (rarity == -1 || r == rarity) && // remove tokens
             card->setId != MTGSets::INTERNAL_SET && //remove cards that are defined in primitives. Those are workarounds (usually tokens) and should only be used internally
-            (!_subtype || card->data->hasSubtype(subtype)))
+            (!_subtype || card->data->hasSubtype(subtypeId)))
         {
             int ok = 0;
 
@@ -1098,6 +1276,7 @@ int MTGDeck::save(const string& destFileName, bool useExpandedDescriptions, cons
         }
         file.close();
         JFileSystem::GetInstance()->Rename(tmp, destFileName);
+        MTGDeckList::forget(destFileName);
     }
     return 1;
 }
@@ -51,6 +51,17 @@ void MTGPlayerCards::initDeck(MTGDeck * deck)
 {
     resetLibrary();
     map<int, int>::iterator it;
+
+    //Read the details of the whole deck at once, rather than card by card
+    vector<CardPrimitive *> primitives;
+    for (it = deck->cards.begin(); it != deck->cards.end(); it++)
+    {
+        MTGCard * card = deck->getCardById(it->first);
+        if (card && card->data)
+            primitives.push_back(card->data);
+    }
+    MTGCollection()->loadDetails(primitives);
+
     for (it = deck->cards.begin(); it != deck->cards.end(); it++)
     {
         MTGCard * card = deck->getCardById(it->first);
@@ -232,16 +243,22 @@ void MTGPlayerCards::drawFromLibrary()
     // so prefetch it.
 
     // if we're not in text mode, always get the thumb
-    if (library->owner->getObserver()->getCardSelector()->GetDrawMode() != DrawMode::kText
-            && library->owner->getObserver()->getResourceManager())
+    WResourceManager * resources = library->owner->getObserver()->getResourceManager();
+    if (library->owner->getObserver()->getCardSelector()->GetDrawMode() != DrawMode::kText && resources)
     {
         DebugTrace("Prefetching AI card going into play: " << toMove->getImageName());
-        library->owner->getObserver()->getResourceManager()->RetrieveCard(toMove, RETRIEVE_THUMB);
+        resources->PrefetchCard(toMove, PREFETCH_HIGH, RETRIEVE_THUMB);
 
         // also cache the large image if we're using kNormal mode
         if (library->owner->getObserver()->getCardSelector()->GetDrawMode() == DrawMode::kNormal)
         {
-            library->owner->getObserver()->getResourceManager()->RetrieveCard(toMove);
+            resources->PrefetchCard(toMove, PREFETCH_HIGH);
+        }
+
+        // and speculatively, the card we'll draw next
+        if (!library->owner->isAI() && library->nb_cards > 1)
+        {
+            resources->PrefetchCard(library->cards[library->nb_cards - 2], PREFETCH_LOW, RETRIEVE_THUMB);
         }
     }
 
@@ -423,7 +440,7 @@ int MTGPlayerCards::isInZone(MTGCardInstance * card,MTGGameZone * zone)
 //--------------------------------------
 
 MTGGameZone::MTGGameZone() :
-    nb_cards(0), lastCardDrawn(NULL), needShuffle(false)
+    nb_cards(0), stateHash(0), lastCardDrawn(NULL), needShuffle(false)
 {
 }
 
@@ -471,6 +488,11 @@ MTGCardInstance * MTGGameZone::removeCard(MTGCardInstance * card, int createCopy
         if (cards[i] == card)
         {
             card->currentZone = NULL;
+            if (card->hashedZone == this)
+            {
+                stateHash ^= card->getStateHash();
+                card->hashedZone = NULL;
+            }
             nb_cards--;
             cards.erase(cards.begin() + i);
             MTGCardInstance * copy = card;
@@ -767,6 +789,10 @@ void MTGGameZone::addCard(MTGCardInstance * card)
     cardsMap[card] = 1;
     card->lastController = this->owner;
     card->currentZone = this;
+    card->hashedZone = NULL;
+    card->updateStateHash();
+    stateHash ^= card->getStateHash();
+    card->hashedZone = this;
 
 }
 
@@ -1135,6 +1161,7 @@ bool MTGGameZone::parseLine(const string& ss)
     cards.clear();
     cardsMap.clear();
     nb_cards = 0;
+    stateHash = 0;
 
     while(s.size())
     {
@@ -13,51 +13,159 @@
 
 MTGPack MTGPacks::defaultBooster;
 
-int MTGPackEntryRandom::addCard(WSrcCards *pool, MTGDeck *to)
+bool MTGPackEntryRandom::getCards(WSrcCards *pool, vector<MTGCard *>& cards)
 {
-    int fails = 0;
     if (!pool)
-        return 1;
+        return false;
     WCFilterFactory * ff = WCFilterFactory::GetInstance();
     WCardFilter * oldf = pool->unhookFilters();
     pool->addFilter(ff->Construct(filter));
-    fails = pool->addRandomCards(to, copies);
+    for (int t = 0; t < pool->Size(); t++)
+        cards.push_back(pool->getCard(t));
     pool->clearFilters();
     pool->addFilter(oldf);
-    return fails;
+    return cards.size() > 0;
 }
-int MTGPackEntrySpecific::addCard(WSrcCards *, MTGDeck *to)
+bool MTGPackEntrySpecific::getCards(WSrcCards *, vector<MTGCard *>& cards)
 {
 	if (!card)
-        return copies;
-    for (int i = 0; i < copies; i++)
-        to->add(card);
-    return 0;
+        return false;
+    cards.push_back(card);
+    return true;
 }
 
-int MTGPackSlot::add(WSrcCards * ocean, MTGDeck *to, int carryover)
+//MTGPackGenerator
+MTGPackGenerator::MTGPackGenerator(MTGPack * pack, unsigned int seed)
 {
-    if (!entries.size())
-        return copies;
-    int fails = 0;
-    int amt = copies + carryover;
-    WSrcCards * myPool = NULL;
-    if (pool.size())
-        myPool = MTGPack::getPool(pool);
-    if (!myPool)
-        myPool = ocean;
+    setSeed(seed);
+    WSrcCards * ocean = MTGPack::getPool(pack->pool);
+    bValid = (ocean != NULL);
+    if (!bValid)
+        return;
 
-    for (int i = 0; i < amt; i++)
+    slots.resize(pack->slotss.size());
+    for (size_t i = 0; i < pack->slotss.size(); i++)
     {
-        std::random_shuffle(entries.begin(), entries.end());
-        size_t pos = 0;
-        while (pos < entries.size() && entries[pos]->addCard(myPool, to))
-            pos++;
-        if (pos == entries.size())
-            fails++;
-    }
-    if (myPool != ocean)
+        MTGPackSlot * source = pack->slotss[i];
+        WSrcCards * myPool = NULL;
+        if (source->pool.size())
+            myPool = MTGPack::getPool(source->pool);
+        compile(slots[i], source, myPool ? myPool : ocean);
         SAFE_DELETE(myPool);
+    }
+    SAFE_DELETE(ocean);
+}
+
+void MTGPackGenerator::compile(Slot& slot, MTGPackSlot * source, WSrcCards * pool)
+{
+    slot.copies = source->copies;
+    slot.empty = !source->entries.size();
+
+    vector<int> weights;
+    int total = 0;
+    for (size_t i = 0; i < source->entries.size(); i++)
+    {
+        MTGPackEntry * entry = source->entries[i];
+        Entry compiled;
+        if (entry->weight <= 0 || !entry->getCards(pool, compiled.cards))
+            continue;
+        compiled.copies = entry->copies;
+        slot.entries.push_back(compiled);
+        weights.push_back(entry->weight);
+        total += entry->weight;
+    }
+
+    //Vose's alias method: each column gets its own entry up to its probability, and the rest of one other entry
+    size_t n = slot.entries.size();
+    slot.probability.resize(n, 1.0f);
+    slot.alias.resize(n, 0);
+    vector<float> scaled(n);
+    vector<int> small, large;
+    for (size_t i = 0; i < n; i++)
+    {
+        scaled[i] = (float) weights[i] * n / total;
+        slot.alias[i] = (int) i;
+        if (scaled[i] < 1.0f)
+            small.push_back((int) i);
+        else
+            large.push_back((int) i);
+    }
+    while (small.size() && large.size())
+    {
+        int s = small.back();
+        small.pop_back();
+        int l = large.back();
+        slot.probability[s] = scaled[s];
+        slot.alias[s] = l;
+        scaled[l] -= 1.0f - scaled[s];
+        if (scaled[l] < 1.0f)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    //What remains is 1, give or take rounding errors
+}
+
+void MTGPackGenerator::setSeed(unsigned int seed)
+{
+    state = seed ? seed : 1;
+}
+
+unsigned int MTGPackGenerator::random()
+{
+    //xorshift32
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+int MTGPackGenerator::assemblePack(MTGDeck * to)
+{
+    if (!bValid)
+        return -1;
+    int carryover = 0;
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        Slot& slot = slots[i];
+        if (slot.empty)
+        {
+            carryover = slot.copies;
+            continue;
+        }
+        int amt = slot.copies + carryover;
+        carryover = 0;
+        size_t n = slot.entries.size();
+        for (int j = 0; j < amt; j++)
+        {
+            if (!n)
+            {
+                carryover++;
+                continue;
+            }
+            size_t column = random() % n;
+            float chance = (random() & 0xFFFF) / 65536.0f;
+            Entry& entry = slot.entries[chance < slot.probability[column] ? column : slot.alias[column]];
+            if (!entry.cards.size())
+                continue;
+            for (int k = 0; k < entry.copies; k++)
+                to->add(entry.cards[random() % entry.cards.size()]);
+        }
+    }
+    return carryover;
+}
+
+int MTGPackGenerator::assemblePool(MTGDeck * to, int nbPacks)
+{
+    int fails = 0;
+    for (int i = 0; i < nbPacks; i++)
+    {
+        int result = assemblePack(to);
+        if (result < 0)
+            return result;
+        fails += result;
+    }
     return fails;
 }
 
@@ -104,18 +212,8 @@ void MTGPackSlot::addEntry(MTGPackEntry*item)
 }
 int MTGPack::assemblePack(MTGDeck *to)
 {
-    int carryover = 0;
-    WSrcCards * p = getPool(pool);
-    if (!p)
-        return -1;
-    p->Shuffle();
-
-    for (size_t i = 0; i < slotss.size(); i++)
-    {
-        carryover = slotss[i]->add(p, to, carryover);
-    }
-    SAFE_DELETE(p);
-    return carryover;
+    MTGPackGenerator generator(this, rand());
+    return generator.assemblePack(to);
 }
 void MTGPack::countCards()
 {
@@ -223,6 +321,9 @@ void MTGPack::load(string filename)
                     es->copies = atoi(holder);
                 else
                     es->copies = 1;
+                holder = pEntry->Attribute("weight");
+                if (holder)
+                    es->weight = atoi(holder);
                 es->card = MTGCollection()->getCardByName(pEntry->Value());
                 s->addEntry(es);
             }
@@ -234,6 +335,9 @@ void MTGPack::load(string filename)
                     er->copies = atoi(holder);
                 else
                     er->copies = 1;
+                holder = pEntry->Attribute("weight");
+                if (holder)
+                    er->weight = atoi(holder);
                 const char * text = pEntry->GetText();
                 if (text)
                     er->filter = text;
@@ -242,6 +346,9 @@ void MTGPack::load(string filename)
             else if (tag == "nothing")
             {
                 MTGPackEntryNothing * nt = NEW MTGPackEntryNothing();
+                holder = pEntry->Attribute("weight");
+                if (holder)
+                    nt->weight = atoi(holder);
                 s->addEntry(nt);
             }
         }
@@ -0,0 +1,127 @@
+#include "PrecompiledHeader.h"
+
+#include "MemoryPool.h"
+#include "Threading.h"
+
+namespace
+{
+    // The pool is owned by its game, not by the thread
+    void noCleanup(MemoryPool *)
+    {
+    }
+
+    boost::thread_specific_ptr<MemoryPool> sCurrentPool(noCleanup);
+}
+
+MemoryPool::MemoryPool()
+    : mChunkPos(NULL), mChunkEnd(NULL), mLiveObjects(0), mReleased(false)
+{
+    for (int i = 0; i < NB_SIZE_CLASSES; ++i)
+        mFreeLists[i] = NULL;
+}
+
+MemoryPool::~MemoryPool()
+{
+    for (size_t i = 0; i < mChunks.size(); ++i)
+        ::operator delete(mChunks[i]);
+}
+
+void MemoryPool::release()
+{
+    if (sCurrentPool.get() == this)
+        sCurrentPool.reset(NULL);
+
+    if (mLiveObjects)
+    {
+        DebugTrace("MemoryPool: " << mLiveObjects << " objects still alive when the pool was released");
+        mReleased = true;
+        return;
+    }
+
+    delete this;
+}
+
+MemoryPool * MemoryPool::current()
+{
+    return sCurrentPool.get();
+}
+
+void MemoryPool::setCurrent(MemoryPool * pool)
+{
+    sCurrentPool.reset(pool);
+}
+
+void * MemoryPool::allocate(size_t size)
+{
+    MemoryPool * pool = sCurrentPool.get();
+    if (pool && size <= MAX_SIZE)
+        return pool->allocateFromPool(size);
+
+    Header * header = static_cast<Header *>(::operator new(HEADER_SIZE + size));
+    header->pool = NULL;
+    header->sizeClass = 0;
+    return reinterpret_cast<char *>(header) + HEADER_SIZE;
+}
+
+void * MemoryPool::allocateFromPool(size_t size)
+{
+    size_t sizeClass = size ? (size - 1) / GRANULARITY : 0;
+    Header * header;
+
+    if (mFreeLists[sizeClass])
+    {
+        // Free blocks keep their header, the next free block is stored right after it
+        header = static_cast<Header *>(mFreeLists[sizeClass]);
+        mFreeLists[sizeClass] = *reinterpret_cast<void **>(reinterpret_cast<char *>(header) + HEADER_SIZE);
+    }
+    else
+    {
+        size_t blockSize = HEADER_SIZE + (sizeClass + 1) * GRANULARITY;
+        if (mChunkPos + blockSize > mChunkEnd)
+        {
+            // What's left of the current chunk is lost until the pool is released
+            mChunkPos = static_cast<char *>(::operator new(CHUNK_SIZE));
+            mChunkEnd = mChunkPos + CHUNK_SIZE;
+            mChunks.push_back(mChunkPos);
+        }
+        header = reinterpret_cast<Header *>(mChunkPos);
+        header->pool = this;
+        header->sizeClass = sizeClass;
+        mChunkPos += blockSize;
+    }
+
+    ++mLiveObjects;
+    return reinterpret_cast<char *>(header) + HEADER_SIZE;
+}
+
+void MemoryPool::deallocate(void * p)
+{
+    if (!p)
+        return;
+
+    Header * header = reinterpret_cast<Header *>(static_cast<char *>(p) - HEADER_SIZE);
+    MemoryPool * pool = header->pool;
+
+    if (!pool)
+    {
+        ::operator delete(header);
+        return;
+    }
+
+    *static_cast<void **>(p) = pool->mFreeLists[header->sizeClass];
+    pool->mFreeLists[header->sizeClass] = header;
+
+    if (!--pool->mLiveObjects && pool->mReleased)
+        delete pool;
+}
+
+MemoryPool::Scope::Scope(MemoryPool * pool)
+    : mPrevious(sCurrentPool.get())
+{
+    sCurrentPool.reset(pool);
+}
+
+MemoryPool::Scope::~Scope()
+{
+    sCurrentPool.reset(mPrevious);
+}
@@ -8,6 +8,7 @@
 #include "Rules.h"
 #include "GameObserver.h"
 #include "GameStateShop.h"
+#include "AIProfiler.h"
 
 using std::string;
 
@@ -20,6 +21,10 @@ using std::string;
 #define SLOW_TEST 40
 #define FAST_TEST 6
 
+// Default limits after which a test is considered hung, see TestSuite
+#define DEFAULT_MAX_STEPS 100000
+#define DEFAULT_TEST_TIMEOUT 120
+
 // NULL is sent in place of a MTGDeck since there is no way to create a MTGDeck without a proper deck file.
 // TestSuiteAI will be responsible for managing its own deck state.
 TestSuiteAI::TestSuiteAI(TestSuiteGame *tsGame, int playerId) :
@@ -85,6 +90,9 @@ int TestSuiteAI::displayStack()
 
 int TestSuiteAI::Act(float)
 {
+    if (suite->limitReached())
+        return 1;
+
     observer->setLoser(NULL); // Prevent draw rule from losing the game
 
     //Last bits of initialization require to be done here, after the first "update" call of the game
@@ -298,9 +306,50 @@ string TestSuiteGame::getNextAction()
 
 void TestSuiteGame::handleResults(bool wasAI, int error)
 {
-    testsuite->handleResults(wasAI, error);
+    testsuite->addResult(filename, wasAI, error, steps, JGEGetTime() - testStart, "", observer ? observer->getStateHash() : 0);
 };
 
+bool TestSuiteGame::wasAI()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (observer->players[i]->playMode == Player::MODE_AI)
+            return true;
+    }
+    return false;
+}
+
+bool TestSuiteGame::limitReached()
+{
+    if (timedOut)
+        return true;
+
+    steps++;
+    const char * reason = NULL;
+    if (testsuite->maxSteps > 0 && steps > testsuite->maxSteps)
+        reason = "step limit";
+    else if (testsuite->maxTime > 0 && JGEGetTime() - testStart > testsuite->maxTime)
+        reason = "time limit";
+
+    if (!reason)
+        return false;
+
+    timedOut = true;
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        char result[4096];
+        int elapsed = JGEGetTime() - testStart;
+        sprintf(result, "<h3>%s</h3>", filename.c_str());
+        Log(result);
+        sprintf(result, "<span class=\"error\">==Test aborted: %s reached after %i steps and %ims==</span><br />", reason, steps, elapsed);
+        Log(result);
+        testsuite->addResult(filename, wasAI(), 1, steps, elapsed, reason);
+        Log("<span class=\"error\">==Test Failed !==</span>");
+    }
+    observer->setLoser(observer->players[0]);
+    return true;
+}
+
 
 void TestSuite::initGame(GameObserver* g)
 {
@@ -324,7 +373,7 @@ void TestSuite::initGame(GameObserver* g)
 int TestSuiteGame::Log(const char * text)
 {
     ofstream file;
-    if (JFileSystem::GetInstance()->openForWrite(file, "test/results.html", ios_base::app))
+    if (JFileSystem::GetInstance()->openForWrite(file, mLogFile, ios_base::app))
     {
         file << text;
         file << "\n";
@@ -436,8 +485,18 @@ void TestSuiteGame::assertGame()
     mMutex.unlock();
 }
 
-void TestSuite::handleResults(bool wasAI, int error)
+void TestSuite::addResult(const string& filename, bool wasAI, int error, int steps, int time, const string& abortReason, uint64_t stateHash)
 {
+    TestSuiteResult result;
+    result.filename = filename;
+    result.wasAI = wasAI;
+    result.errors = error;
+    result.abortReason = abortReason;
+    result.steps = steps;
+    result.time = time;
+    result.stateHash = stateHash;
+    results.push_back(result);
+
     if (wasAI)
     {
         nbAITests++;
@@ -459,22 +518,60 @@ void TestSuite::handleResults(bool wasAI, int error)
 TestSuite::~TestSuite()
 {
   mProcessing = false;
+  waitForWorkers();
+
+  observer = 0;
+}
+
+void TestSuite::waitForWorkers()
+{
   while(mWorkerThread.size())
   {
     mWorkerThread.back()->join();
     SAFE_DELETE(mWorkerThread.back());
     mWorkerThread.pop_back();
   }
+}
 
-  observer = 0;
+void TestSuite::parseOptions()
+{
+    vector<string> argv = JGE::GetInstance()->GetARGV();
+    for (size_t i = 1; i + 1 < argv.size(); i++)
+    {
+        const string& option = argv[i];
+        const string& value = argv[i + 1];
+        if (option == "--shard")
+        {
+            if (sscanf(value.c_str(), "%i/%i", &shard, &nbShards) != 2 || nbShards < 1 || shard < 1 || shard > nbShards)
+            {
+                DebugTrace("TESTSUITE: invalid shard " << value << ", running all the tests");
+                shard = nbShards = 1;
+            }
+        }
+        else if (option == "--threads")
+            nbThreads = atoi(value.c_str());
+        else if (option == "--max-steps")
+            maxSteps = atoi(value.c_str());
+        else if (option == "--test-timeout")
+            maxTime = atoi(value.c_str()) * 1000;
+        else if (option == "--junit")
+            junitFile = value;
+        else if (option == "--json")
+            jsonFile = value;
+        else
+            continue;
+        i++;
+    }
 }
 
 TestSuite::TestSuite(const char * filename)
-    : TestSuiteGame(0), mRules(0), mProcessing(false)
+    : TestSuiteGame(0), mRules(0), mProcessing(false), shard(1), nbShards(1), nbThreads(0),
+      maxSteps(DEFAULT_MAX_STEPS), maxTime(DEFAULT_TEST_TIMEOUT * 1000)
 {
     timerLimit = 0;
     testsuite = this;
-    
+    parseOptions();
+
     std::string s;
     nbfiles = 0;
     currentfile = 0;
@@ -483,6 +580,7 @@ TestSuite::TestSuite(const char * filename)
     nbAIFailed = 0;
     nbAITests = 0;
     int comment = 0;
+    int index = 0;
     seed = 0;
     forceAbility = false;
     aiMaxCalls = -1;
@@ -500,12 +598,28 @@ TestSuite::TestSuite(const char * filename)
             if (s[0] == '/' && s[1] == '*') comment = 1;
             if (s[0] && s[0] != '#' && !comment)
             {
-                files[nbfiles] = s;
-                nbfiles++;
+                // Shards take every nbShards-th test, so that slow tests in a row get spread out
+                if (index++ % nbShards == shard - 1)
+                    files.push_back(s);
             }
             if (s[0] == '*' && s[1] == '/') comment = 0;
         }
     }
+    nbfiles = (int) files.size();
+
+    string results = "test/results";
+    if (nbShards > 1)
+    {
+        char suffix[32];
+        sprintf(suffix, "_%iof%i", shard, nbShards);
+        results.append(suffix);
+    }
+    mLogFile = results + ".html";
+    if (!junitFile.size())
+        junitFile = results + ".xml";
+    if (!jsonFile.size())
+        jsonFile = results + ".json";
+    profileFile = results + "_ai_profile.txt";
 
     //If more than 1 test, prefecth names to make the suite run faster
     if (nbfiles > 1)
@@ -513,7 +627,7 @@ TestSuite::TestSuite(const char * filename)
 
 
     ofstream file2;
-    if (JFileSystem::GetInstance()->openForWrite(file2, "/test/results.html"))
+    if (JFileSystem::GetInstance()->openForWrite(file2, mLogFile))
     {
         file2 << "<html><head>";
 #ifdef WIN32
@@ -542,6 +656,9 @@ int TestSuite::loadNext()
         // we let GameStateDuel delete the latest gameObserver.
         mProcessing = false;
         observer = 0;
+        waitForWorkers();
+        endTime = JGEGetTime();
+        writeReports();
         return 0;
     }
 
@@ -554,22 +671,17 @@ int TestSuite::loadNext()
     if(!mProcessing)
     {   // "I don't like to wait" mode
         mProcessing = true;
-        while(mWorkerThread.size())
-        {
-          mWorkerThread.back()->join();
-          SAFE_DELETE(mWorkerThread.back());
-          mWorkerThread.pop_back();
-        }
-
-        size_t thread_count = 1;
-#ifdef QT_CONFIG
-        thread_count = QThread::idealThreadCount();
-#elif defined(IOS)
-        thread_count = 6;
-#else
-		thread_count = 4;
-#endif
-        for(size_t i = 0; i < (thread_count-1); i++)
+        waitForWorkers();
+
+        size_t thread_count = nbThreads;
+        if (!thread_count)
+            thread_count = boost::thread::hardware_concurrency();
+        if (!thread_count)
+            thread_count = 4;
+        // No point in threads without a test to run, the main thread runs one too
+        if (thread_count > (size_t) nbfiles)
+            thread_count = nbfiles;
+        for(size_t i = 1; i < thread_count; i++)
             mWorkerThread.push_back(new boost::thread(ThreadProc, this));
     }
 
@@ -583,6 +695,7 @@ int TestSuite::loadNext()
 
 void TestSuite::ThreadProc(void* inParam)
 {
+    JLogger::SetThreadTag("test");
     LOG("Entering TestSuite::ThreadProc");
     TestSuite* instance = reinterpret_cast<TestSuite*>(inParam);
     if (instance)
@@ -614,9 +727,103 @@ int TestSuite::run()
   loadNext();
   ThreadProc(this);
 
+  mProcessing = false;
+  waitForWorkers();
+  endTime = JGEGetTime();
+  writeReports();
+
   return nbFailed + nbAIFailed;
 }
 
+namespace
+{
+    string xmlEscape(const string& s)
+    {
+        string escaped;
+        for (size_t i = 0; i < s.size(); i++)
+        {
+            switch (s[i])
+            {
+            case '&': escaped.append("&amp;"); break;
+            case '<': escaped.append("&lt;"); break;
+            case '>': escaped.append("&gt;"); break;
+            case '"': escaped.append("&quot;"); break;
+            default: escaped.push_back(s[i]);
+            }
+        }
+        return escaped;
+    }
+
+    string jsonEscape(const string& s)
+    {
+        string escaped;
+        for (size_t i = 0; i < s.size(); i++)
+        {
+            if (s[i] == '"' || s[i] == '\\')
+                escaped.push_back('\\');
+            escaped.push_back(s[i]);
+        }
+        return escaped;
+    }
+}
+
+void TestSuite::writeReports()
+{
+    boost::mutex::scoped_lock lock(mMutex);
+    std::sort(results.begin(), results.end());
+
+    int failures = 0;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        if (results[i].errors)
+            failures++;
+    }
+
+    char buf[512];
+    ofstream junit;
+    if (JFileSystem::GetInstance()->openForWrite(junit, junitFile))
+    {
+        sprintf(buf, "<testsuite name=\"wagic\" tests=\"%i\" failures=\"%i\" time=\"%.3f\">\n",
+                (int) results.size(), failures, (endTime - startTime) / 1000.0f);
+        junit << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" << buf;
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const TestSuiteResult& r = results[i];
+            sprintf(buf, "\" time=\"%.3f\">\n", r.time / 1000.0f);
+            junit << "  <testcase classname=\"" << (r.wasAI ? "wagic.ai" : "wagic") << "\" name=\"" << xmlEscape(r.filename) << buf;
+            if (r.abortReason.size())
+                junit << "    <failure message=\"aborted: " << r.abortReason << "\"/>\n";
+            else if (r.errors)
+                junit << "    <failure message=\"" << r.errors << " assertion(s) failed, see results.html\"/>\n";
+            junit << "    <system-out>steps: " << r.steps << "</system-out>\n";
+            junit << "  </testcase>\n";
+        }
+        junit << "</testsuite>\n";
+        junit.close();
+    }
+
+    ofstream json;
+    if (JFileSystem::GetInstance()->openForWrite(json, jsonFile))
+    {
+        json << "{\n  \"shard\": " << shard << ", \"shards\": " << nbShards
+             << ", \"tests\": " << results.size() << ", \"failures\": " << failures
+             << ", \"time\": " << (endTime - startTime) << ",\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const TestSuiteResult& r = results[i];
+            json << "    {\"file\": \"" << jsonEscape(r.filename) << "\", \"ai\": " << (r.wasAI ? "true" : "false")
+                 << ", \"passed\": " << (r.errors ? "false" : "true") << ", \"errors\": " << r.errors
+                 << ", \"aborted\": \"" << r.abortReason << "\", \"steps\": " << r.steps << ", \"time\": " << r.time
+                 << ", \"hash\": \"" << hex << setw(16) << setfill('0') << r.stateHash << dec << setfill(' ') << "\"}"
+                 << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        json << "  ]\n}\n";
+        json.close();
+    }
+
+    AI_PROFILE_REPORT(profileFile);
+}
+
 
 void TestSuiteActions::cleanup()
 {
@@ -784,14 +991,19 @@ void TestSuite::pregameTests()
     ShopBooster sb;
     for (int i = 0; i < 5; i++)
     {
-        nbTests++;
-        sprintf(result, "<h3>pregame/BoosterTest#%i</h3>", i);
+        boost::mutex::scoped_lock lock(mMutex);
+        int start = JGEGetTime();
+        char name[64];
+        sprintf(name, "pregame/BoosterTest#%i", i);
+        sprintf(result, "<h3>%s</h3>", name);
         Log(result);
-        if (!sb.unitTest()) nbFailed++;
+        int error = sb.unitTest() ? 0 : 1;
+        addResult(name, false, error, 0, JGEGetTime() - start);
     }
 }
 
 boost::mutex TestSuiteGame::mMutex;
+string TestSuiteGame::mLogFile = "test/results.html";
 
 TestSuiteGame::~TestSuiteGame()
 {
@@ -800,13 +1012,13 @@ TestSuiteGame::~TestSuiteGame()
 
 TestSuiteGame::TestSuiteGame(TestSuite* testsuite)
     : summoningSickness(0), forceAbility(false), gameType(GAME_TYPE_CLASSIC), timerLimit(0),
-      currentAction(0), observer(0), testsuite(testsuite)
+      currentAction(0), observer(0), steps(0), testStart(0), timedOut(false), testsuite(testsuite)
 {
 }
 
 TestSuiteGame::TestSuiteGame(TestSuite* testsuite, string _filename)
     : summoningSickness(0), forceAbility(false), gameType(GAME_TYPE_CLASSIC), timerLimit(FAST_TEST),
-      currentAction(0), observer(0), testsuite(testsuite)
+      currentAction(0), observer(0), steps(0), testStart(0), timedOut(false), testsuite(testsuite)
 {
     filename = _filename;
     observer = new GameObserver();
@@ -827,6 +1039,10 @@ void TestSuiteGame::ResetManapools()
 void TestSuiteGame::initGame()
 {
     DebugTrace("TESTSUITE Init Game");
+    MemoryPool::Scope poolScope(observer->getPool());
+    steps = 0;
+    timedOut = false;
+    testStart = JGEGetTime();
     observer->phaseRing->goToPhase(initState.phase, observer->players[0], false);
     observer->setCurrentGamePhase(initState.phase);
 
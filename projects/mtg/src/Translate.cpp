@@ -18,15 +18,48 @@ void Translator::EndInstance()
 
 int Translator::Add(string from, string to)
 {
-    values[from] = to;
+    map<string, int>::iterator it = keyIds.find(from);
+    if (it != keyIds.end())
+    {
+        translations[it->second] = to;
+        return 1;
+    }
+
+    keyIds[from] = (int) translations.size();
+    translations.push_back(to);
+    generation++;
     return 1;
 }
 
-string Translator::translate(string value)
+int Translator::getKeyId(const string& key) const
+{
+    map<string, int>::const_iterator it = keyIds.find(key);
+    if (it == keyIds.end()) return -1;
+    return it->second;
+}
+
+const string& Translator::translate(int keyId) const
+{
+    return translations[keyId];
+}
+
+const string& Translator::translate(const TranslationKey& key)
+{
+    // Keys which were missing get looked up again once new translations are loaded
+    if (key.mGeneration != generation)
+    {
+        key.mId = getKeyId(key.mKey);
+        key.mGeneration = generation;
+    }
+    if (key.mId >= 0) return translations[key.mId];
+    return translate(key.mKey);
+}
+
+const string& Translator::translate(const string& value)
 {
     //if (!initDone) init();
-    map<string, string>::iterator it = values.find(value);
-    if (it != values.end()) return it->second;
+    map<string, int>::iterator it = keyIds.find(value);
+    if (it != keyIds.end()) return translations[it->second];
 #if defined DEBUG_TRANSLATE
     if (checkMisses)
     {
@@ -59,6 +92,7 @@ Translator::~Translator()
 Translator::Translator()
 {
     initDone = false;
+    generation = 0;
     neofont = false;
     //init();
 }
@@ -165,17 +199,26 @@ void Translator::init()
         else
             neofont = false;
         initDone = true;
-        load(name, &values);
+        map<string, string> dictionary;
+        load(name, &dictionary);
+        for (map<string, string>::iterator it = dictionary.begin(); it != dictionary.end(); ++it)
+            Add(it->first, it->second);
     }
 
     initCards();
     initDecks();
 }
 
-string _(string toTranslate)
+const string& _(const string& toTranslate)
 {
     Translator * t = Translator::GetInstance();
     return t->translate(toTranslate);
 }
 
+const string& _(const TranslationKey& key)
+{
+    Translator * t = Translator::GetInstance();
+    return t->translate(key);
+}
+
 bool neofont;
@@ -184,11 +184,8 @@ void WCachedTexture::Refresh()
     }
 }
 
-bool WCachedTexture::Attempt(const string& filename, int submode, int & error)
+string WCachedTexture::RealFilename(const string& filename, int submode)
 {
-    mFilename = filename;
-    int format = TEXTURE_FORMAT;
-    loadedMode = submode;
     string realname = filename;
 
     //Form correct filename.
@@ -218,6 +215,16 @@ bool WCachedTexture::Attempt(const string& filename, int submode, int & error)
             realname = WResourceManager::Instance()->graphicsFile(realname);
     }
 
+    return realname;
+}
+
+bool WCachedTexture::Attempt(const string& filename, int submode, int & error)
+{
+    mFilename = filename;
+    int format = TEXTURE_FORMAT;
+    loadedMode = submode;
+    string realname = RealFilename(filename, submode);
+
     //Apply pixel mode
     if (submode & TEXTURE_SUB_5551) format = GU_PSM_5551;
 
@@ -241,6 +248,28 @@ bool WCachedTexture::Attempt(const string& filename, int submode, int & error)
     return true;
 }
 
+bool WCachedTexture::Attempt(const string& filename, const string& realname, int submode, u8 * data, int size, int & error)
+{
+    mFilename = filename;
+    int format = TEXTURE_FORMAT;
+    loadedMode = submode;
+
+    //Apply pixel mode
+    if (submode & TEXTURE_SUB_5551) format = GU_PSM_5551;
+
+    texture = JRenderer::GetInstance()->LoadTextureFromMemory(realname.c_str(), data, size, TEX_TYPE_USE_VRAM, format);
+
+    //Failure, or no decoder for this format.
+    if (!texture)
+    {
+        error = CACHE_ERROR_BAD;
+        return false;
+    }
+
+    error = CACHE_ERROR_NONE;
+    return true;
+}
+
 //WCachedSample
 WCachedSample::WCachedSample()
 {
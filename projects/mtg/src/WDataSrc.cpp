@@ -294,9 +294,15 @@ void WSrcCards::validate()
     validated.clear();
     updateCounts();
     if (!filtersRoot) return;
+
+    //The filters are evaluated for the whole collection at once, then looked up for our cards
+    WCardIndex * index = WCardIndex::GetInstance();
+    WCardBits matches;
+    filtersRoot->match(*index, matches);
     for (size_t t = 0; t < cards.size(); t++)
     {
-        if (matchesFilters(cards[t])) validated.push_back(t);
+        int pos = index->position(cards[t]);
+        if (pos >= 0 ? matches.test(pos) : matchesFilters(cards[t])) validated.push_back(t);
     }
 }
 
@@ -318,13 +324,15 @@ bool WSrcCards::isEmptySet(WCardFilter * f)
     size_t max = cards.size();
     if (validated.size()) max = validated.size();
     if (!f) return (max > 0);
+
+    WCardIndex * index = WCardIndex::GetInstance();
+    WCardBits matches;
+    f->match(*index, matches);
     for (size_t t = 0; t < max; t++)
     {
-        if (validated.size())
-        {
-            if (f->isMatch(cards[validated[t]])) return false;
-        }
-        else if (f->isMatch(cards[t])) return false;
+        MTGCard * c = validated.size() ? cards[validated[t]] : cards[t];
+        int pos = index->position(c);
+        if (pos >= 0 ? matches.test(pos) : f->isMatch(c)) return false;
     }
     return true;
 }
@@ -613,10 +621,11 @@ bool WCSortRarity::operator()(const MTGCard*l, const MTGCard*r)
 bool WCSortAlpha::operator()(const MTGCard*l, const MTGCard*r)
 {
     if (!l || !r || !l->data || !r->data) return false;
-    string ln = l->data->getLCName();
-    string rn = r->data->getLCName();
-    if (ln == rn) return l->getMTGId() < r->getMTGId();
-    return (ln < rn);
+    const string& ln = l->data->getLCName();
+    const string& rn = r->data->getLCName();
+    int result = ln.compare(rn);
+    if (!result) return l->getMTGId() < r->getMTGId();
+    return (result < 0);
 }
 
 bool WCSortCollector::operator()(const MTGCard*l, const MTGCard*r)
@@ -659,11 +668,11 @@ bool WCSortCollector::operator()(const MTGCard*l, const MTGCard*r)
                                 {
                                     if (!isW)
                                     {
-                                        string ln = l->data->getLCName();
-                                        string rn = r->data->getLCName();
-                                        if (ln.substr(0, 4) == "the ") ln = ln.substr(4);
-                                        if (rn.substr(0, 4) == "the ") rn = rn.substr(4);
-                                        return (ln < rn);
+                                        const string& ln = l->data->getLCName();
+                                        const string& rn = r->data->getLCName();
+                                        size_t lstart = ln.compare(0, 4, "the ") ? 0 : 4;
+                                        size_t rstart = rn.compare(0, 4, "the ") ? 0 : 4;
+                                        return (ln.compare(lstart, string::npos, rn, rstart, string::npos) < 0);
                                     }
                                     return (isW < 0);
                                 }
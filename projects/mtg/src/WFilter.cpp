@@ -4,6 +4,350 @@
 #include "PlayerData.h"
 #include "Translate.h"
 
+//WCardBits
+void WCardBits::resize(size_t size, bool value)
+{
+    mSize = size;
+    words.assign((size + kWordBits - 1) / kWordBits, value ? ~0U : 0U);
+    if (value && size % kWordBits)
+        words.back() = (1U << (size % kWordBits)) - 1;
+}
+
+bool WCardBits::any() const
+{
+    for (size_t i = 0; i < words.size(); i++)
+        if (words[i]) return true;
+    return false;
+}
+
+WCardBits& WCardBits::operator&=(const WCardBits& other)
+{
+    for (size_t i = 0; i < words.size() && i < other.words.size(); i++)
+        words[i] &= other.words[i];
+    return *this;
+}
+
+WCardBits& WCardBits::operator|=(const WCardBits& other)
+{
+    for (size_t i = 0; i < words.size() && i < other.words.size(); i++)
+        words[i] |= other.words[i];
+    return *this;
+}
+
+WCardBits& WCardBits::operator-=(const WCardBits& other)
+{
+    for (size_t i = 0; i < words.size() && i < other.words.size(); i++)
+        words[i] &= ~other.words[i];
+    return *this;
+}
+
+//WCardIndex
+WCardIndex* WCardIndex::me = NULL;
+
+WCardIndex* WCardIndex::GetInstance()
+{
+    MTGAllCards * collection = MTGCollection();
+    if (me && (me->collection != collection || me->cards.size() != collection->collection.size()))
+        SAFE_DELETE(me);
+    if (!me) me = NEW WCardIndex(collection);
+    return me;
+}
+
+void WCardIndex::Destroy()
+{
+    SAFE_DELETE(me);
+}
+
+WCardIndex::WCardIndex(MTGAllCards * collection) :
+    collection(collection), textIndexed(false)
+{
+    //http://code.google.com/p/wagic/issues/detail?id=650
+    //Basic lands are not producing their mana through regular abilities anymore,
+    //but through a rule that is outside of the primitives. This is a hack to address this
+    const char * lands[] = { "dummy(colorless)", "forest", "island", "mountain", "swamp", "plains" };
+    for (int color = 0; color < kBasicLands; color++)
+        basicLandTypes[color] = MTGAllCards::findType(lands[color], false);
+
+    map<int, MTGCard *>::iterator it;
+    for (it = collection->collection.begin(); it != collection->collection.end(); it++)
+        cards.push_back(it->second);
+
+    allCards.resize(cards.size());
+    produced.resize(cards.size(), 0);
+    vector<CardPrimitive *> primitives;
+    for (size_t i = 0; i < cards.size(); i++)
+    {
+        if (!cards[i]) continue;
+        allCards.set(i);
+        if (cards[i]->data) primitives.push_back(cards[i]->data);
+    }
+
+    //The abilities of the whole collection are read once, without keeping them in memory
+    ProducedColorsVisitor visitor(this);
+    collection->visitDetails(primitives, visitor);
+    for (size_t i = 0; i < cards.size(); i++)
+    {
+        if (cards[i] && cards[i]->data) produced[i] = visitor.produced[cards[i]->data];
+    }
+}
+
+void WCardIndex::ProducedColorsVisitor::visit(CardPrimitive * primitive, CardPrimitive * details)
+{
+    produced[primitive] = index->computeProducedColors(primitive, details->getMagicText());
+}
+
+int WCardIndex::position(MTGCard * c) const
+{
+    if (!c) return -1;
+    int id = c->getMTGId();
+    size_t lo = 0, hi = cards.size();
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (!cards[mid] || cards[mid]->getMTGId() < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < cards.size() && cards[lo] == c) return (int) lo;
+    return -1;
+}
+
+unsigned int WCardIndex::producedColors(MTGCard * c)
+{
+    if (!c || !c->data) return 0;
+    int pos = position(c);
+    if (pos >= 0) return produced[pos];
+    return computeProducedColors(c->data, c->data->getMagicText());
+}
+
+unsigned int WCardIndex::computeProducedColors(CardPrimitive * data, const string& magicText)
+{
+    unsigned int result = 0;
+    for (int color = 0; color < kBasicLands; color++)
+    {
+        if (basicLandTypes[color] && data->hasType(basicLandTypes[color]))
+            result |= 1U << color;
+    }
+
+    //Retrieve non basic Mana abilities
+    string s = magicText;
+    size_t t = s.find("add");
+    while (t != string::npos)
+    {
+        s = s.substr(t + 3);
+        ManaCost * mc = ManaCost::parseManaCost(s);
+        for (int color = 0; color < Constants::NB_Colors && color < 32; color++)
+        {
+            if (mc->hasColor(color) > 0)
+                result |= 1U << color;
+        }
+        SAFE_DELETE(mc);
+        t = s.find("add");
+    }
+    return result;
+}
+
+bool WCardIndex::hasValue(MTGCard * c, size_t i, Attribute attribute, int value)
+{
+    CardPrimitive * data = c->data;
+    switch (attribute)
+    {
+    case COLOR:
+        return data->hasColor(value);
+    case PRODUCES:
+        return value >= 0 && value < 32 && (produced[i] & (1U << value));
+    case RARITY:
+        return c->getRarity() == value;
+    case SET:
+        return c->setId == value;
+    case CMC:
+        return data->getManaCost()->getConvertedCost() == value;
+    case POWER:
+        return data->getPower() == value;
+    case TOUGHNESS:
+        return data->getToughness() == value;
+    case TYPE:
+        return data->hasType(value);
+    case ABILITY:
+        return value >= 0 && value < Constants::NB_BASIC_ABILITIES && data->basicAbilities.test(value);
+    case LETTER:
+    {
+        const string& s = data->getLCName();
+        if (!s.size()) return false;
+        return (s[0] == value || (value == '#' && (isdigit(s[0]) || ispunct(s[0]))));
+    }
+    }
+    return false;
+}
+
+const WCardBits& WCardIndex::get(Attribute attribute, int value)
+{
+    pair<int, int> key(attribute, value);
+    map<pair<int, int> , WCardBits>::iterator it = columns.find(key);
+    if (it != columns.end()) return it->second;
+
+    WCardBits& column = columns[key];
+    column.resize(cards.size());
+    for (size_t i = 0; i < cards.size(); i++)
+    {
+        if (cards[i] && cards[i]->data && hasValue(cards[i], i, attribute, value))
+            column.set(i);
+    }
+    return column;
+}
+
+void WCardIndex::splitWords(const string& text, vector<string>& words)
+{
+    string word;
+    for (size_t i = 0; i <= text.size(); i++)
+    {
+        unsigned char c = i < text.size() ? text[i] : ' ';
+        if (isalnum(c))
+            word += (char) tolower(c);
+        else if (word.size())
+        {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+}
+
+string WCardIndex::getRulesText(CardPrimitive * data)
+{
+    data->loadDetails();
+    if (data->text.size() || !data->formattedText.size()) return data->text;
+    string result;
+    for (size_t i = 0; i < data->formattedText.size(); i++)
+        result.append(data->formattedText[i]).append(" ");
+    return result;
+}
+
+void WCardIndex::TextIndex::add(int primitive, const string& text, map<string, vector<int> >& postings)
+{
+    vector<string> found;
+    splitWords(text, found);
+    for (size_t i = 0; i < found.size(); i++)
+    {
+        vector<int>& list = postings[found[i]];
+        if (!list.size() || list.back() != primitive) list.push_back(primitive);
+    }
+}
+
+void WCardIndex::TextIndex::build(map<string, vector<int> >& postings)
+{
+    words.reserve(postings.size());
+    primitives.reserve(postings.size());
+    for (map<string, vector<int> >::iterator it = postings.begin(); it != postings.end(); it++)
+    {
+        words.push_back(it->first);
+        primitives.push_back(vector<int>());
+        primitives.back().swap(it->second);
+    }
+    postings.clear();
+}
+
+void WCardIndex::TextIndex::find(const string& part, vector<int>& found) const
+{
+    //Words starting with part are next to each other, the other ones need a scan
+    vector<string>::const_iterator it = std::lower_bound(words.begin(), words.end(), part);
+    for (; it != words.end() && !it->compare(0, part.size(), part); it++)
+    {
+        const vector<int>& list = primitives[it - words.begin()];
+        found.insert(found.end(), list.begin(), list.end());
+    }
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        if (words[i].size() > part.size() && words[i].find(part, 1) != string::npos)
+            found.insert(found.end(), primitives[i].begin(), primitives[i].end());
+    }
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+}
+
+void WCardIndex::TextVisitor::visit(CardPrimitive * primitive, CardPrimitive * details)
+{
+    index->texts.add(ids[primitive], getRulesText(details), postings);
+}
+
+void WCardIndex::buildTextIndex()
+{
+    textIndexed = true;
+    map<string, vector<int> > namePostings;
+    TextVisitor visitor(this);
+    vector<CardPrimitive *> primitives;
+    for (size_t i = 0; i < cards.size(); i++)
+    {
+        if (!cards[i] || !cards[i]->data) continue;
+        CardPrimitive * data = cards[i]->data;
+        map<CardPrimitive *, int>::iterator it = visitor.ids.find(data);
+        int id;
+        if (it == visitor.ids.end())
+        {
+            id = (int) primitiveCards.size();
+            visitor.ids[data] = id;
+            primitives.push_back(data);
+            primitiveCards.push_back(vector<int>());
+            names.add(id, data->name, namePostings);
+        }
+        else
+            id = it->second;
+        primitiveCards[id].push_back((int) i);
+    }
+    names.build(namePostings);
+
+    //The rules texts of the collection are read once, without keeping them in memory
+    collection->visitDetails(primitives, visitor);
+    texts.build(visitor.postings);
+}
+
+void WCardIndex::search(const string& search, bool namesOnly, WCardBits& result)
+{
+    result.resize(cards.size());
+    vector<string> parts;
+    splitWords(search, parts);
+    if (!parts.size()) return;
+    if (!textIndexed) buildTextIndex();
+
+    vector<int> found;
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        vector<int> matches;
+        names.find(parts[i], matches);
+        if (!namesOnly)
+        {
+            texts.find(parts[i], matches);
+        }
+        if (i)
+        {
+            vector<int> both;
+            std::set_intersection(found.begin(), found.end(), matches.begin(), matches.end(), std::back_inserter(both));
+            found.swap(both);
+        }
+        else
+            found.swap(matches);
+        if (!found.size()) return;
+    }
+
+    for (size_t i = 0; i < found.size(); i++)
+    {
+        const vector<int>& positions = primitiveCards[found[i]];
+        for (size_t j = 0; j < positions.size(); j++)
+            result.set(positions[j]);
+    }
+}
+
+//WCardFilter
+void WCardFilter::match(WCardIndex& index, WCardBits& result)
+{
+    result.resize(index.size());
+    for (size_t i = 0; i < index.size(); i++)
+    {
+        MTGCard * c = index.getCard(i);
+        if (c && isMatch(c)) result.set(i);
+    }
+}
+
 //WCFilterFactory
 WCFilterFactory* WCFilterFactory::me = NULL;
 
@@ -168,7 +512,11 @@ WCardFilter * WCFilterFactory::Terminal(string src, string arg)
         return NEW WCFilterProducesColor(arg);
     else if (type == "pow" || type == "power")
         return NEW WCFilterPower(arg);
-    else if (type == "tgh" || type == "tough" || type == "toughness") return NEW WCFilterToughness(arg);
+    else if (type == "tgh" || type == "tough" || type == "toughness")
+        return NEW WCFilterToughness(arg);
+    else if (type == "name")
+        return NEW WCFilterText(arg, true);
+    else if (type == "text") return NEW WCFilterText(arg);
 
     return NEW WCFilterNULL();
 }
@@ -188,6 +536,10 @@ bool WCFilterLetter::isMatch(MTGCard * c)
     if (s[0] == alpha || (alpha == '#' && (isdigit(s[0]) || ispunct(s[0])))) return true;
     return false;
 }
+void WCFilterLetter::match(WCardIndex& index, WCardBits& result)
+{
+    result = index.get(WCardIndex::LETTER, alpha);
+}
 string WCFilterLetter::getCode()
 {
     char buf[24];
@@ -200,6 +552,14 @@ WCFilterSet::WCFilterSet(string arg)
     setid = setlist.findSet(arg);
 }
 
+void WCFilterSet::match(WCardIndex& index, WCardBits& result)
+{
+    if (setid == MTGSets::ALL_SETS)
+        result = index.all();
+    else
+        result = index.get(WCardIndex::SET, setid);
+}
+
 string WCFilterSet::getCode()
 {
     char buf[256];
@@ -216,6 +576,10 @@ bool WCFilterColor::isMatch(MTGCard * c)
     if (!c || !c->data) return false;
     return (c->data->hasColor(color));
 }
+void WCFilterColor::match(WCardIndex& index, WCardBits& result)
+{
+    result = index.get(WCardIndex::COLOR, color);
+}
 string WCFilterColor::getCode()
 {
     char buf[12];
@@ -249,6 +613,15 @@ bool WCFilterOnlyColor::isMatch(MTGCard * c)
     }
     return (c->data->hasColor(color));
 }
+void WCFilterOnlyColor::match(WCardIndex& index, WCardBits& result)
+{
+    result = index.get(WCardIndex::COLOR, color);
+    for (int i = 0; i < Constants::NB_Colors; i++)
+    {
+        if (i == color) continue;
+        result -= index.get(WCardIndex::COLOR, i);
+    }
+}
 string WCFilterOnlyColor::getCode()
 {
     char buf[12];
@@ -260,33 +633,12 @@ string WCFilterOnlyColor::getCode()
 //WCFilterProducesColor
 bool WCFilterProducesColor::isMatch(MTGCard * c)
 {
-    bool bMatch = false;
-    if (!c || !c->data) return false;
-
-    //http://code.google.com/p/wagic/issues/detail?id=650
-    //Basic lands are not producing their mana through regular abilities anymore,
-    //but through a rule that is outside of the primitives. This block is a hack to address this
-    const string lands[] = { "dummy(colorless)", "forest", "island", "mountain", "swamp", "plains" };
-    if ((color < (int)(sizeof(lands)/sizeof(lands[0]))) && c->data->hasType(lands[color].c_str()))
-        return true;
-
-    //Retrieve non basic Mana abilities
-    string s = c->data->magicText;
-    size_t t = s.find("add");
-    while (t != string::npos)
-    {
-        s = s.substr(t + 3);
-        ManaCost * mc = ManaCost::parseManaCost(s);
-        if (mc->hasColor(color) > 0)
-        {
-            bMatch = true;
-            SAFE_DELETE(mc);
-            break;
-        }
-        SAFE_DELETE(mc);
-        t = s.find("add");
-    }
-    return bMatch;
+    if (!c || !c->data || color < 0 || color >= 32) return false;
+    return (WCardIndex::GetInstance()->producedColors(c) & (1U << color)) != 0;
+}
+void WCFilterProducesColor::match(WCardIndex& index, WCardBits& result)
+{
+    result = index.get(WCardIndex::PRODUCES, color);
 }
 string WCFilterProducesColor::getCode()
 {
@@ -308,6 +660,10 @@ bool WCFilterCMC::isMatch(MTGCard * c)
     ManaCost * mc = c->data->getManaCost();
     return (mc->getConvertedCost() == number);
 }
+void WCFilterCMC::match(WCardIndex& index, WCardBits& result)
+{
+    result = index.get(WCardIndex::CMC, number);
+}
 
 string WCFilterCMC::getCode()
 {
@@ -321,6 +677,10 @@ bool WCFilterPower::isMatch(MTGCard * c)
     if (!c || !c->data) return false;
     return (c->data->getPower() == number);
 }
+void WCFilterPower::match(WCardIndex& index, WCardBits& result)
+{
+    result = index.get(WCardIndex::POWER, number);
+}
 string WCFilterPower::getCode()
 {
     char buf[64];
@@ -333,6 +693,10 @@ bool WCFilterToughness::isMatch(MTGCard * c)
     if (!c || !c->data) return false;
     return (c->data->getToughness() == number);
 }
+void WCFilterToughness::match(WCardIndex& index, WCardBits& result)
+{
+    result = index.get(WCardIndex::TOUGHNESS, number);
+}
 string WCFilterToughness::getCode()
 {
     char buf[64];
@@ -361,6 +725,13 @@ bool WCFilterRarity::isMatch(MTGCard * c)
     if (rarity == 'A') return true; //A for "Any" or "All"
     return (c->getRarity() == rarity);
 }
+void WCFilterRarity::match(WCardIndex& index, WCardBits& result)
+{
+    if (rarity == 'A')
+        result = index.all();
+    else
+        result = index.get(WCardIndex::RARITY, rarity);
+}
 string WCFilterRarity::getCode()
 {
     char buf[64];
@@ -419,6 +790,10 @@ bool WCFilterAbility::isMatch(MTGCard * c)
     
     return c->data->basicAbilities.test(ability);
 }
+void WCFilterAbility::match(WCardIndex& index, WCardBits& result)
+{
+    result = index.get(WCardIndex::ABILITY, ability);
+}
 
 WCFilterAbility::WCFilterAbility(string arg)
 {
@@ -490,7 +865,13 @@ float WCFilterAbility::filterFee()
 //WCFilterType
 bool WCFilterType::isMatch(MTGCard * c)
 {
-    return c->data->hasType(type.c_str());
+    if (typeId < 0) typeId = MTGAllCards::findType(type);
+    return c->data->hasType(typeId);
+}
+void WCFilterType::match(WCardIndex& index, WCardBits& result)
+{
+    if (typeId < 0) typeId = MTGAllCards::findType(type);
+    result = index.get(WCardIndex::TYPE, typeId);
 }
 string WCFilterType::getCode()
 {
@@ -511,6 +892,27 @@ float WCFilterOR::filterFee()
       return lFee;
     return rFee;
 }
+void WCFilterAND::match(WCardIndex& index, WCardBits& result)
+{
+    WCardBits other;
+    lhs->match(index, result);
+    rhs->match(index, other);
+    result &= other;
+}
+void WCFilterOR::match(WCardIndex& index, WCardBits& result)
+{
+    WCardBits other;
+    lhs->match(index, result);
+    rhs->match(index, other);
+    result |= other;
+}
+void WCFilterNOT::match(WCardIndex& index, WCardBits& result)
+{
+    WCardBits kidMatches;
+    kid->match(index, kidMatches);
+    result = index.all();
+    result -= kidMatches;
+}
 string WCFilterNOT::getCode()
 {
     char buf[4068];
@@ -544,3 +946,36 @@ bool WCFilterOR::isMatch(MTGCard *c)
     return false;
 }
 ;
+
+//WCFilterText
+WCFilterText::WCFilterText(string arg, bool namesOnly) :
+    search(arg), namesOnly(namesOnly)
+{
+    WCardIndex::splitWords(search, words);
+}
+
+bool WCFilterText::isMatch(MTGCard * c)
+{
+    if (!c || !c->data || !words.size()) return false;
+    vector<string> cardWords;
+    WCardIndex::splitWords(c->data->name, cardWords);
+    if (!namesOnly) WCardIndex::splitWords(WCardIndex::getRulesText(c->data), cardWords);
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        size_t j = 0;
+        while (j < cardWords.size() && cardWords[j].find(words[i]) == string::npos)
+            j++;
+        if (j == cardWords.size()) return false;
+    }
+    return true;
+}
+
+void WCFilterText::match(WCardIndex& index, WCardBits& result)
+{
+    index.search(search, namesOnly, result);
+}
+
+string WCFilterText::getCode()
+{
+    return (namesOnly ? "name:" : "text:") + search + ";";
+}
@@ -7,6 +7,14 @@
 
 #define ISGBK(c) ((c) > 0x80 || (c) < 0x30 || (c) == '-' || (c) == '/')
 
+// Glyph cache textures start at 256x256 and are doubled when full, up to this size.
+// The PSP keeps them in VRAM, so it stays at the original size there.
+#if defined (PSP)
+static const int kMaxGlyphCacheImageSize = 256;
+#else
+static const int kMaxGlyphCacheImageSize = 512;
+#endif
+
 static PIXEL_TYPE gencolor(int id, PIXEL_TYPE color)
 {
     unsigned int a, r, g, b, r0, g0, b0;
@@ -154,8 +162,9 @@ WFBFont::WFBFont(int inFontID, const char *fontname, int lineheight, bool) :
 
     mCharBuffer = NULL;
     mSprites = NULL;
-    mGBCode = NULL;
-    mCurr = 0;
+    mTexture = NULL;
+    mRetiredTexture = NULL;
+    mCacheSize = 0;
 
     char tmpFileName[32], engFileName[32];
     strcpy(tmpFileName, fontname);
@@ -195,19 +204,55 @@ WFBFont::WFBFont(int inFontID, const char *fontname, int lineheight, bool) :
     mBytesPerRow = static_cast<unsigned int> (mFontSize / 2);
     mBytesPerChar = static_cast<unsigned int> (mBytesPerRow * mFontSize);
 
-    mCacheImageWidth = 256;
-    mCacheImageHeight = 256;
+#if !defined (PSP)
+    mCharBuffer = NEW PIXEL_TYPE[mFontSize*mFontSize];
+#endif
+
+    InitCache(256, 256);
+}
+
+WFBFont::~WFBFont()
+{
+    SAFE_DELETE_ARRAY(mStdFont);
+    SAFE_DELETE_ARRAY(mExtraFont);
+    SAFE_DELETE(mTexture);
+    SAFE_DELETE(mRetiredTexture);
+
+    if (mSprites)
+    {
+        for (int i = 0; i < mCacheSize; i++)
+        {
+            if (mSprites[i]) delete mSprites[i];
+        }
+        delete[] mSprites;
+    }
+
+    if (NULL != mIndex) delete[] mIndex;
+
+    if (mCharBuffer) delete[] mCharBuffer;
+}
+
+void WFBFont::InitCache(int width, int height)
+{
+    if (mSprites)
+    {
+        for (int i = 0; i < mCacheSize; i++)
+            SAFE_DELETE(mSprites[i]);
+        SAFE_DELETE_ARRAY(mSprites);
+    }
+
+    // The previous texture may still be referenced by quads queued this frame,
+    // so it is only released on the next resize.
+    SAFE_DELETE(mRetiredTexture);
+    mRetiredTexture = mTexture;
+
+    mCacheImageWidth = width;
+    mCacheImageHeight = height;
     mCol = mCacheImageWidth / mFontSize;
     mRow = mCacheImageHeight / mFontSize;
     mCacheSize = mCol * mRow;
 
     mSprites = NEW JQuad*[mCacheSize];
-    mGBCode = NEW int[mCacheSize];
-
-#if !defined (PSP)
-    mCharBuffer = NEW PIXEL_TYPE[mFontSize*mFontSize];
-#endif
-
     mTexture = mRenderer->CreateTexture(mCacheImageWidth, mCacheImageHeight, true);
 
     int index = 0;
@@ -215,35 +260,44 @@ WFBFont::WFBFont(int inFontID, const char *fontname, int lineheight, bool) :
     {
         for (int x = 0; x < mCol; x++)
         {
-            mGBCode[index] = -1;
             mSprites[index] = NEW JQuad(mTexture, static_cast<float> (x * mFontSize), static_cast<float> (y * mFontSize),
                             static_cast<float> (mFontSize), static_cast<float> (mFontSize));
             mSprites[index]->SetHotSpot(static_cast<float> (mFontSize / 2), static_cast<float> (mFontSize / 2));
             index++;
         }
     }
+
+    mGlyphCache.Reset(mCacheSize);
 }
 
-WFBFont::~WFBFont()
+// Returns the cache slot of a glyph code. When the glyph is not cached yet a slot
+// is reserved for it, growing the cache texture if it is full, and isCached is
+// set to false so that the caller rasterizes it.
+int WFBFont::GetCacheSlot(int code, bool& isCached)
 {
-    SAFE_DELETE_ARRAY(mStdFont);
-    SAFE_DELETE_ARRAY(mExtraFont);
-    SAFE_DELETE(mTexture);
+    int index = mGlyphCache.Find(code);
+    isCached = (index != -1);
+    if (isCached)
+        return index;
 
-    if (mSprites)
+    if (mGlyphCache.IsFull() && mCacheImageWidth < kMaxGlyphCacheImageSize)
     {
-        for (int i = 0; i < mCacheSize; i++)
-        {
-            if (mSprites[i]) delete mSprites[i];
-        }
-        delete[] mSprites;
+        InitCache(mCacheImageWidth * 2, mCacheImageHeight * 2);
+        mRenderer->BindTexture(mTexture);
     }
 
-    if (NULL != mIndex) delete[] mIndex;
+    return mGlyphCache.Insert(code);
+}
 
-    if (mGBCode) delete[] mGBCode;
+void WFBFont::NewFrame()
+{
+    mGlyphCache.NewFrame();
+}
 
-    if (mCharBuffer) delete[] mCharBuffer;
+void WFBFont::GetCacheStats(unsigned int *hits, unsigned int *misses) const
+{
+    *hits = mGlyphCache.GetHits();
+    *misses = mGlyphCache.GetMisses();
 }
 
 #if defined (PSP)
@@ -274,13 +328,11 @@ int WFBFont::PreCacheChar(const u8 *ch)
     u8 gray;
 
     code = this->GetCode(ch, &charLength);
-    if (doubleWidthChar(ch) && mIndex) code = mIndex[code]; // mGBCode[] stores the final code.
-
-    if (mGBCode[mCurr] != -1) for (int i = 0; i < mCacheSize; i++)
-        if (mGBCode[i] == code) return i;
+    if (doubleWidthChar(ch) && mIndex) code = mIndex[code]; // the glyph cache stores the final code.
 
-    int index = mCurr++;
-    if (mCurr >= mCacheSize) mCurr = 0;
+    bool isCached;
+    int index = GetCacheSlot(code, isCached);
+    if (isCached) return index;
 
 #if defined (PSP)
     u8* pTexture = (u8*) mTexture->mBits;
@@ -352,8 +404,6 @@ int WFBFont::PreCacheChar(const u8 *ch)
         y++;
     }
 
-    mGBCode[index] = code;
-
 #if defined (PSP)
     sceKernelDcacheWritebackAll();
 #else
@@ -601,8 +651,9 @@ WGBKFont::WGBKFont(int inFontID, const char *fontname, int lineheight, bool) :
 
     mCharBuffer = NULL;
     mSprites = NULL;
-    mGBCode = NULL;
-    mCurr = 0;
+    mTexture = NULL;
+    mRetiredTexture = NULL;
+    mCacheSize = 0;
 
     char tmpFileName[32], engFileName[32];
     strcpy(tmpFileName, fontname);
@@ -635,33 +686,11 @@ WGBKFont::WGBKFont(int inFontID, const char *fontname, int lineheight, bool) :
     mBytesPerRow = static_cast<unsigned int> (mFontSize / 2);
     mBytesPerChar = static_cast<unsigned int> (mBytesPerRow * mFontSize);
 
-    mCacheImageWidth = 256;
-    mCacheImageHeight = 256;
-    mCol = mCacheImageWidth / mFontSize;
-    mRow = mCacheImageHeight / mFontSize;
-    mCacheSize = mCol * mRow;
-
-    mSprites = NEW JQuad*[mCacheSize];
-    mGBCode = NEW int[mCacheSize];
-
 #if !defined (PSP)
     mCharBuffer = NEW PIXEL_TYPE[mFontSize*mFontSize];
 #endif
 
-    mTexture = mRenderer->CreateTexture(mCacheImageWidth, mCacheImageHeight, true);
-
-    int index = 0;
-    for (int y = 0; y < mRow; y++)
-    {
-        for (int x = 0; x < mCol; x++)
-        {
-            mGBCode[index] = -1;
-            mSprites[index] = NEW JQuad(mTexture, static_cast<float> (x * mFontSize), static_cast<float> (y * mFontSize),
-                            static_cast<float> (mFontSize), static_cast<float> (mFontSize));
-            mSprites[index]->SetHotSpot(static_cast<float> (mFontSize / 2), static_cast<float> (mFontSize / 2));
-            index++;
-        }
-    }
+    InitCache(256, 256);
 }
 
 int WGBKFont::PreCacheChar(const u8 *ch)
@@ -674,11 +703,9 @@ int WGBKFont::PreCacheChar(const u8 *ch)
 
     code = this->GetCode(ch, &charLength);
 
-    if (mGBCode[mCurr] != -1) for (int i = 0; i < mCacheSize; i++)
-        if (mGBCode[i] == code) return i;
-
-    int index = mCurr++;
-    if (mCurr >= mCacheSize) mCurr = 0;
+    bool isCached;
+    int index = GetCacheSlot(code, isCached);
+    if (isCached) return index;
 
 #if defined(PSP)
     u8* pTexture = (u8*) mTexture->mBits;
@@ -751,8 +778,6 @@ int WGBKFont::PreCacheChar(const u8 *ch)
         y++;
     }
 
-    mGBCode[index] = code;
-
 #if defined (PSP)
     sceKernelDcacheWritebackAll();
 #else
@@ -3,8 +3,6 @@
 #include "WResourceManagerImpl.h"
 #include "StyleManager.h"
 
-#include "CacheEngine.h"
-
 #if defined (WIN32)
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -29,6 +27,8 @@ namespace
     boost::mutex sLoadFunctionMutex;
 }
 
+#include "CacheEngine.h"
+
 WResourceManager* WResourceManager::sInstance = NULL;
 
 WResourceManager* WResourceManager::Instance()
@@ -105,6 +105,37 @@ void ResourceManagerImpl::DebugRender()
         font->DrawString(debugMessage.c_str(), SCREEN_WIDTH-10,SCREEN_HEIGHT-25,JGETEXT_RIGHT);
 
 #endif
+
+    unsigned int glyphHits = 0;
+    unsigned int glyphMisses = 0;
+    for (FontMap::iterator iter = mWFontMap.begin(); iter != mWFontMap.end(); ++iter)
+    {
+        WFBFont * fbFont = dynamic_cast<WFBFont *> (iter->second);
+        if (!fbFont) continue;
+
+        unsigned int hits, fontMisses;
+        fbFont->GetCacheStats(&hits, &fontMisses);
+        fbFont->NewFrame();
+        glyphHits += hits;
+        glyphMisses += fontMisses;
+    }
+    if (glyphHits || glyphMisses)
+    {
+        sprintf(buf, "Glyphs: %u hits, %u misses", glyphHits, glyphMisses);
+        font->DrawString(buf, 10, 20);
+    }
+
+    PrefetchStats prefetch = GetPrefetchStats();
+    if (prefetch.completed || prefetch.failed)
+    {
+        unsigned int decoded = prefetch.completed + prefetch.failed;
+        sprintf(buf, "Prefetch: %u done, %u failed, %u cancelled, %u demoted, %u dropped, avg wait %lums, avg decode %lums",
+            prefetch.completed, prefetch.failed, prefetch.cancelled, prefetch.demoted, prefetch.dropped,
+            prefetch.totalWaitTime / decoded, prefetch.totalDecodeTime / decoded);
+        font->DrawString(buf, SCREEN_WIDTH - 10, 20, JGETEXT_RIGHT);
+        sprintf(buf, "Queue: %u (max %u), max latency %ums", prefetch.queueDepth, prefetch.maxQueueDepth, prefetch.maxLatency);
+        font->DrawString(buf, SCREEN_WIDTH - 10, 30, JGETEXT_RIGHT);
+    }
 }
 
 unsigned long ResourceManagerImpl::Size()
@@ -255,6 +286,78 @@ JQuadPtr ResourceManagerImpl::RetrieveCard(MTGCard * card, int style, int submod
     return JQuadPtr();
 }
 
+bool ResourceManagerImpl::CardImageRequest(MTGCard * card, int style, string& filename, int& submode, int& lookup)
+{
+    if (!card || options[Options::DISABLECARDS].number) return false;
+
+    std::ostringstream stream;
+    stream << setlist[card->setId] << "/" << card->getImageName();
+    filename = stream.str();
+
+    submode = TEXTURE_SUB_CARD | TEXTURE_SUB_5551;
+    if (style == RETRIEVE_THUMB)
+        submode = submode | TEXTURE_SUB_THUMB;
+
+    lookup = textureWCache.makeID(card->getMTGId(), filename, submode);
+    return true;
+}
+
+void ResourceManagerImpl::PrefetchCard(MTGCard * card, int priority, int style)
+{
+    if (!CacheEngine::IsThreaded())
+    {
+        // no worker to do it in the background: only load what is about to be shown anyway
+        if (priority >= PREFETCH_HIGH)
+            RetrieveCard(card, style);
+        return;
+    }
+
+    string filename;
+    int submode, lookup;
+    if (!CardImageRequest(card, style, filename, submode, lookup)) return;
+
+    CacheEngine::Instance()->QueueRequest(filename, submode, lookup, priority);
+}
+
+void ResourceManagerImpl::CancelPrefetch(MTGCard * card, int style)
+{
+    string filename;
+    int submode, lookup;
+    if (!CardImageRequest(card, style, filename, submode, lookup)) return;
+
+    CacheEngine::Instance()->CancelRequest(lookup);
+}
+
+void ResourceManagerImpl::CancelPrefetches(int belowPriority)
+{
+    CacheEngine::Instance()->CancelRequests(belowPriority);
+}
+
+PrefetchStats ResourceManagerImpl::GetPrefetchStats()
+{
+    return CacheEngine::Instance()->GetStats();
+}
+
+void ResourceManagerImpl::FlushDecodedTextures()
+{
+    // bounded, so that a burst of decodes doesn't stall a single frame
+    const unsigned int kMaxUploadsPerFrame = 16;
+
+    std::vector<int> decoded;
+    CacheEngine::Instance()->TakeDecoded(decoded, kMaxUploadsPerFrame);
+    if (decoded.empty()) return;
+
+    JRenderer* renderer = JRenderer::GetInstance();
+    boost::mutex::scoped_lock lock(sCacheMutex);
+    for (size_t i = 0; i < decoded.size(); ++i)
+    {
+        // might have been evicted since
+        map<int, WCachedTexture*>::iterator it = textureWCache.cache.find(decoded[i]);
+        if (it != textureWCache.cache.end() && it->second && it->second->texture)
+            renderer->TransferTextureToGLContext(*it->second->texture);
+    }
+}
+
 int ResourceManagerImpl::AddQuadToManaged(const WManagedQuad& inQuad)
 {
     int id = mIDLookupMap.size();
@@ -1211,6 +1314,20 @@ cacheItem* WCache<cacheItem, cacheActual>::LoadIntoCache(int id, const string& f
     // JFileSystem is particularly unsafe, as it assumes that we have only one zip loaded at a time... rather than add mutexes in JGE,
     // I've kept it local to here.
     boost::mutex::scoped_lock functionLock(sLoadFunctionMutex);
+
+    // the same id may have been queued for a prefetch and requested synchronously: whoever got
+    // here second finds the item already loaded and must not decode (and leak) a second copy.
+    if (style != RETRIEVE_MANAGE)
+    {
+        boost::mutex::scoped_lock lock(sCacheMutex);
+        typename map<int, cacheItem*>::iterator it = cache.find(id);
+        if (it != cache.end() && it->second)
+        {
+            mError = CACHE_ERROR_NONE;
+            return it->second;
+        }
+    }
+
     cacheItem* item = AttemptNew(filename, submode);
     //assert(item);
     if (style == RETRIEVE_MANAGE)
@@ -1266,6 +1383,33 @@ cacheItem* WCache<cacheItem, cacheActual>::LoadIntoCache(int id, const string& f
     return item;
 }
 
+template<class cacheItem, class cacheActual>
+cacheItem* WCache<cacheItem, cacheActual>::InsertIntoCache(int id, cacheItem* item)
+{
+    boost::mutex::scoped_lock lock(sCacheMutex);
+    typename map<int, cacheItem*>::iterator it = cache.find(id);
+    if (it != cache.end() && it->second)
+    {
+        SAFE_DELETE(item);
+        return it->second;
+    }
+
+    cache[id] = item;
+
+    unsigned long isize = item->size();
+    totalSize += isize;
+    cacheItems++;
+    cacheSize += isize;
+
+#ifdef DEBUG_CACHE
+    std::ostringstream stream;
+    stream << "Cache insert: " << item->mFilename << " " << id << ", cacheItem count: " << cacheItems << ", cacheSize is now: " << cacheSize;
+    LOG(stream.str().c_str());
+#endif
+
+    return item;
+}
+
 template<class cacheItem, class cacheActual>
 void WCache<cacheItem, cacheActual>::Refresh()
 {
@@ -301,9 +301,8 @@ std::vector<std::string> parseBetween(const std::string& s, string start, string
 // This is a customized word wrap based on pixel width.  It tries it's best 
 // to wrap strings using spaces as delimiters.  
 // Not sure how this translates into non-english fonts.
-std::string wordWrap(const std::string& sentence, float width, int fontId)
+static std::string wordWrapUncached(const std::string& sentence, float width, WFont * mFont)
 {
-    WFont * mFont = WResourceManager::Instance()->GetWFont(fontId);
     float lineWidth = mFont->GetStringWidth( sentence.c_str() );
     string retVal = sentence;
     if ( lineWidth < width ) return sentence;
@@ -350,6 +349,52 @@ std::string wordWrap(const std::string& sentence, float width, int fontId)
     return retVal;
 }
 
+// Menus wrap the same descriptions every frame, so the wrapped layouts are kept
+// around, keyed by everything the line breaks depend on.
+namespace
+{
+    struct WrapKey
+    {
+        std::string text;
+        int fontId;
+        float width;
+        float scale;
+
+        bool operator<(const WrapKey& other) const
+        {
+            if (fontId != other.fontId) return fontId < other.fontId;
+            if (width != other.width) return width < other.width;
+            if (scale != other.scale) return scale < other.scale;
+            return text < other.text;
+        }
+    };
+
+    const size_t kMaxWrapCacheSize = 128;
+    std::map<WrapKey, std::string> wrapCache;
+}
+
+const std::string& wordWrap(const std::string& sentence, float width, int fontId)
+{
+    WFont * mFont = WResourceManager::Instance()->GetWFont(fontId);
+
+    WrapKey key;
+    key.text = sentence;
+    key.fontId = fontId;
+    key.width = width;
+    key.scale = mFont->GetScale();
+
+    std::map<WrapKey, std::string>::iterator it = wrapCache.find(key);
+    if (it != wrapCache.end())
+        return it->second;
+
+    if (wrapCache.size() >= kMaxWrapCacheSize)
+        wrapCache.clear();
+
+    std::string& result = wrapCache[key];
+    result = wordWrapUncached(sentence, width, mFont);
+    return result;
+}
+
 
 unsigned long hash_djb2(const char *str)
 {
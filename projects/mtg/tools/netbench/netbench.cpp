@@ -0,0 +1,134 @@
+/*
+ Loopback benchmark of the JNetwork transport: start "netbench server" in one terminal,
+ then "netbench client 127.0.0.1" in another one.
+
+ The client first measures round trips one command at a time, then the throughput of
+ commands sent back to back; the server echoes every command.
+ */
+#include <JNetwork.h>
+
+#include <sched.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    long long now()
+    {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+    }
+
+    int sResponses = 0;
+    std::vector<long long> sLatencies;
+
+    void echo(void*, stringstream& in, stringstream& out)
+    {
+        out << in.str();
+    }
+
+    void received(void*, stringstream& in, stringstream&)
+    {
+        long long sent = 0;
+        in >> sent;
+        sLatencies.push_back(now() - sent);
+        sResponses++;
+    }
+
+    // the game calls Update() once a frame, here it is polled as fast as possible without starving the
+    // network threads on a single core
+    void poll(JNetwork& network)
+    {
+        network.Update();
+        sched_yield();
+    }
+
+    void waitForResponses(JNetwork& network, int count)
+    {
+        while (sResponses < count && network.isConnected())
+            poll(network);
+    }
+
+    string payload(int size)
+    {
+        char stamp[32];
+        sprintf(stamp, "%lld ", now());
+        string s = stamp;
+        if ((int) s.size() < size)
+            s.append(size - s.size(), 'x');
+        return s;
+    }
+
+    void report(const char* title, std::vector<long long> latencies)
+    {
+        if (latencies.empty())
+            return;
+        std::sort(latencies.begin(), latencies.end());
+        long long total = 0;
+        for (size_t i = 0; i < latencies.size(); i++)
+            total += latencies[i];
+        printf("%s: %d round trips, avg %lldus, p50 %lldus, p99 %lldus, max %lldus\n", title, (int) latencies.size(),
+               total / (long long) latencies.size(), latencies[latencies.size() / 2],
+               latencies[latencies.size() * 99 / 100], latencies.back());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || (string(argv[1]) == "client" && argc < 3))
+    {
+        printf("usage: %s server\n       %s client <server ip> [count] [payload size]\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    JNetwork::registerCommand("bench", NULL, echo, received);
+    JNetwork network;
+
+    if (string(argv[1]) == "server")
+    {
+        network.connect();
+        while (!network.isConnected())
+            usleep(1000);
+        printf("client connected\n");
+        fflush(stdout);
+        while (network.isConnected())
+            poll(network);
+        printf("%lu commands echoed, %lu bytes received\n", network.framesReceived, network.bytesReceived);
+        return 0;
+    }
+
+    int count = argc > 3 ? atoi(argv[3]) : 10000;
+    int size = argc > 4 ? atoi(argv[4]) : 64;
+
+    network.connect(argv[2]);
+    for (int i = 0; i < 5000 && !network.isConnected(); i++)
+        usleep(1000);
+    if (!network.isConnected())
+    {
+        printf("could not connect to %s\n", argv[2]);
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        network.sendCommand("bench", payload(size));
+        waitForResponses(network, i + 1);
+    }
+    report("ping-pong", sLatencies);
+
+    sLatencies.clear();
+    sResponses = 0;
+    long long start = now();
+    for (int i = 0; i < count; i++)
+        network.sendCommand("bench", payload(size));
+    waitForResponses(network, count);
+    long long elapsed = now() - start;
+    report("pipelined", sLatencies);
+    printf("pipelined: %.0f commands/s, %d byte payloads\n", count * 1000000.0 / (elapsed ? elapsed : 1), size);
+    return 0;
+}
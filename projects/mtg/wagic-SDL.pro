@@ -50,6 +50,7 @@ SOURCES += \
         src/ActionLayer.cpp\
         src/ActionStack.cpp\
         src/AIHints.cpp\
+        src/AIProfiler.cpp\
         src/AIMomirPlayer.cpp\
         src/AIPlayer.cpp\
 		src/AIPlayerBaka.cpp\
@@ -74,6 +75,7 @@ SOURCES += \
         src/DeckMenuItem.cpp\
         src/DeckMetaData.cpp\
         src/DeckStats.cpp\
+        src/GoldfishSimulator.cpp\
         src/DuelLayers.cpp\
         src/Effects.cpp\
         src/ExtraCost.cpp\
@@ -105,6 +107,7 @@ SOURCES += \
         src/ManaCost.cpp\
         src/ManaCostHybrid.cpp\
         src/MenuItem.cpp\
+        src/MemoryPool.cpp\
         src/ModRules.cpp\
         src/MTGAbility.cpp\
         src/MTGCard.cpp\
@@ -168,6 +171,7 @@ HEADERS  += \
         include/ActionElement.h\
         include/GameObserver.h\
         include/MenuItem.h\
+        include/MemoryPool.h\
         include/StoryFlow.h\
         include/ActionLayer.h\
         include/GameOptions.h\
@@ -247,6 +251,7 @@ HEADERS  += \
         include/ReplacementEffects.h\
         include/WGui.h\
         include/DeckStats.h\
+        include/GoldfishSimulator.h\
         include/GuiPlay.h\
         include/Rules.h\
         include/WResourceManager.h\
@@ -265,6 +270,7 @@ HEADERS  += \
         include/NetworkPlayer.h\
         include/ModRules.h\
         include/AIHints.h\
+        include/AIProfiler.h\
 
 # JGE, could probably be moved outside
 SOURCES += \
@@ -60,6 +60,7 @@ SOURCES += \
         src/ActionLayer.cpp\
         src/ActionStack.cpp\
         src/AIHints.cpp\
+        src/AIProfiler.cpp\
         src/AIMomirPlayer.cpp\
         src/AIPlayer.cpp\
         src/AIPlayerBaka.cpp\
@@ -83,6 +84,7 @@ SOURCES += \
         src/DeckMenuItem.cpp\
         src/DeckMetaData.cpp\
         src/DeckStats.cpp\
+        src/GoldfishSimulator.cpp\
         src/DuelLayers.cpp\
         src/Effects.cpp\
         src/ExtraCost.cpp\
@@ -115,6 +117,7 @@ SOURCES += \
         src/ManaCost.cpp\
         src/ManaCostHybrid.cpp\
         src/MenuItem.cpp\
+        src/MemoryPool.cpp\
         src/ModRules.cpp\
         src/MTGAbility.cpp\
         src/MTGCard.cpp\
@@ -176,6 +179,7 @@ HEADERS  += \
         include/PlayRestrictions.h\
         include/ModRules.h\
         include/AIHints.h\
+        include/AIProfiler.h\
         include/AIPlayerBaka.h\
         include/AIPlayerBakaB.h\
         include/DeckEditorMenu.h\
@@ -191,6 +195,7 @@ HEADERS  += \
         include/ActionElement.h\
         include/GameObserver.h\
         include/MenuItem.h\
+        include/MemoryPool.h\
         include/StoryFlow.h\
         include/ActionLayer.h\
         include/GameOptions.h\
@@ -269,6 +274,7 @@ HEADERS  += \
         include/ReplacementEffects.h\
         include/WGui.h\
         include/DeckStats.h\
+        include/GoldfishSimulator.h\
         include/GuiPlay.h\
         include/Rules.h\
         include/WResourceManager.h\